@@ -0,0 +1,224 @@
+#include "Analyzer.h"
+
+namespace Dsp {
+
+Analyzer::Analyzer()
+    : Thread ("Inflation analyzer"),
+      inputFifo ((size_t) fifoSize), outputFifo ((size_t) fifoSize),
+      inputHistory ((size_t) fftSize), outputHistory ((size_t) fftSize), fftData ((size_t) fftSize * 2),
+      inputLevels ((size_t) numPoints), outputLevels ((size_t) numPoints),
+      pointStart ((size_t) numPoints), pointEnd ((size_t) numPoints)
+{
+    for (auto* frame : { &working, &latest })
+        for (auto* path : { &frame->inputSpectrum, &frame->outputSpectrum, &frame->transferCurve })
+            path->preallocateSpace (3 * jmax (numPoints, numCurvePoints) + 3);
+}
+
+Analyzer::~Analyzer()
+{
+    active = false;
+    stopThread (1000);
+}
+
+//==============================================================================
+void Analyzer::addViewer()
+{
+    if (numViewers++ == 0)
+    {
+        active = true;
+        startThread (Priority::low);
+    }
+}
+
+void Analyzer::removeViewer()
+{
+    jassert (numViewers > 0);
+
+    if (--numViewers == 0)
+    {
+        // the audio thread stops pushing first, then the thread is woken to leave
+        active = false;
+        stopThread (1000);
+    }
+}
+
+bool Analyzer::getLatestFrame (AnalyzerFrame& frame)
+{
+    const ScopedLock lock (frameLock);
+
+    if (latest.number == frame.number)
+        return false;
+
+    frame = latest;
+    return true;
+}
+
+//==============================================================================
+void Analyzer::run()
+{
+    // whatever is left from the last time an editor was open is stale
+    fifo.finishedRead (fifo.getNumReady());
+    std::fill (inputHistory.begin(), inputHistory.end(), 0.0f);
+    std::fill (outputHistory.begin(), outputHistory.end(), 0.0f);
+    std::fill (inputLevels.begin(), inputLevels.end(), 0.0f);
+    std::fill (outputLevels.begin(), outputLevels.end(), 0.0f);
+    historyPosition = 0;
+
+    auto lastCurve = std::numeric_limits<float>::quiet_NaN();
+    auto lastClip = false;
+
+    while (! threadShouldExit())
+    {
+        const auto sampleRate = rate.load (std::memory_order_relaxed);
+
+        if (sampleRate != layoutRate)
+            updateLayout (sampleRate);
+
+        const auto hasAudio = fifo.getNumReady() > 0;
+        const auto curve = shapeCurve.load (std::memory_order_relaxed);
+        const auto clip = shapeClip.load (std::memory_order_relaxed);
+
+        // nothing new when the host stopped calling back and the settings stayed put
+        if (hasAudio || curve != lastCurve || clip != lastClip)
+        {
+            readFifo();
+            buildSpectrum (inputHistory, inputLevels, working.inputSpectrum);
+            buildSpectrum (outputHistory, outputLevels, working.outputSpectrum);
+            buildTransferCurve (working.transferCurve, curve, clip);
+            lastCurve = curve;
+            lastClip = clip;
+
+            // the editor gets the new paths, the thread reuses the old ones' storage
+            const ScopedLock lock (frameLock);
+            working.number = latest.number + 1;
+            std::swap (working, latest);
+        }
+
+        wait (frameIntervalMs);
+    }
+}
+
+// appends everything that arrived to the histories, of which the newest fftSize samples are kept
+void Analyzer::readFifo()
+{
+    const auto scope = fifo.read (fifo.getNumReady());
+
+    auto append = [this] (int start, int size)
+    {
+        // more than a window's worth at once, only its end matters
+        const auto skip = jmax (0, size - fftSize);
+        start += skip;
+        size -= skip;
+
+        while (size > 0)
+        {
+            const auto length = jmin (size, fftSize - historyPosition);
+            std::copy_n (inputFifo.data() + start, length, inputHistory.data() + historyPosition);
+            std::copy_n (outputFifo.data() + start, length, outputHistory.data() + historyPosition);
+
+            historyPosition = (historyPosition + length) % fftSize;
+            start += length;
+            size -= length;
+        }
+    };
+
+    append (scope.startIndex1, scope.blockSize1);
+    append (scope.startIndex2, scope.blockSize2);
+}
+
+// each point of the log axis covers the bins between the geometric midpoints to its neighbours
+void Analyzer::updateLayout (double sampleRate)
+{
+    const auto ratio = maxFrequency / minFrequency;
+    const auto binsPerHertz = fftSize / sampleRate;
+    const auto halfStep = std::pow (ratio, 0.5 / (numPoints - 1));
+
+    numValidPoints = 0;
+
+    for (auto i = 0; i < numPoints; ++i)
+    {
+        const auto frequency = minFrequency * std::pow (ratio, (double) i / (numPoints - 1));
+
+        if (frequency < sampleRate / 2)
+            numValidPoints = i + 1;
+
+        pointStart[(size_t) i] = (float) (frequency / halfStep * binsPerHertz);
+        pointEnd[(size_t) i] = (float) (frequency * halfStep * binsPerHertz);
+    }
+
+    std::fill (inputLevels.begin(), inputLevels.end(), 0.0f);
+    std::fill (outputLevels.begin(), outputLevels.end(), 0.0f);
+    layoutRate = sampleRate;
+}
+
+void Analyzer::buildSpectrum (const std::vector<float>& history, std::vector<float>& levels, Path& path)
+{
+    // oldest sample first, then the window; the second half is the FFT's work space
+    auto* data = fftData.data();
+    std::copy (history.begin() + historyPosition, history.end(), data);
+    std::copy (history.begin(), history.begin() + historyPosition, data + fftSize - historyPosition);
+    std::fill (data + fftSize, data + 2 * fftSize, 0.0f);
+
+    window.multiplyWithWindowingTable (data, (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform (data, true);
+
+    // the window is normalised, so a full scale sine reads fftSize / 2
+    const auto scale = 2.0f / (float) fftSize;
+    const auto lastBin = fftSize / 2;
+    const auto smoothing = 0.3f;
+
+    path.clear();
+
+    for (auto i = 0; i < numValidPoints; ++i)
+    {
+        const auto start = pointStart[(size_t) i], end = pointEnd[(size_t) i];
+        auto magnitude = 0.0f;
+
+        // below a bin per point, interpolate at the centre; above, take the loudest bin
+        if (end - start < 1.0f)
+        {
+            const auto centre = jmin ((float) lastBin - 1.0f, (start + end) * 0.5f);
+            const auto bin = (int) centre;
+            magnitude = jmap (centre - (float) bin, data[bin], data[bin + 1]);
+        }
+        else
+        {
+            for (auto bin = (int) std::ceil (start); bin <= jmin (lastBin, (int) end); ++bin)
+                magnitude = jmax (magnitude, data[bin]);
+        }
+
+        auto& level = levels[(size_t) i];
+        level += (magnitude * scale - level) * smoothing;
+
+        const auto x = (float) i / (float) (numPoints - 1);
+        const auto y = jlimit (0.0f, 1.0f, Decibels::gainToDecibels (level, floorDecibels) / floorDecibels);
+
+        if (i == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+}
+
+// the clip and polynomial the shaping stage applies, see ShaperCoefficients
+void Analyzer::buildTransferCurve (Path& path, float curve, bool zeroClip) const
+{
+    const auto coefficients = ShaperCoefficients<double>::fromCurve (curve);
+
+    path.clear();
+
+    for (auto i = 0; i < numCurvePoints; ++i)
+    {
+        const auto position = (double) i / (numCurvePoints - 1);
+        const auto x = curveRange * (2.0 * position - 1.0);
+        const auto y = coefficients.apply (zeroClip ? jlimit (-1.0, 1.0, x) : x);
+        const auto point = Point<float> ((float) position, (float) ((curveRange - jlimit (-curveRange, curveRange, y)) / (2.0 * curveRange)));
+
+        if (i == 0)
+            path.startNewSubPath (point);
+        else
+            path.lineTo (point);
+    }
+}
+
+}
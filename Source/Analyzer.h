@@ -0,0 +1,162 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "WaveShaper.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /** One picture of the analysis, ready to draw. Every path lies in the unit square, x
+        from 0 to 1 left to right and y from 0 at the top to 1 at the bottom, so the editor
+        only has to scale it to its bounds. */
+    struct AnalyzerFrame
+    {
+        Path inputSpectrum, outputSpectrum;     // 20 Hz to 20 kHz on a log axis, 0 dB at the top
+        Path transferCurve;                     // f(x) for x and f(x) from -curveRange to curveRange
+        uint32 number = 0;                      // counts up with every frame published
+    };
+
+    //==============================================================================
+    /*  Input and output spectrum and the wave shaper's transfer curve, for the editor.
+
+        While an editor is open, the audio thread mixes each block down to mono on the way
+        in and on the way out and pushes both into a lock-free FIFO; a block that doesn't
+        fit is dropped, the audio thread never waits. Everything else happens on the
+        analyzer's own thread, about 30 times a second: it reads what arrived, windows the
+        newest fftSize samples of each signal, runs the FFT, gathers the bins onto a log
+        frequency axis, smooths them over time and builds the paths.
+
+        The thread only runs while at least one editor looks at it.
+    */
+    class Analyzer : private Thread
+    {
+    public:
+        static constexpr int fftOrder = 12;
+        static constexpr int fftSize = 1 << fftOrder;
+        static constexpr int numPoints = 256;               // along the frequency axis
+        static constexpr int numCurvePoints = 129;
+        static constexpr double minFrequency = 20.0, maxFrequency = 20000.0;
+        static constexpr float floorDecibels = -90.0f;      // the bottom of the spectrum
+        static constexpr double curveRange = 1.5;
+
+        Analyzer();
+        ~Analyzer() override;
+
+        /** Lays out the frequency axis for the sample rate. Call from prepareToPlay. */
+        void prepare (double sampleRate) noexcept   { rate.store (sampleRate, std::memory_order_relaxed); }
+
+        //==============================================================================
+        /** Message thread: an editor started or stopped showing the analysis. */
+        void addViewer();
+        void removeViewer();
+
+        /** Audio thread: the block as it came in, before any processing. Nothing happens
+            while no editor is open, or when the FIFO has no room for the block. */
+        template <typename SampleType>
+        void pushInput (const AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+        /** Audio thread: the same block as it goes out, only taken if its input was. */
+        template <typename SampleType>
+        void pushOutput (const AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+        /** Audio thread: the Curve and 0 dB Clip settings the transfer curve is drawn for. */
+        void setShape (float curve, bool zeroClip) noexcept
+        {
+            shapeCurve.store (curve, std::memory_order_relaxed);
+            shapeClip.store (zeroClip, std::memory_order_relaxed);
+        }
+
+        //==============================================================================
+        /** Message thread: copies the newest frame into frame, if it is a newer one.
+            Returns whether it was. */
+        bool getLatestFrame (AnalyzerFrame& frame);
+
+    private:
+        static constexpr int fifoSize = 1 << 15;
+        static constexpr int frameIntervalMs = 33;
+
+        void run() override;
+        void readFifo();
+        void updateLayout (double sampleRate);
+        void buildSpectrum (const std::vector<float>& history, std::vector<float>& levels, Path& path);
+        void buildTransferCurve (Path& path, float curve, bool zeroClip) const;
+
+        // mixed down to mono by averaging, and to float on the way
+        template <typename SampleType>
+        static void mixDown (const SampleType* const* channels, int numChannels, int offset,
+                             float* destination, int numSamples) noexcept
+        {
+            const auto scale = 1.0f / static_cast<float> (numChannels);
+
+            for (auto i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<float> (channels[0][offset + i]) * scale;
+
+            for (auto channel = 1; channel < numChannels; ++channel)
+                for (auto i = 0; i < numSamples; ++i)
+                    destination[i] += static_cast<float> (channels[channel][offset + i]) * scale;
+        }
+
+        // the audio thread's side
+        AbstractFifo fifo { fifoSize };
+        std::vector<float> inputFifo, outputFifo;
+        std::atomic<bool> active { false };
+        bool blockTaken = false;
+        std::atomic<double> rate { 44100.0 };
+        std::atomic<float> shapeCurve { 0.0f };
+        std::atomic<bool> shapeClip { true };
+
+        // the analysis thread's side
+        dsp::FFT fft { fftOrder };
+        dsp::WindowingFunction<float> window { (size_t) fftSize, dsp::WindowingFunction<float>::hann };
+        std::vector<float> inputHistory, outputHistory, fftData;
+        std::vector<float> inputLevels, outputLevels;
+        std::vector<float> pointStart, pointEnd;            // each point's edges in FFT bins
+        int historyPosition = 0, numValidPoints = 0;
+        double layoutRate = 0.0;
+        AnalyzerFrame working;
+
+        // the hand over to the editor
+        CriticalSection frameLock;
+        AnalyzerFrame latest;
+
+        int numViewers = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Analyzer)
+    };
+
+    template <typename SampleType>
+    void Analyzer::pushInput (const AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+    {
+        const auto numSamples = buffer.getNumSamples();
+        blockTaken = active.load (std::memory_order_relaxed) && numChannels > 0 && fifo.getFreeSpace() >= numSamples;
+
+        if (! blockTaken)
+            return;
+
+        // reserved, but not handed over until the output is in too
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        const auto* const* channels = buffer.getArrayOfReadPointers();
+        mixDown (channels, numChannels, 0, inputFifo.data() + start1, size1);
+        mixDown (channels, numChannels, size1, inputFifo.data() + start2, size2);
+    }
+
+    template <typename SampleType>
+    void Analyzer::pushOutput (const AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+    {
+        if (! blockTaken)
+            return;
+
+        const auto numSamples = buffer.getNumSamples();
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        const auto* const* channels = buffer.getArrayOfReadPointers();
+        mixDown (channels, numChannels, 0, outputFifo.data() + start1, size1);
+        mixDown (channels, numChannels, size1, outputFifo.data() + start2, size2);
+
+        fifo.finishedWrite (size1 + size2);
+        blockTaken = false;
+    }
+}
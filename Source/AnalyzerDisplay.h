@@ -0,0 +1,93 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Analyzer.h"
+
+namespace Gui {
+
+    //==============================================================================
+    /*  The analyzer's transfer curve in a square on the left, the input and output
+        spectrum to the right of it. The paths arrive ready made from the analyzer's
+        thread; this only scales them to the bounds, and repaints when a new frame came in.
+    */
+    class AnalyzerDisplay : public Component
+    {
+    public:
+        explicit AnalyzerDisplay (Dsp::Analyzer& analyzerToShow)
+            : analyzer (analyzerToShow)
+        {
+            setOpaque (true);
+            analyzer.addViewer();
+        }
+
+        ~AnalyzerDisplay() override
+        {
+            analyzer.removeViewer();
+        }
+
+        /** Takes the newest frame, if there is one. Called on every display refresh. */
+        void update()
+        {
+            if (analyzer.getLatestFrame (frame))
+                repaint();
+        }
+
+        void paint (Graphics& g) override
+        {
+            g.fillAll (Colours::black);
+
+            const auto curveArea = getCurveArea(), spectrumArea = getSpectrumArea();
+            g.setColour (Colours::white.withAlpha (0.15f));
+
+            // unity and the clip points, x = ±1 and f(x) = ±1
+            for (auto value : { -1.0, 0.0, 1.0 })
+            {
+                const auto position = (float) ((value + Dsp::Analyzer::curveRange) / (2.0 * Dsp::Analyzer::curveRange));
+                g.drawVerticalLine (roundToInt (curveArea.getX() + position * curveArea.getWidth()), curveArea.getY(), curveArea.getBottom());
+                g.drawHorizontalLine (roundToInt (curveArea.getBottom() - position * curveArea.getHeight()), curveArea.getX(), curveArea.getRight());
+            }
+
+            // decades and 30 dB steps
+            for (auto frequency : { 100.0, 1000.0, 10000.0 })
+            {
+                const auto position = std::log (frequency / Dsp::Analyzer::minFrequency)
+                                        / std::log (Dsp::Analyzer::maxFrequency / Dsp::Analyzer::minFrequency);
+                g.drawVerticalLine (roundToInt (spectrumArea.getX() + (float) position * spectrumArea.getWidth()),
+                                    spectrumArea.getY(), spectrumArea.getBottom());
+            }
+
+            for (auto decibels : { -30.0f, -60.0f })
+                g.drawHorizontalLine (roundToInt (spectrumArea.getY() + decibels / Dsp::Analyzer::floorDecibels * spectrumArea.getHeight()),
+                                      spectrumArea.getX(), spectrumArea.getRight());
+
+            g.setColour (Colours::grey);
+            g.strokePath (frame.inputSpectrum, PathStrokeType (1.0f), toArea (spectrumArea));
+
+            g.setColour (Colours::orange);
+            g.strokePath (frame.outputSpectrum, PathStrokeType (1.5f), toArea (spectrumArea));
+            g.strokePath (frame.transferCurve, PathStrokeType (1.5f), toArea (curveArea));
+        }
+
+    private:
+        Rectangle<float> getCurveArea() const
+        {
+            return getLocalBounds().toFloat().reduced (4.0f).removeFromLeft ((float) getHeight() - 8.0f);
+        }
+
+        Rectangle<float> getSpectrumArea() const
+        {
+            return getLocalBounds().toFloat().reduced (4.0f).withTrimmedLeft ((float) getHeight());
+        }
+
+        // the paths are in the unit square
+        static AffineTransform toArea (Rectangle<float> area)
+        {
+            return AffineTransform::scale (area.getWidth(), area.getHeight()).translated (area.getX(), area.getY());
+        }
+
+        Dsp::Analyzer& analyzer;
+        Dsp::AnalyzerFrame frame;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyzerDisplay)
+    };
+}
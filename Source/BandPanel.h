@@ -0,0 +1,116 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+namespace Gui {
+
+    //==============================================================================
+    /*  Band Split's controls in one row: the band count, then every band's curve offset
+        and clip with the crossover between each pair of neighbours. Only the bands in
+        use are shown, and the row is dimmed while Band Split is off.
+    */
+    class BandPanel : public Component
+    {
+    public:
+        explicit BandPanel (AudioProcessorValueTreeState& state)
+            : bandSplit (*state.getRawParameterValue ("bandSplit")),
+              numBands (*state.getRawParameterValue ("bands"))
+        {
+            for (auto i = 2; i <= Dsp::maxBands; ++i)
+                bandsBox.addItem (String (i) + " bands", i - 1);
+
+            addAndMakeVisible (bandsBox);
+            bandsAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment> (state, "bands", bandsBox);
+
+            for (auto i = 0; i < Dsp::maxCrossovers; ++i)
+            {
+                auto* slider = crossoverSliders.add (makeKnob (0, " Hz"));
+                attachments.add (new AudioProcessorValueTreeState::SliderAttachment (state, Dsp::parameterIds[Dsp::firstCrossoverParameter + i], *slider));
+            }
+
+            for (auto i = 0; i < Dsp::maxBands; ++i)
+            {
+                auto* slider = curveSliders.add (makeKnob (1, {}));
+                slider->setDoubleClickReturnValue (true, 0.0);
+                attachments.add (new AudioProcessorValueTreeState::SliderAttachment (state, Dsp::parameterIds[Dsp::firstBandCurveParameter + i], *slider));
+
+                auto* button = clipButtons.add (new ToggleButton ("Clip"));
+                addChildComponent (button);
+                buttonAttachments.add (new AudioProcessorValueTreeState::ButtonAttachment (state, Dsp::parameterIds[Dsp::firstBandClipParameter + i], *button));
+            }
+        }
+
+        /** Follows the band count and Band Split. Called on every display refresh. */
+        void update()
+        {
+            const auto bands = jlimit (2, Dsp::maxBands, roundToInt (numBands.load (std::memory_order_relaxed)));
+            const auto active = bandSplit.load (std::memory_order_relaxed) >= 0.5f;
+
+            if (bands != shownBands)
+            {
+                shownBands = bands;
+                resized();
+            }
+
+            setAlpha (active ? 1.0f : 0.4f);
+        }
+
+        void resized() override
+        {
+            auto bounds = getLocalBounds();
+            bandsBox.setBounds (bounds.removeFromLeft (100).withSizeKeepingCentre (90, 24));
+
+            // band, crossover, band, ... evenly across the rest
+            const auto columnWidth = bounds.getWidth() / (2 * shownBands - 1);
+
+            for (auto i = 0; i < Dsp::maxBands; ++i)
+            {
+                const auto showBand = i < shownBands, showCrossover = i < shownBands - 1;
+                curveSliders[i]->setVisible (showBand);
+                clipButtons[i]->setVisible (showBand);
+
+                if (showBand)
+                {
+                    auto column = bounds.removeFromLeft (columnWidth);
+                    clipButtons[i]->setBounds (column.removeFromBottom (20).withSizeKeepingCentre (jmin (60, column.getWidth()), 20));
+                    curveSliders[i]->setBounds (column);
+                }
+
+                if (i < Dsp::maxCrossovers)
+                {
+                    crossoverSliders[i]->setVisible (showCrossover);
+
+                    if (showCrossover)
+                        crossoverSliders[i]->setBounds (bounds.removeFromLeft (columnWidth).withTrimmedBottom (20));
+                }
+            }
+        }
+
+    private:
+        Slider* makeKnob (int decimalPlaces, const String& suffix)
+        {
+            auto* slider = new Slider (Slider::RotaryHorizontalVerticalDrag, Slider::TextBoxBelow);
+            slider->setTextBoxStyle (Slider::TextBoxBelow, false, 70, 16);
+            slider->setNumDecimalPlacesToDisplay (decimalPlaces);
+            slider->setTextValueSuffix (suffix);
+            addChildComponent (slider);
+            return slider;
+        }
+
+        std::atomic<float>& bandSplit;
+        std::atomic<float>& numBands;
+        int shownBands = 0;
+
+        ComboBox bandsBox;
+        OwnedArray<Slider> crossoverSliders, curveSliders;
+        OwnedArray<ToggleButton> clipButtons;
+
+        // after the controls, so they are let go of first
+        std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> bandsAttachment;
+        OwnedArray<AudioProcessorValueTreeState::SliderAttachment> attachments;
+        OwnedArray<AudioProcessorValueTreeState::ButtonAttachment> buttonAttachments;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandPanel)
+    };
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  How long each audio device callback took, for the low latency standalone.
+
+        Each callback's time is counted into a histogram of its share of the period, in
+        0.5% bins up to twice the period, which the percentiles are read back from. A
+        callback that starts more than one and a half periods after the one before it is
+        counted as late: that is a period the device played without us, whether or not
+        the driver counts it as an xrun.
+
+        As with the profiler, the audio thread only adds to relaxed atomics, so any thread
+        can take a Snapshot or reset the counters without locking it out.
+    */
+    class CallbackMonitor
+    {
+    public:
+        static constexpr int numBins = 401;                 // the last is everything over twice the period
+        static constexpr double binWidth = 0.005;           // of the period
+        static constexpr double lateInterval = 1.5;         // periods between two callbacks' starts
+
+        struct Snapshot
+        {
+            std::array<uint64, numBins> histogram {};
+            uint64 callbacks = 0, overBudget = 0, late = 0;
+            double worstLoad = 0.0;                         // the slowest callback's time over its period
+            double periodSeconds = 0.0;
+
+            /** The load that the given fraction of callbacks stayed at or under, to within a bin. */
+            double getPercentile (double fraction) const noexcept
+            {
+                const auto wanted = (uint64) std::ceil (fraction * (double) callbacks);
+                auto counted = uint64 (0);
+
+                for (auto bin = 0; bin < numBins - 1; ++bin)
+                {
+                    counted += histogram[(size_t) bin];
+
+                    if (counted >= wanted)
+                        return jmin (worstLoad, (bin + 1) * binWidth);
+                }
+
+                return worstLoad;
+            }
+        };
+
+        //==============================================================================
+        /** Starts over for a device running the given period. Call while it is stopped. */
+        void prepare (double newSampleRate, int periodSamples) noexcept
+        {
+            sampleRate = newSampleRate;
+            periodSeconds.store (periodSamples / newSampleRate, std::memory_order_relaxed);
+            lastStart = 0;
+            reset();
+        }
+
+        void addCallback (int64 startTicks, int64 endTicks, int numSamples) noexcept
+        {
+            const auto budget = numSamples / sampleRate;
+            const auto load = Time::highResolutionTicksToSeconds (endTicks - startTicks) / budget;
+            const auto bin = jlimit (0, numBins - 1, (int) (load / binWidth));
+
+            histogram[(size_t) bin].fetch_add (1, std::memory_order_relaxed);
+
+            if (load >= 1.0)
+                overBudget.fetch_add (1, std::memory_order_relaxed);
+
+            if (load > worstLoad.load (std::memory_order_relaxed))
+                worstLoad.store (load, std::memory_order_relaxed);
+
+            if (lastStart != 0 && Time::highResolutionTicksToSeconds (startTicks - lastStart) > lateInterval * budget)
+                late.fetch_add (1, std::memory_order_relaxed);
+
+            lastStart = startTicks;
+        }
+
+        //==============================================================================
+        Snapshot getSnapshot() const noexcept
+        {
+            Snapshot snapshot;
+
+            for (size_t i = 0; i < (size_t) numBins; ++i)
+                snapshot.histogram[i] = histogram[i].load (std::memory_order_relaxed);
+
+            // counted from the bins, so the percentiles always add up
+            snapshot.callbacks = std::accumulate (snapshot.histogram.begin(), snapshot.histogram.end(), uint64 (0));
+            snapshot.overBudget = overBudget.load (std::memory_order_relaxed);
+            snapshot.late = late.load (std::memory_order_relaxed);
+            snapshot.worstLoad = worstLoad.load (std::memory_order_relaxed);
+            snapshot.periodSeconds = periodSeconds.load (std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        void reset() noexcept
+        {
+            for (auto& bin : histogram)
+                bin.store (0, std::memory_order_relaxed);
+
+            overBudget.store (0, std::memory_order_relaxed);
+            late.store (0, std::memory_order_relaxed);
+            worstLoad.store (0.0, std::memory_order_relaxed);
+        }
+
+        //==============================================================================
+        /** p50, p99, p99.9 and the worst, in microseconds and as a share of the period. */
+        static String describeTimes (const Snapshot& snapshot)
+        {
+            String text;
+
+            for (auto [name, load] : { std::make_pair ("p50", snapshot.getPercentile (0.5)),
+                                       std::make_pair ("p99", snapshot.getPercentile (0.99)),
+                                       std::make_pair ("p99.9", snapshot.getPercentile (0.999)),
+                                       std::make_pair ("max", snapshot.worstLoad) })
+            {
+                text << (text.isEmpty() ? "" : ", ") << name << ' ' << roundToInt (load * snapshot.periodSeconds * 1.0e6)
+                     << " us (" << roundToInt (load * 100.0) << "%)";
+            }
+
+            return text;
+        }
+
+        struct ScopedCallback
+        {
+            ScopedCallback (CallbackMonitor& m, int n) noexcept : monitor (m), numSamples (n), start (Time::getHighResolutionTicks()) {}
+            ~ScopedCallback()  { monitor.addCallback (start, Time::getHighResolutionTicks(), numSamples); }
+
+            CallbackMonitor& monitor;
+            const int numSamples;
+            const int64 start;
+        };
+
+    private:
+        std::array<std::atomic<uint64>, numBins> histogram {};
+        std::atomic<uint64> overBudget { 0 }, late { 0 };
+        std::atomic<double> worstLoad { 0.0 }, periodSeconds { 0.0 };
+
+        // the audio thread's own, set by prepare() while the device is stopped
+        double sampleRate = 48000.0;
+        int64 lastStart = 0;
+    };
+}
@@ -0,0 +1,750 @@
+#include "Crossover.h"
+
+namespace Dsp {
+
+namespace {
+
+    //==============================================================================
+    template <typename Vec, typename FloatType>
+    struct LaneCoefficients
+    {
+        using Register = typename Vec::Register;
+
+        LaneCoefficients() noexcept = default;
+
+        explicit LaneCoefficients (const SvfCoefficients<FloatType>& c) noexcept
+            : a1 (Vec::broadcast (c.a1)), a2 (Vec::broadcast (c.a2)), a3 (Vec::broadcast (c.a3)),
+              k (Vec::broadcast (SvfCoefficients<FloatType>::k)),
+              twoK (Vec::broadcast (2 * SvfCoefficients<FloatType>::k))
+        {
+        }
+
+        Register a1, a2, a3, k, twoK;
+    };
+
+    /** One filter section for a register's worth of lanes, its state held in registers while it runs. */
+    template <typename Vec, typename FloatType>
+    struct LaneSection
+    {
+        using Register = typename Vec::Register;
+        using Coefficients = LaneCoefficients<Vec, FloatType>;
+
+        LaneSection() noexcept = default;
+
+        LaneSection (const FloatType* ic1Lanes, const FloatType* ic2Lanes) noexcept
+            : ic1 (Vec::load (ic1Lanes)), ic2 (Vec::load (ic2Lanes))
+        {
+        }
+
+        void storeTo (FloatType* ic1Lanes, FloatType* ic2Lanes) const noexcept
+        {
+            Vec::store (ic1Lanes, ic1);
+            Vec::store (ic2Lanes, ic2);
+        }
+
+        /** Returns the band output, low and high through the references. */
+        Register tick (const Coefficients& c, Register x, Register& lowOut, Register& highOut) noexcept
+        {
+            const auto v3 = Vec::sub (x, ic2);
+            const auto v1 = Vec::mulAdd (c.a1, ic1, Vec::mul (c.a2, v3));
+            const auto v2 = Vec::add (ic2, Vec::mulAdd (c.a2, ic1, Vec::mul (c.a3, v3)));
+            ic1 = Vec::sub (Vec::add (v1, v1), ic1);
+            ic2 = Vec::sub (Vec::add (v2, v2), ic2);
+            lowOut = v2;
+            highOut = Vec::sub (Vec::sub (x, Vec::mul (c.k, v1)), v2);
+            return v1;
+        }
+
+        Register lowPass (const Coefficients& c, Register x) noexcept   { Register l, h; tick (c, x, l, h); return l; }
+        Register highPass (const Coefficients& c, Register x) noexcept  { Register l, h; tick (c, x, l, h); return h; }
+        Register allPass (const Coefficients& c, Register x) noexcept   { Register l, h; return Vec::sub (x, Vec::mul (c.twoK, tick (c, x, l, h))); }
+
+        /** low⋅lowpass + band⋅bandpass + direct⋅x, so each lane can be a different kind of filter. */
+        Register weighted (const Coefficients& c, Register x, Register low, Register band, Register direct) noexcept
+        {
+            Register l, h;
+            const auto v1 = tick (c, x, l, h);
+            return Vec::mulAdd (low, l, Vec::mulAdd (band, v1, Vec::mul (direct, x)));
+        }
+
+        Register ic1, ic2;
+    };
+
+    template <typename Vec, typename FloatType>
+    struct LaneShaper
+    {
+        using Register = typename Vec::Register;
+
+        LaneShaper (Register c1, Register c2, Register c3, Register c4) noexcept
+            : k1 (c1), k2 (c2), k3 (c3), k4 (c4)
+        {
+        }
+
+        /** Every lane its own coefficients, from [k][lane] tables. */
+        LaneShaper (const FloatType (&coefficients)[4][MultiBandCrossover<FloatType>::maxLanes], int lane) noexcept
+            : LaneShaper (Vec::load (coefficients[0] + lane), Vec::load (coefficients[1] + lane),
+                          Vec::load (coefficients[2] + lane), Vec::load (coefficients[3] + lane))
+        {
+        }
+
+        LaneShaper advancedBy (const LaneShaper& increment, Register numSamples) const noexcept
+        {
+            return { Vec::mulAdd (increment.k1, numSamples, k1), Vec::mulAdd (increment.k2, numSamples, k2),
+                     Vec::mulAdd (increment.k3, numSamples, k3), Vec::mulAdd (increment.k4, numSamples, k4) };
+        }
+
+        Register apply (Register x) const noexcept
+        {
+            auto y = Vec::mulAdd (x, k4, k3);
+            y = Vec::mulAdd (y, x, k2);
+            y = Vec::mulAdd (y, x, k1);
+            return Vec::mul (y, x);
+        }
+
+        Register k1, k2, k3, k4;
+    };
+
+    //==============================================================================
+    /** numRegisters registers' worth of lanes from firstLane on, through numSections sections
+        and the shaper for every sample of the chunk. Their section states and weights stay in
+        registers throughout, so nothing in a section's feedback goes through memory, and
+        each section takes every register of the pass before the next section starts, so
+        their filter chains overlap. */
+    template <typename Vec, int numSections, int numRegisters, bool antiderivative, bool ramping, typename FloatType>
+    inline void splitRegisters (FloatType* frames, int numLanes, int firstLane, FloatType* state, int stateStride,
+                                int numSamples, int firstSample, const typename MultiBandCrossover<FloatType>::BandLanes& lanes,
+                                const FloatType* atLower, const FloatType* atUpper) noexcept
+    {
+        using Register = typename Vec::Register;
+        using Section = LaneSection<Vec, FloatType>;
+        using Shaper = LaneShaper<Vec, FloatType>;
+        constexpr auto numCrossovers = numSections / 2;
+        constexpr auto maxSections = MultiBandCrossover<FloatType>::maxSections;
+
+        // state is [section][ic1, ic2][lane], then every lane's last input to the clip
+        auto ic1 = [=] (int section, int r) { return state + (2 * section) * stateStride + firstLane + r * Vec::size; };
+        auto ic2 = [=] (int section, int r) { return state + (2 * section + 1) * stateStride + firstLane + r * Vec::size; };
+        auto* history = state + 2 * maxSections * stateStride + firstLane;
+
+        Section sections[numSections][numRegisters];
+        Register low[numSections][numRegisters], band[numSections][numRegisters], direct[numSections][numRegisters];
+
+        for (auto s = 0; s < numSections; ++s)
+        {
+            for (auto r = 0; r < numRegisters; ++r)
+            {
+                const auto lane = firstLane + r * Vec::size;
+                sections[s][r] = Section (ic1 (s, r), ic2 (s, r));
+                low[s][r] = Vec::load (lanes.low[s] + lane);
+                band[s][r] = Vec::load (lanes.band[s] + lane);
+                direct[s][r] = Vec::load (lanes.direct[s] + lane);
+            }
+        }
+
+        typename Section::Coefficients coefficients[numCrossovers];
+
+        for (auto c = 0; c < numCrossovers; ++c)
+            coefficients[c] = typename Section::Coefficients (lanes.coefficients[c]);
+
+        const auto one = Vec::broadcast (1), minusOne = Vec::broadcast (-1);
+
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            const auto index = static_cast<FloatType> (firstSample + i);
+
+            if constexpr (ramping)
+                for (auto c = 0; c < numCrossovers; ++c)
+                    coefficients[c] = typename Section::Coefficients (lanes.coefficients[c].advancedBy (lanes.increments[c], index));
+
+            auto* frame = frames + i * numLanes + firstLane;
+            Register xs[numRegisters];
+
+            for (auto r = 0; r < numRegisters; ++r)
+                xs[r] = Vec::load (frame + r * Vec::size);
+
+            for (auto s = 0; s < numSections; ++s)
+                for (auto r = 0; r < numRegisters; ++r)
+                    xs[r] = sections[s][r].weighted (coefficients[s / 2], xs[r], low[s][r], band[s][r], direct[s][r]);
+
+            for (auto r = 0; r < numRegisters; ++r)
+            {
+                const auto lane = firstLane + r * Vec::size;
+                const auto x = xs[r];
+                const auto lower = Vec::load (lanes.lower + lane), upper = Vec::load (lanes.upper + lane);
+                auto shaper = Shaper (lanes.shaper, lane);
+
+                if constexpr (ramping)
+                    shaper = shaper.advancedBy (Shaper (lanes.shaperIncrement, lane), Vec::broadcast (index));
+
+                if constexpr (antiderivative)
+                {
+                    // f at the clip, or at ±1 for a band that isn't clipped and never gets there;
+                    // they only move with a ramping curve, otherwise they were worked out once
+                    Register atLow, atHigh;
+
+                    if constexpr (ramping)
+                        atLow = shaper.apply (Vec::max (lower, minusOne)), atHigh = shaper.apply (Vec::min (upper, one));
+                    else
+                        atLow = Vec::load (atLower + lane), atHigh = Vec::load (atUpper + lane);
+
+                    Vec::store (frame + r * Vec::size, Antiderivative<Vec, FloatType>::clippedMean (x, Vec::load (history + r * Vec::size), lower, upper,
+                                                                                                    atLow, atHigh, shaper.k1, shaper.k2, shaper.k3, shaper.k4));
+                    Vec::store (history + r * Vec::size, x);
+                }
+                else
+                {
+                    Vec::store (frame + r * Vec::size, shaper.apply (Vec::min (Vec::max (x, lower), upper)));
+                }
+            }
+        }
+
+        for (auto s = 0; s < numSections; ++s)
+            for (auto r = 0; r < numRegisters; ++r)
+                sections[s][r].storeTo (ic1 (s, r), ic2 (s, r));
+    }
+
+    /** Every register of the group through numSections sections, a few registers per pass. */
+    template <typename Vec, int numSections, bool antiderivative, bool ramping, typename FloatType>
+    inline void splitSections (FloatType* frames, int numLanes, FloatType* state, int stateStride, int numSamples, int firstSample,
+                               const typename MultiBandCrossover<FloatType>::BandLanes& lanes,
+                               const FloatType* atLower, const FloatType* atUpper) noexcept
+    {
+        // as many registers as their states and weights leave room for: three up to four bands, two above
+        constexpr auto registersPerPass = jmin (3, jmax (1, 20 / numSections));
+        auto lane = 0;
+
+        for (; lane + registersPerPass * Vec::size <= numLanes; lane += registersPerPass * Vec::size)
+            splitRegisters<Vec, numSections, registersPerPass, antiderivative, ramping> (frames, numLanes, lane, state, stateStride, numSamples,
+                                                                                        firstSample, lanes, atLower, atUpper);
+
+        // what's left over goes in one pass too
+        const auto remaining = (numLanes - lane) / Vec::size;
+
+        if (remaining == 2)
+            splitRegisters<Vec, numSections, 2, antiderivative, ramping> (frames, numLanes, lane, state, stateStride, numSamples,
+                                                                         firstSample, lanes, atLower, atUpper);
+        else if (remaining == 1)
+            splitRegisters<Vec, numSections, 1, antiderivative, ramping> (frames, numLanes, lane, state, stateStride, numSamples,
+                                                                         firstSample, lanes, atLower, atUpper);
+    }
+
+    template <typename Vec, bool antiderivative, bool ramping, typename FloatType>
+    inline void splitAndShape (FloatType* frames, int numLanes, FloatType* state, int stateStride, int numSamples, int firstSample,
+                               const typename MultiBandCrossover<FloatType>::BandLanes& lanes) noexcept
+    {
+        using Shaper = LaneShaper<Vec, FloatType>;
+        constexpr auto maxLanes = MultiBandCrossover<FloatType>::maxLanes;
+
+        // f at the clip, or at ±1 for a band that isn't clipped, worked out once unless the curve moves
+        alignas (64) FloatType atLower[antiderivative && ! ramping ? maxLanes : 1];
+        alignas (64) FloatType atUpper[antiderivative && ! ramping ? maxLanes : 1];
+
+        if constexpr (antiderivative && ! ramping)
+        {
+            const auto one = Vec::broadcast (1), minusOne = Vec::broadcast (-1);
+
+            for (auto lane = 0; lane < numLanes; lane += Vec::size)
+            {
+                const Shaper shaper (lanes.shaper, lane);
+                Vec::store (atLower + lane, shaper.apply (Vec::max (Vec::load (lanes.lower + lane), minusOne)));
+                Vec::store (atUpper + lane, shaper.apply (Vec::min (Vec::load (lanes.upper + lane), one)));
+            }
+        }
+
+        // the section count is fixed per call, so the states can be held in registers
+        switch (lanes.numBands - 1)
+        {
+            case 1:  splitSections<Vec, 2, antiderivative, ramping> (frames, numLanes, state, stateStride, numSamples, firstSample, lanes, atLower, atUpper); break;
+            case 2:  splitSections<Vec, 4, antiderivative, ramping> (frames, numLanes, state, stateStride, numSamples, firstSample, lanes, atLower, atUpper); break;
+            case 3:  splitSections<Vec, 6, antiderivative, ramping> (frames, numLanes, state, stateStride, numSamples, firstSample, lanes, atLower, atUpper); break;
+            case 4:  splitSections<Vec, 8, antiderivative, ramping> (frames, numLanes, state, stateStride, numSamples, firstSample, lanes, atLower, atUpper); break;
+            default: splitSections<Vec, 10, antiderivative, ramping> (frames, numLanes, state, stateStride, numSamples, firstSample, lanes, atLower, atUpper); break;
+        }
+    }
+
+    template <typename Vec, bool ramping, typename FloatType>
+    inline void dryAllPass (FloatType* frames, int laneStride, int numSamples, int firstSample,
+                            typename MultiBandCrossover<FloatType>::DryLanes& lanes) noexcept
+    {
+        using Section = LaneSection<Vec, FloatType>;
+
+        typename Section::Coefficients coefficients[maxCrossovers];
+
+        for (auto c = 0; c < lanes.numCrossovers; ++c)
+            coefficients[c] = typename Section::Coefficients (lanes.coefficients[c]);
+
+        for (auto lane = 0; lane < laneStride; lane += Vec::size)
+        {
+            Section sections[maxCrossovers];
+
+            for (auto c = 0; c < lanes.numCrossovers; ++c)
+                sections[c] = Section (lanes.allPass[c].ic1 + lane, lanes.allPass[c].ic2 + lane);
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                if constexpr (ramping)
+                    for (auto c = 0; c < lanes.numCrossovers; ++c)
+                        coefficients[c] = typename Section::Coefficients (lanes.coefficients[c].advancedBy (lanes.increments[c], static_cast<FloatType> (firstSample + i)));
+
+                auto* frame = frames + i * laneStride + lane;
+                auto x = Vec::load (frame);
+
+                for (auto c = 0; c < lanes.numCrossovers; ++c)
+                    x = sections[c].allPass (coefficients[c], x);
+
+                Vec::store (frame, x);
+            }
+
+            for (auto c = 0; c < lanes.numCrossovers; ++c)
+                sections[c].storeTo (lanes.allPass[c].ic1 + lane, lanes.allPass[c].ic2 + lane);
+        }
+    }
+
+    //==============================================================================
+    template <typename FloatType>
+    using SplitFunction = void (*) (FloatType*, int, FloatType*, int, int, int,
+                                    const typename MultiBandCrossover<FloatType>::BandLanes&) noexcept;
+
+    template <typename FloatType>
+    using DryFunction = void (*) (FloatType*, int, int, int, typename MultiBandCrossover<FloatType>::DryLanes&) noexcept;
+
+    // See Pipeline.cpp: SSE2 and scalar need no attributes, AVX entry points are targeted and flattened.
+    #define INFLATION_CROSSOVER_ENTRIES(Name, attributes) \
+        template <typename Vec> \
+        struct Name \
+        { \
+            template <bool antiderivative, bool ramping, typename FloatType> \
+            attributes static void split (FloatType* frames, int numLanes, FloatType* state, int stateStride, int numSamples, \
+                                          int firstSample, const typename MultiBandCrossover<FloatType>::BandLanes& lanes) noexcept \
+            { splitAndShape<Vec, antiderivative, ramping> (frames, numLanes, state, stateStride, numSamples, firstSample, lanes); } \
+            \
+            template <bool ramping, typename FloatType> \
+            attributes static void dry (FloatType* frames, int laneStride, int numSamples, int firstSample, \
+                                        typename MultiBandCrossover<FloatType>::DryLanes& lanes) noexcept \
+            { dryAllPass<Vec, ramping> (frames, laneStride, numSamples, firstSample, lanes); } \
+        };
+
+    INFLATION_CROSSOVER_ENTRIES (PortableEntries, )
+
+   #if JUCE_INTEL
+    INFLATION_CROSSOVER_ENTRIES (Avx2Entries, INFLATION_KERNEL ("avx2,fma"))
+    INFLATION_CROSSOVER_ENTRIES (Avx512Entries, INFLATION_KERNEL ("avx512f"))
+   #endif
+
+    #undef INFLATION_CROSSOVER_ENTRIES
+
+    //==============================================================================
+    template <typename FloatType>
+    struct Table
+    {
+        int laneWidth = 1;
+        SplitFunction<FloatType> split[2][2];   // [antiderivative][ramping]
+        DryFunction<FloatType> dry[2];
+    };
+
+    template <typename Vec, typename Entries, typename FloatType>
+    Table<FloatType> makeTable() noexcept
+    {
+        Table<FloatType> table;
+        table.laneWidth = Vec::size;
+        table.split[0][0] = Entries::template split<false, false, FloatType>;
+        table.split[0][1] = Entries::template split<false, true,  FloatType>;
+        table.split[1][0] = Entries::template split<true,  false, FloatType>;
+        table.split[1][1] = Entries::template split<true,  true,  FloatType>;
+        table.dry[0] = Entries::template dry<false, FloatType>;
+        table.dry[1] = Entries::template dry<true,  FloatType>;
+        return table;
+    }
+
+    template <typename FloatVec, typename DoubleVec, template <typename> class Entries>
+    struct TablesFor
+    {
+        static Table<float> floats() noexcept    { return makeTable<FloatVec, Entries<FloatVec>, float>(); }
+        static Table<double> doubles() noexcept  { return makeTable<DoubleVec, Entries<DoubleVec>, double>(); }
+    };
+
+    struct Kernels
+    {
+        Table<float> floats;
+        Table<double> doubles;
+
+        const Table<float>& get (float) const noexcept    { return floats; }
+        const Table<double>& get (double) const noexcept  { return doubles; }
+    };
+
+    template <typename Tables>
+    Kernels makeKernels() noexcept
+    {
+        return { Tables::floats(), Tables::doubles() };
+    }
+
+    Kernels selectKernels (Isa isa) noexcept
+    {
+        switch (isa)
+        {
+           #if JUCE_INTEL
+            case Isa::avx512:   return makeKernels<TablesFor<Avx512Float, Avx512Double, Avx512Entries>>();
+            case Isa::avx2:     return makeKernels<TablesFor<Avx2Float, Avx2Double, Avx2Entries>>();
+            case Isa::sse2:     return makeKernels<TablesFor<Sse2Float, Sse2Double, PortableEntries>>();
+           #endif
+
+            case Isa::scalar:
+            default:            return makeKernels<TablesFor<ScalarVec<float>, ScalarVec<double>, PortableEntries>>();
+        }
+    }
+
+    // picked while the library loads, so the audio thread never takes a static's guard for it
+    const Kernels kernels = selectKernels (detectIsa());
+
+    template <typename FloatType>
+    const Table<FloatType>& getTable() noexcept
+    {
+        return kernels.get (FloatType());
+    }
+}
+
+//==============================================================================
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::prepare (ScratchArena& arena, int numChannels, int maxBlockSize, double sampleRate,
+                                             int maxGroupsToUse)
+{
+    jassert (numChannels <= maxChannels);
+
+    laneWidth = getTable<FloatType>().laneWidth;
+    preparedChannels = jlimit (0, maxChannels, numChannels);
+    maxGroups = jlimit (1, jmax (1, preparedChannels), maxGroupsToUse);
+    chunkSize = jmin (framesPerChunk, maxBlockSize);
+    maxSamples = maxBlockSize;
+
+    // room for the largest of the layouts setNumGroups() can pick
+    auto stateSize = 0, framesSize = 0;
+
+    for (auto groups = maxGroups; groups >= 1; --groups)
+    {
+        layOut (groups);
+        stateSize = jmax (stateSize, numGroups * getStateSize());
+        framesSize = jmax (framesSize, numGroups * frameSize * chunkSize);
+    }
+
+    bandState = arena.take<FloatType> (stateSize);
+    frames = arena.take<FloatType> (framesSize);
+
+    // three flat, clipped bands at the default crossovers until told otherwise
+    if (bands.numBands == 0)
+    {
+        const BlockRamp curves[maxBands] {};
+        const bool clips[maxBands] { true, true, true, true, true, true };
+
+        std::copy (std::begin (defaultCrossovers), std::end (defaultCrossovers), frequencies);
+        setNumBands (3);
+        setBands (curves, clips, 1);
+    }
+
+    // a group may hold a different number of channels now
+    updateWeights();
+    copyBandsToEveryChannel();
+
+    setSampleRate (sampleRate);
+    reset();
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::setNumGroups (int numGroupsToUse) noexcept
+{
+    layOut (jmin (numGroupsToUse, maxGroups));
+    updateWeights();
+    copyBandsToEveryChannel();
+    bandState.clear();
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::layOut (int numGroupsToUse) noexcept
+{
+    // a group's lanes and the dry channels are padded up to whole registers; the spare lanes just filter silence
+    numGroups = jlimit (1, jmax (1, preparedChannels), numGroupsToUse);
+    channelsPerGroup = (preparedChannels + numGroups - 1) / numGroups;
+    numGroups = channelsPerGroup > 0 ? (preparedChannels + channelsPerGroup - 1) / channelsPerGroup : 1;
+
+    groupStride = roundUpToLanes (channelsPerGroup * maxBands);
+    dryStride = jmin (maxDryLanes, roundUpToLanes (jmax (1, preparedChannels)));
+    frameSize = jmax (groupStride, dryStride);
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::setSampleRate (double sampleRate, int factor) noexcept
+{
+    oversamplingFactor = jmax (1, factor);
+    dryRate = sampleRate;
+    bandRate = sampleRate * oversamplingFactor;
+
+    for (auto c = 0; c < maxCrossovers; ++c)
+    {
+        bands.coefficients[c] = SvfCoefficients<FloatType>::make (frequencies[c], bandRate);
+        dry.coefficients[c] = SvfCoefficients<FloatType>::make (frequencies[c], dryRate);
+        bands.increments[c] = dry.increments[c] = {};
+        moving[c] = false;
+    }
+
+    crossoversRamping = false;
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::setNumBands (int numBands) noexcept
+{
+    numBands = jlimit (2, maxBands, numBands);
+
+    if (numBands == bands.numBands)
+        return;
+
+    bands.numBands = numBands;
+    dry.numCrossovers = numBands - 1;
+    updateWeights();
+    copyBandsToEveryChannel();
+    reset();
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::setAntiderivative (bool shouldUseAntiderivative) noexcept
+{
+    if (shouldUseAntiderivative == antiderivative)
+        return;
+
+    antiderivative = shouldUseAntiderivative;
+
+    // the bands' last inputs are only kept while it's on, so start them from silence
+    const auto stateSize = getStateSize();
+
+    for (auto offset = 0; stateSize > 0 && offset < bandState.size(); offset += stateSize)
+    {
+        auto* history = bandState.data() + offset + 2 * maxSections * groupStride;
+        std::fill (history, history + groupStride, FloatType (0));
+    }
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::setCrossovers (const BlockRamp* ramps, int numSamples) noexcept
+{
+    crossoversRamping = false;
+    BlockRamp below;
+
+    for (auto c = 0; c < dry.numCrossovers; ++c)
+    {
+        const BlockRamp frequency { jmax (ramps[c].start, below.start), jmax (ramps[c].end, below.end) };
+        below = frequency;
+
+        // a tan per rate and end, only when the crossover moved
+        if (frequency.isConstant() && frequency.end == frequencies[c] && ! moving[c])
+            continue;
+
+        const auto bandStart = SvfCoefficients<FloatType>::make (frequency.start, bandRate);
+        const auto dryStart = SvfCoefficients<FloatType>::make (frequency.start, dryRate);
+        bands.coefficients[c] = bandStart;
+        bands.increments[c] = bandStart.getIncrementTo (SvfCoefficients<FloatType>::make (frequency.end, bandRate), numSamples * oversamplingFactor);
+        dry.coefficients[c] = dryStart;
+        dry.increments[c] = dryStart.getIncrementTo (SvfCoefficients<FloatType>::make (frequency.end, dryRate), numSamples);
+
+        frequencies[c] = frequency.end;
+        moving[c] = ! frequency.isConstant();
+        crossoversRamping = crossoversRamping || moving[c];
+    }
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::setBands (const BlockRamp* curves, const bool* clips, int numSamples) noexcept
+{
+    const auto limit = std::numeric_limits<FloatType>::max();
+    bandsRamping = false;
+
+    for (auto b = 0; b < bands.numBands; ++b)
+    {
+        const auto start = ShaperCoefficients<FloatType>::fromCurve (curves[b].start);
+        const auto increment = start.getIncrementTo (ShaperCoefficients<FloatType>::fromCurve (curves[b].end), numSamples * oversamplingFactor);
+
+        bands.shaper[0][b] = start.k1;
+        bands.shaper[1][b] = start.k2;
+        bands.shaper[2][b] = start.k3;
+        bands.shaper[3][b] = start.k4;
+        bands.shaperIncrement[0][b] = increment.k1;
+        bands.shaperIncrement[1][b] = increment.k2;
+        bands.shaperIncrement[2][b] = increment.k3;
+        bands.shaperIncrement[3][b] = increment.k4;
+        bands.lower[b] = clips[b] ? FloatType (-1) : -limit;
+        bands.upper[b] = clips[b] ? FloatType (1) : limit;
+
+        bandsRamping = bandsRamping || ! curves[b].isConstant();
+    }
+
+    copyBandsToEveryChannel();
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::updateWeights() noexcept
+{
+    constexpr auto k = SvfCoefficients<FloatType>::k;
+
+    // lanes without a band keep all weights at zero, so they put out silence
+    for (auto* weights : { &bands.low, &bands.band, &bands.direct })
+        for (auto& section : *weights)
+            std::fill (std::begin (section), std::end (section), FloatType (0));
+
+    for (auto b = 0; b < bands.numBands; ++b)
+    {
+        auto set = [this, b] (int section, FloatType low, FloatType band, FloatType direct)
+        {
+            bands.low[section][b] = low;
+            bands.band[section][b] = band;
+            bands.direct[section][b] = direct;
+        };
+
+        for (auto c = 0; c < bands.numBands - 1; ++c)
+        {
+            if (c < b)          { set (2 * c, -1, -k, 1);      set (2 * c + 1, -1, -k, 1); }    // high pass, x - k⋅v1 - v2
+            else if (c == b)    { set (2 * c, 1, 0, 0);        set (2 * c + 1, 1, 0, 0); }      // low pass, v2
+            else                { set (2 * c, 0, -2 * k, 1);   set (2 * c + 1, 0, 0, 1); }      // all pass, then a wire
+        }
+    }
+
+    for (auto section = 0; section < 2 * (bands.numBands - 1); ++section)
+    {
+        for (auto* weights : { &bands.low, &bands.band, &bands.direct })
+        {
+            auto* lanes = (*weights)[section];
+
+            for (auto channel = 1; channel < channelsPerGroup; ++channel)
+                std::copy (lanes, lanes + bands.numBands, lanes + channel * bands.numBands);
+        }
+    }
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::copyBandsToEveryChannel() noexcept
+{
+    // the first channel's lanes hold every band's shaper and clip, the other channels get copies
+    const auto numBands = bands.numBands;
+
+    auto copy = [=] (FloatType* lanes)
+    {
+        for (auto channel = 1; channel < channelsPerGroup; ++channel)
+            std::copy (lanes, lanes + numBands, lanes + channel * numBands);
+    };
+
+    for (auto k = 0; k < 4; ++k)
+    {
+        copy (bands.shaper[k]);
+        copy (bands.shaperIncrement[k]);
+    }
+
+    copy (bands.lower);
+    copy (bands.upper);
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::process (FloatType* const* channels, int numChannels, int numSamples) noexcept
+{
+    for (auto group = 0; group < numGroups; ++group)
+        processGroup (group, channels, numChannels, numSamples);
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::processGroup (int group, FloatType* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numSamples <= maxSamples && isPositiveAndBelow (group, numGroups));
+
+    const auto split = getTable<FloatType>().split[antiderivative][bandsRamping || crossoversRamping];
+    const auto groupChannels = getGroupChannels (group, numChannels);
+    const auto firstChannel = groupChannels.getStart();
+    const auto numGroupChannels = groupChannels.getLength();
+    const auto numBands = bands.numBands;
+    const auto numUsed = numGroupChannels * numBands;
+    const auto numLanes = roundUpToLanes (numUsed);
+
+    auto* groupFrames = frames.data() + group * frameSize * chunkSize;
+    auto* state = bandState.data() + group * getStateSize();
+
+    for (auto offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        const auto length = jmin (chunkSize, numSamples - offset);
+
+        // each channel's samples in the lane of every one of its bands, the spare lanes silent
+        for (auto lane = 0; lane < numUsed; ++lane)
+        {
+            const auto* source = channels[firstChannel + lane / numBands] + offset;
+            auto* destination = groupFrames + lane;
+
+            for (auto i = 0; i < length; ++i)
+                destination[i * numLanes] = source[i];
+        }
+
+        if (numUsed < numLanes)
+            for (auto i = 0; i < length; ++i)
+                std::fill (groupFrames + i * numLanes + numUsed, groupFrames + (i + 1) * numLanes, FloatType (0));
+
+        split (groupFrames, numLanes, state, groupStride, length, offset, bands);
+
+        // summed low to high, the same order whatever the lane width
+        for (auto lane = 0; lane < numUsed; ++lane)
+        {
+            const auto* source = groupFrames + lane;
+            auto* destination = channels[firstChannel + lane / numBands] + offset;
+
+            if (lane % numBands == 0)
+                for (auto i = 0; i < length; ++i)
+                    destination[i] = source[i * numLanes];
+            else
+                for (auto i = 0; i < length; ++i)
+                    destination[i] += source[i * numLanes];
+        }
+    }
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::processDry (FloatType* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numSamples <= maxSamples);
+    numChannels = jmin (numChannels, dryStride);
+
+    for (auto offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        const auto length = jmin (chunkSize, numSamples - offset);
+
+        interleave (channels, numChannels, offset, length);
+        getTable<FloatType>().dry[crossoversRamping] (frames.data(), dryStride, length, offset, dry);
+        deinterleave (channels, numChannels, offset, length);
+    }
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::interleave (const FloatType* const* channels, int numChannels, int offset, int numSamples) noexcept
+{
+    for (auto channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* source = channels[channel] + offset;
+        auto* destination = frames.data() + channel;
+
+        for (auto i = 0; i < numSamples; ++i)
+            destination[i * dryStride] = source[i];
+    }
+
+    // the spare lanes filter silence
+    for (auto channel = numChannels; channel < dryStride; ++channel)
+        for (auto i = 0; i < numSamples; ++i)
+            frames[i * dryStride + channel] = 0;
+}
+
+template <typename FloatType>
+void MultiBandCrossover<FloatType>::deinterleave (FloatType* const* channels, int numChannels, int offset, int numSamples) const noexcept
+{
+    for (auto channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* source = frames.data() + channel;
+        auto* destination = channels[channel] + offset;
+
+        for (auto i = 0; i < numSamples; ++i)
+            destination[i] = source[i * dryStride];
+    }
+}
+
+template class MultiBandCrossover<float>;
+template class MultiBandCrossover<double>;
+
+}
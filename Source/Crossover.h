@@ -0,0 +1,207 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VectorIsa.h"
+#include "ScratchArena.h"
+#include "WaveShaper.h"
+#include "ParameterSnapshot.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /** Coefficients of a Butterworth (Q = 1/√2) state variable filter in the trapezoidal form. */
+    template <typename FloatType>
+    struct SvfCoefficients
+    {
+        FloatType a1 = 0, a2 = 0, a3 = 0;
+        static constexpr FloatType k = FloatType (MathConstants<double>::sqrt2);
+
+        static SvfCoefficients make (double frequency, double sampleRate) noexcept
+        {
+            const auto g = std::tan (MathConstants<double>::pi * jmin (frequency, sampleRate * 0.49) / sampleRate);
+            const auto a1 = 1.0 / (1.0 + g * (g + MathConstants<double>::sqrt2));
+            return { static_cast<FloatType> (a1), static_cast<FloatType> (g * a1), static_cast<FloatType> (g * g * a1) };
+        }
+
+        /** Per sample change taking these coefficients to end over numSamples, for a crossover being moved. */
+        SvfCoefficients getIncrementTo (const SvfCoefficients& end, int numSamples) const noexcept
+        {
+            const auto scale = FloatType (1) / static_cast<FloatType> (numSamples);
+            return { (end.a1 - a1) * scale, (end.a2 - a2) * scale, (end.a3 - a3) * scale };
+        }
+
+        SvfCoefficients advancedBy (const SvfCoefficients& increment, FloatType numSamples) const noexcept
+        {
+            return { a1 + increment.a1 * numSamples, a2 + increment.a2 * numSamples, a3 + increment.a3 * numSamples };
+        }
+    };
+
+    /** The two integrator states of one filter section, for every lane side by side. */
+    template <typename FloatType, int maxLanes>
+    struct SvfLanes
+    {
+        alignas (64) FloatType ic1[maxLanes] = {};
+        alignas (64) FloatType ic2[maxLanes] = {};
+
+        void reset() noexcept
+        {
+            std::fill (std::begin (ic1), std::end (ic1), FloatType (0));
+            std::fill (std::begin (ic2), std::end (ic2), FloatType (0));
+        }
+    };
+
+    //==============================================================================
+    /*  Band Split: 2 to 6 bands with Linkwitz-Riley (24 dB/octave) crossovers, each band
+        clipped and shaped with its own curve, then summed.
+
+        The usual tree of splits is written out per band instead, so that every band runs
+        the same chain and can have a SIMD lane of its own. Band b of n passes the high
+        pass of every crossover below it, the low pass of its own, and the all pass of
+        every crossover above it:
+
+            band 0      LR4 low (f₀) ── all pass (f₁) ── all pass (f₂)
+            band 1      LR4 high (f₀) ─ LR4 low (f₁) ─── all pass (f₂)
+            band 2      LR4 high (f₀) ─ LR4 high (f₁) ── LR4 low (f₂)
+            band 3      LR4 high (f₀) ─ LR4 high (f₁) ── LR4 high (f₂)
+
+        which is exactly what the tree computes. Each crossover is two state variable
+        sections, and per lane output weights make a section a low pass, high pass, all
+        pass or a straight wire, so all bands go through in one pass and the cost follows
+        the number of crossovers a band passes, not the number of bands.
+
+        The lanes are every band of every channel, channel by channel, in frames of
+        interleaved samples as processDry() has the channels: 12 channels of 3 bands are 36
+        lanes, three AVX-512 float registers. A few registers at a time run the whole chunk
+        with their section states and weights held in registers, stored once at the end;
+        each section of a sample runs on all of them before the next starts, so their filter
+        chains, each of which has to wait for its own last result, overlap instead of running
+        one after the other. The bands sum to the
+        input through the all pass of every crossover, which processDry() runs on the dry
+        path so the wet/dry mix doesn't comb.
+
+        Moving a crossover only moves its coefficients, linearly per sample across the
+        block; the filter states are kept, so nothing is rebuilt and nothing clicks.
+    */
+    template <typename FloatType>
+    class MultiBandCrossover
+    {
+    public:
+        static constexpr int maxLanes = maxChannels * maxBands;         // every band of every channel
+        static constexpr int maxDryLanes = maxChannels;
+        static constexpr int maxSections = 2 * maxCrossovers;
+        static constexpr int framesPerChunk = 128;                      // interleaved at a time, so the frames stay in cache
+
+        /** Everything the band kernels read, laid out per lane. Lane c⋅numBands + b is band b
+            of the c-th channel in a group, and every channel's bands have the same weights. */
+        struct BandLanes
+        {
+            // a section's output is low⋅lowpass + band⋅bandpass + direct⋅input
+            alignas (64) FloatType low[maxSections][maxLanes] = {};
+            alignas (64) FloatType band[maxSections][maxLanes] = {};
+            alignas (64) FloatType direct[maxSections][maxLanes] = {};
+
+            // each band's shaper, and how it moves per sample while its curve is smoothed
+            alignas (64) FloatType shaper[4][maxLanes] = {};
+            alignas (64) FloatType shaperIncrement[4][maxLanes] = {};
+
+            // ±1 for a clipped band, ±max for one that isn't
+            alignas (64) FloatType lower[maxLanes] = {};
+            alignas (64) FloatType upper[maxLanes] = {};
+
+            SvfCoefficients<FloatType> coefficients[maxCrossovers], increments[maxCrossovers];
+            int numBands = 0;
+        };
+
+        /** The dry path's all passes, every channel in a lane of its own. */
+        struct DryLanes
+        {
+            SvfLanes<FloatType, maxDryLanes> allPass[maxCrossovers];
+            SvfCoefficients<FloatType> coefficients[maxCrossovers], increments[maxCrossovers];
+            int numCrossovers = 0;
+        };
+
+        //==============================================================================
+        /** Takes the filter state and the working frames from the arena. Call from the arena's
+            layout function; maxBlockSize is at the oversampled rate. There's room for the
+            channels to be split into up to maxGroups groups, see setNumGroups(); it starts
+            with one. */
+        void prepare (ScratchArena& arena, int numChannels, int maxBlockSize, double sampleRate, int maxGroups = 1);
+
+        /** Splits the channels into numGroupsToUse groups, as even as can be, that different
+            threads can process at once; in real time one group holding every channel is
+            cheapest. Restarts the band filters but takes nothing new, so it's safe on the
+            audio thread. */
+        void setNumGroups (int numGroupsToUse) noexcept;
+
+        /** The bands run oversamplingFactor times faster than the dry path. Only recomputes
+            coefficients, so it's safe when oversampling changes on the audio thread. */
+        void setSampleRate (double sampleRate, int oversamplingFactor = 1) noexcept;
+
+        /** A different number of bands means different filters, so it restarts them. */
+        void setNumBands (int numBands) noexcept;
+        int getNumBands() const noexcept            { return bands.numBands; }
+
+        /** Where each crossover in use goes over the next block of numSamples at the dry rate,
+            in Hz. They are kept in order, each at least at the one below. */
+        void setCrossovers (const BlockRamp* frequencies, int numSamples) noexcept;
+
+        /** Each band's curve over the next block of numSamples at the dry rate, and whether it's clipped. */
+        void setBands (const BlockRamp* curves, const bool* clips, int numSamples) noexcept;
+
+        /** Shapes every band with antiderivative anti-aliasing, see Dsp::Antiderivative. */
+        void setAntiderivative (bool shouldUseAntiderivative) noexcept;
+
+        void reset() noexcept
+        {
+            bandState.clear();
+            resetDry();
+        }
+
+        /** The dry all passes aren't run while fully wet, so they're restarted when the dry path returns. */
+        void resetDry() noexcept
+        {
+            for (auto& lanes : dry.allPass)
+                lanes.reset();
+        }
+
+        //==============================================================================
+        int getNumGroups() const noexcept           { return numGroups; }
+
+        /** The channels below numChannelsInBlock that processGroup() takes for a group. */
+        Range<int> getGroupChannels (int group, int numChannelsInBlock) const noexcept
+        {
+            return Range<int> (group * channelsPerGroup, (group + 1) * channelsPerGroup)
+                       .getIntersectionWith ({ 0, jmin (numChannelsInBlock, preparedChannels) });
+        }
+
+        /** Splits, clips, shapes and re-sums every channel of the block in place. */
+        void process (FloatType* const* channels, int numChannels, int numSamples) noexcept;
+
+        /** The same for one group's channels, which it takes out of channels by their index.
+            Different groups can be processed on different threads at once. */
+        void processGroup (int group, FloatType* const* channels, int numChannels, int numSamples) noexcept;
+
+        /** The phase response of an unshaped band sum, for the dry signal. */
+        void processDry (FloatType* const* channels, int numChannels, int numSamples) noexcept;
+
+    private:
+        void layOut (int numGroupsToUse) noexcept;
+        void updateWeights() noexcept;
+        void copyBandsToEveryChannel() noexcept;
+        int getStateSize() const noexcept   { return (2 * maxSections + 1) * groupStride; }
+        int roundUpToLanes (int count) const noexcept  { return (count + laneWidth - 1) / laneWidth * laneWidth; }
+        void interleave (const FloatType* const* channels, int numChannels, int offset, int numSamples) noexcept;
+        void deinterleave (FloatType* const* channels, int numChannels, int offset, int numSamples) const noexcept;
+
+        BandLanes bands;
+        DryLanes dry;
+        ArenaArray<FloatType> bandState;    // per group, both integrators of every section and the last clip input for groupStride lanes
+        ArenaArray<FloatType> frames;       // per group, chunkSize frames of up to frameSize samples
+        double bandRate = 44100.0, dryRate = 44100.0;
+        double frequencies[maxCrossovers] = {};
+        bool moving[maxCrossovers] = {};
+        int preparedChannels = 0, maxGroups = 1, numGroups = 1, channelsPerGroup = 0, laneWidth = 1;
+        int groupStride = 0, dryStride = 0, frameSize = 0, chunkSize = 0, maxSamples = 0, oversamplingFactor = 1;
+        bool bandsRamping = false, crossoversRamping = false, antiderivative = false;
+    };
+}
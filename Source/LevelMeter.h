@@ -4,57 +4,173 @@
 
 namespace Gui {
 
+    /*  A vertical bar meter with a peak hold and a clip light.
+
+        The empty and the full bar (each with the 0 dB line) are drawn once per size into
+        images, so painting is two image copies. update() works out which rows of pixels
+        the new reading changes and repaints just those, or nothing when the level moved
+        less than a pixel.
+    */
     class LevelMeter : public Component{
     public:
         LevelMeter(){
+            setOpaque(true);
         }
-        
-        LevelMeter(float min, float max){
+
+        LevelMeter(float min, float max) : LevelMeter(){
             minRange = min;
             maxRange = max;
         }
+
         void paint(Graphics &g) override{
-            auto bounds = getLocalBounds().toFloat();
-            g.setColour(juce::Colours::black);
-            g.fillRect(bounds);
-            
-            g.setGradientFill(gradient);
-            const auto scaledY = jmap(level, minRange, maxRange, 0.0f, static_cast<float>(getHeight()));
-            g.fillRect(bounds.removeFromBottom(scaledY));
-            
-            // draw zero clip region
-            bounds = getLocalBounds().toFloat();
-            g.setColour(juce::Colours::red);
-            const auto zeroLevel = jmap(0.0f, minRange, maxRange, 0.0f, static_cast<float>(getHeight()));
-            g.drawLine(bounds.getTopLeft().getX(),
-                       bounds.getHeight() - zeroLevel,
-                       bounds.getTopRight().getX(),
-                       bounds.getHeight() - zeroLevel,
-                       4); // thickness
-        }
-        
+            if (fullBar.isNull())
+                return;
+
+            // the bar up to the level, the empty meter above it; only inside the dirty area
+            const auto clip = g.getClipBounds().getIntersection(getLocalBounds());
+            const auto split = jlimit(clip.getY(), clip.getBottom(), levelY);
+
+            drawRows(g, emptyBar, clip.getY(), split);
+            drawRows(g, fullBar, split, clip.getBottom());
+
+            if (peakY >= 0)
+            {
+                g.setColour(juce::Colours::white);
+                g.fillRect(0, peakY, getWidth(), 1);
+            }
+
+            // light the top of the meter for a while after the signal went over 0 dBFS
+            if (clipLit)
+            {
+                g.setColour(juce::Colours::red);
+                g.fillRect(0, 0, getWidth(), clipLightHeight);
+            }
+        }
+
         void resized() override{
-            const auto bounds = getLocalBounds().toFloat();
-            const auto zeroLevel = jmap(0.0f, minRange, maxRange, 0.0f, static_cast<float>(getHeight()));
-            auto topleft =  bounds.getTopLeft();
-            topleft.setY(bounds.getHeight() - zeroLevel);
-            gradient = ColourGradient{
-                Colours::green,
-                bounds.getBottomLeft(),
-                Colours::red,
-                topleft,
-                false
-            };
-            gradient.addColour(0.8f, juce::Colours::yellow);
-        }
-            
+            renderBars();
+            levelY = toY(level);
+            peakY = peak > minRange ? toY(jmin(peak, maxRange)) : -1;
+        }
+
+        void parentHierarchyChanged() override{
+            // the scale can change when the editor moves to another display
+            renderBars();
+        }
+
         void setLevel(const float value){
             level = value;
         }
-        
+
+        // peaks arrive as the highest since the last update, the hold decays from there
+        void setPeak(const float value, double elapsedSeconds){
+            peak = jmax(value, peak - static_cast<float>(peakDecayPerSecond * elapsedSeconds));
+        }
+
+        void setClipCount(const uint32 count, double elapsedSeconds){
+            if (count != lastClipCount)
+                clipHoldSeconds = clipHoldLength;
+            else
+                clipHoldSeconds = jmax(0.0, clipHoldSeconds - elapsedSeconds);
+
+            lastClipCount = count;
+        }
+
+        /** Repaints the rows the last set* calls changed, nothing if none did. */
+        void update(){
+            const auto newLevelY = toY(level);
+            const auto newPeakY = peak > minRange ? toY(jmin(peak, maxRange)) : -1;
+            const auto newClipLit = clipHoldSeconds > 0.0;
+
+            if (std::abs(newLevelY - levelY) >= repaintThreshold)
+            {
+                repaint(0, jmin(levelY, newLevelY), getWidth(), std::abs(newLevelY - levelY));
+                levelY = newLevelY;
+            }
+
+            if (newPeakY != peakY)
+            {
+                if (peakY >= 0)
+                    repaint(0, peakY, getWidth(), 1);
+
+                if (newPeakY >= 0)
+                    repaint(0, newPeakY, getWidth(), 1);
+
+                peakY = newPeakY;
+            }
+
+            if (newClipLit != clipLit)
+            {
+                repaint(0, 0, getWidth(), clipLightHeight);
+                clipLit = newClipLit;
+            }
+        }
+
     private:
+        int toY(float value) const{
+            return getHeight() - roundToInt(jmap(jlimit(minRange, maxRange, value), minRange, maxRange, 0.0f, static_cast<float>(getHeight())));
+        }
+
+        void renderBars(){
+            const auto scale = Component::getApproximateScaleFactorForComponent(this);
+            const auto width = roundToInt(getWidth() * scale), height = roundToInt(getHeight() * scale);
+
+            if (width <= 0 || height <= 0)
+            {
+                emptyBar = fullBar = Image();
+                return;
+            }
+
+            emptyBar = Image(Image::RGB, width, height, false);
+            fullBar = Image(Image::RGB, width, height, false);
+
+            const auto bounds = Rectangle<float>(0.0f, 0.0f, (float) width, (float) height);
+            const auto zeroY = (float) height - jmap(0.0f, minRange, maxRange, 0.0f, (float) height);
+
+            {
+                Graphics g(emptyBar);
+                g.fillAll(juce::Colours::black);
+            }
+
+            {
+                ColourGradient gradient(Colours::green, bounds.getBottomLeft(), Colours::red, { 0.0f, zeroY }, false);
+                gradient.addColour(0.8f, juce::Colours::yellow);
+
+                Graphics g(fullBar);
+                g.setGradientFill(gradient);
+                g.fillAll();
+            }
+
+            // the 0 dB line is part of both
+            for (auto* image : { &emptyBar, &fullBar })
+            {
+                Graphics g(*image);
+                g.setColour(juce::Colours::red);
+                g.drawLine(0.0f, zeroY, (float) width, zeroY, 4.0f * (float) scale);
+            }
+        }
+
+        // copies rows [top, bottom) of a cached bar, which may be at a higher resolution
+        void drawRows(Graphics &g, const Image &bar, int top, int bottom) const{
+            if (bottom <= top)
+                return;
+
+            const auto scale = (float) bar.getHeight() / (float) getHeight();
+            g.drawImage(bar, 0, top, getWidth(), bottom - top,
+                        0, roundToInt(top * scale), bar.getWidth(), roundToInt((bottom - top) * scale));
+        }
+
         float level = -100.0f;
-        ColourGradient gradient{};
+        float peak = -100.0f;
+        uint32 lastClipCount = 0;
+        double clipHoldSeconds = 0.0;
+        int levelY = 0, peakY = -1;
+        bool clipLit = false;
+        Image emptyBar, fullBar;
+        static constexpr float peakDecayPerSecond = 12.0f;  // dB
+        static constexpr double clipHoldLength = 2.0;       // seconds
+        static constexpr int clipLightHeight = 4;
+        static constexpr int repaintThreshold = 1;          // pixels the level has to move
         float minRange = -100.0f;
         float maxRange = 0.0f;
     };
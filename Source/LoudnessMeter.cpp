@@ -0,0 +1,263 @@
+#include "LoudnessMeter.h"
+
+namespace Dsp {
+
+LoudnessMeter::LoudnessMeter()
+{
+    thread->addTimeSliceClient (this);
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+    thread->removeTimeSliceClient (this);
+}
+
+void LoudnessMeter::prepare (double sampleRate, const AudioChannelSet& inputLayout, const AudioChannelSet& outputLayout)
+{
+    // BS.1770's two stages from their analogue prototypes, so that every sample rate gets
+    // the response the standard tabulates at 48 kHz
+    {
+        const auto frequency = 1681.974450955533, gainDecibels = 3.999843853973347, q = 0.7071752369554196;
+        const auto k = std::tan (MathConstants<double>::pi * frequency / sampleRate);
+        const auto high = std::pow (10.0, gainDecibels / 20.0);
+        const auto band = std::pow (high, 0.4996667741545416);
+        const auto a0 = 1.0 + k / q + k * k;
+
+        shelf = { (high + band * k / q + k * k) / a0, 2.0 * (k * k - high) / a0, (high - band * k / q + k * k) / a0,
+                  2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    {
+        const auto frequency = 38.13547087602444, q = 0.5003270373238773;
+        const auto k = std::tan (MathConstants<double>::pi * frequency / sampleRate);
+        const auto a0 = 1.0 + k / q + k * k;
+
+        // the numerator is 1, -2, 1 and is written out in measureChunk
+        highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    stepLength = jmax (1, roundToInt (sampleRate * stepSeconds));
+
+    setWeights (input, inputLayout);
+    setWeights (output, outputLayout);
+    input.clear();
+    output.clear();
+
+    // steps from before are dropped when the loudness thread sees the new generation
+    ++generation;
+    matchingGain = 1.0;
+    matchingDecibels.store (0.0f, std::memory_order_relaxed);
+}
+
+void LoudnessMeter::setWeights (Signal& signal, const AudioChannelSet& layout) noexcept
+{
+    signal.numChannels = jmin (layout.size(), maxChannels);
+
+    for (auto i = 0; i < signal.numChannels; ++i)
+    {
+        switch (layout.getTypeOfChannel (i))
+        {
+            case AudioChannelSet::LFE:
+            case AudioChannelSet::LFE2:
+                signal.weights[(size_t) i] = 0.0;
+                break;
+
+            case AudioChannelSet::leftSurround:
+            case AudioChannelSet::rightSurround:
+            case AudioChannelSet::leftSurroundSide:
+            case AudioChannelSet::rightSurroundSide:
+            case AudioChannelSet::leftSurroundRear:
+            case AudioChannelSet::rightSurroundRear:
+                signal.weights[(size_t) i] = 1.41;
+                break;
+
+            default:
+                signal.weights[(size_t) i] = 1.0;
+                break;
+        }
+    }
+}
+
+void LoudnessMeter::Signal::clear() noexcept
+{
+    for (auto& channel : channels)
+        channel = {};
+
+    stepPower = stepPeak = matchPower = 0.0;
+    stepPosition = 0;
+    recentMatch.fill (0.0);
+    recentMatchSum = 0.0;
+    recentMatchPosition = numRecentMatch = 0;
+}
+
+//==============================================================================
+void LoudnessMeter::finishStep (Signal& signal) noexcept
+{
+    const auto power = signal.stepPower / stepLength;
+    const auto match = signal.matchPower / stepLength;
+
+    // the loudness thread is behind when there's no room, the step is lost to it
+    if (signal.fifo.getFreeSpace() >= 1)
+        signal.fifo.write (1).forEach ([&] (int index) { signal.steps[(size_t) index] = { power, signal.stepPeak, generation }; });
+
+    auto& oldest = signal.recentMatch[(size_t) signal.recentMatchPosition];
+    signal.recentMatchSum += match - oldest;
+    oldest = match;
+    signal.numRecentMatch = jmin (signal.numRecentMatch + 1, shortTermSteps);
+
+    // start the running sum over once per window so rounding can't build up
+    if (++signal.recentMatchPosition == shortTermSteps)
+    {
+        signal.recentMatchPosition = 0;
+        signal.recentMatchSum = std::accumulate (signal.recentMatch.begin(), signal.recentMatch.end(), 0.0);
+    }
+
+    signal.stepPower = signal.stepPeak = signal.matchPower = 0.0;
+    signal.stepPosition = 0;
+}
+
+void LoudnessMeter::updateMatchingGain() noexcept
+{
+    // the input and output finish their steps in the same block, so both windows cover the same time
+    if (output.numRecentMatch == 0)
+        return;
+
+    const auto inputLoudness = toLufs (input.recentMatchSum / input.numRecentMatch);
+    const auto outputLoudness = toLufs (output.recentMatchSum / output.numRecentMatch);
+
+    // nothing to match in silence; holding keeps a pause from pulling the gain anywhere
+    if (inputLoudness <= absoluteGate || outputLoudness <= absoluteGate)
+        return;
+
+    const auto decibels = jlimit (-maxMatchingDecibels, maxMatchingDecibels, inputLoudness - outputLoudness);
+    matchingGain = Decibels::decibelsToGain (decibels, -1000.0);
+    matchingDecibels.store ((float) decibels, std::memory_order_relaxed);
+}
+
+//==============================================================================
+int LoudnessMeter::useTimeSlice()
+{
+    const auto reset = resetRequested.exchange (false, std::memory_order_relaxed);
+
+    for (auto* signal : { &input, &output })
+    {
+        if (reset)
+            signal->analysis.clear();
+
+        analyse (*signal);
+    }
+
+    return 50;
+}
+
+void LoudnessMeter::analyse (Signal& signal) noexcept
+{
+    auto& analysis = signal.analysis;
+    const auto numReady = signal.fifo.getNumReady();
+
+    if (numReady == 0)
+        return;
+
+    signal.fifo.read (numReady).forEach ([&] (int index)
+    {
+        const auto& step = signal.steps[(size_t) index];
+
+        // a new generation began with prepare, everything before it is another measurement
+        if (step.generation != analysis.generation)
+        {
+            analysis.clear();
+            analysis.generation = step.generation;
+        }
+
+        analysis.add (step);
+    });
+
+    analysis.publish();
+}
+
+void LoudnessMeter::Analysis::clear() noexcept
+{
+    recent.fill (0.0);
+    recentPosition = numRecent = 0;
+    binPower.fill (0.0);
+    binCount.fill (0);
+    peak = 0.0;
+    publish();
+}
+
+void LoudnessMeter::Analysis::add (const Step& step) noexcept
+{
+    recent[(size_t) recentPosition] = step.power;
+    recentPosition = (recentPosition + 1) % shortTermSteps;
+    numRecent = jmin (numRecent + 1, shortTermSteps);
+    peak = jmax (peak, step.peak);
+
+    if (numRecent < momentarySteps)
+        return;
+
+    // every step closes a 400 ms block that overlaps the one before by 75%
+    auto blockPower = 0.0;
+
+    for (auto i = 1; i <= momentarySteps; ++i)
+        blockPower += recent[(size_t) ((recentPosition - i + shortTermSteps) % shortTermSteps)];
+
+    blockPower /= momentarySteps;
+    const auto loudness = toLufs (blockPower);
+
+    if (loudness > absoluteGate)
+    {
+        const auto bin = jlimit (0, numBins - 1, (int) ((loudness - absoluteGate) / binWidth));
+        binPower[(size_t) bin] += blockPower;
+        ++binCount[(size_t) bin];
+    }
+}
+
+void LoudnessMeter::Analysis::publish() noexcept
+{
+    const auto meanOfLast = [this] (int numSteps)
+    {
+        auto sum = 0.0;
+
+        for (auto i = 1; i <= numSteps; ++i)
+            sum += recent[(size_t) ((recentPosition - i + shortTermSteps) % shortTermSteps)];
+
+        return sum / numSteps;
+    };
+
+    const auto toReading = [] (double loudness) { return (float) jmax ((double) silence, loudness); };
+
+    momentary.store (numRecent >= momentarySteps ? toReading (toLufs (meanOfLast (momentarySteps))) : silence, std::memory_order_relaxed);
+    shortTerm.store (numRecent > 0 ? toReading (toLufs (meanOfLast (numRecent))) : silence, std::memory_order_relaxed);
+    truePeak.store (peak > 0.0 ? toReading (Decibels::gainToDecibels (peak, -1000.0)) : silence, std::memory_order_relaxed);
+
+    // the relative gate sits 10 LU below the mean of every block over the absolute gate
+    const auto allPower = std::accumulate (binPower.begin(), binPower.end(), 0.0);
+    const auto allCount = std::accumulate (binCount.begin(), binCount.end(), uint64 (0));
+
+    if (allCount == 0)
+    {
+        integrated.store (silence, std::memory_order_relaxed);
+        return;
+    }
+
+    const auto gate = toLufs (allPower / (double) allCount) + relativeGate;
+    auto gatedPower = 0.0;
+    auto gatedCount = uint64 (0);
+
+    // a bin is in when its middle is over the gate
+    for (auto bin = jmax (0, (int) std::floor ((gate - absoluteGate) / binWidth - 0.5) + 1); bin < numBins; ++bin)
+    {
+        gatedPower += binPower[(size_t) bin];
+        gatedCount += binCount[(size_t) bin];
+    }
+
+    integrated.store (gatedCount > 0 ? toReading (toLufs (gatedPower / (double) gatedCount)) : silence, std::memory_order_relaxed);
+}
+
+LoudnessReading LoudnessMeter::Analysis::read() const noexcept
+{
+    return { momentary.load (std::memory_order_relaxed), shortTerm.load (std::memory_order_relaxed),
+             integrated.load (std::memory_order_relaxed), truePeak.load (std::memory_order_relaxed) };
+}
+
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ScratchArena.h"
+#include "TruePeakLimiter.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /** One signal's loudness as ITU-R BS.1770 measures it. */
+    struct LoudnessReading
+    {
+        float momentary = -100.0f;      // LUFS over the last 400 ms
+        float shortTerm = -100.0f;      // LUFS over the last 3 s
+        float integrated = -100.0f;     // LUFS, gated, since the last reset
+        float truePeak = -100.0f;       // dBTP, the highest since the last reset
+    };
+
+    //==============================================================================
+    /** The one thread every loudness meter in the process integrates on. */
+    class LoudnessThread : public TimeSliceThread
+    {
+    public:
+        LoudnessThread() : TimeSliceThread ("Inflation loudness")    { startThread (Thread::Priority::low); }
+        ~LoudnessThread() override                                  { stopThread (1000); }
+    };
+
+    //==============================================================================
+    /*  K-weighted loudness and 4x true peak of the input and the output, after ITU-R
+        BS.1770-4 and EBU R 128.
+
+        The audio thread does the per-sample work: both K-weighting stages (a high shelf
+        and the RLB high pass, in double whatever the host's precision), the weighted sum
+        of squares over every channel (surrounds count +1.5 dB, the LFE not at all) and
+        the true peak through the limiter's interpolator. Every 100 ms it hands one step,
+        the mean power and the peak, to a lock-free FIFO; a step that doesn't fit is
+        dropped, the audio thread never waits.
+
+        The shared loudness thread does the rest: momentary and short-term loudness are
+        the means over the last 4 and 30 steps, and every step closes a 400 ms gating
+        block. Blocks above the absolute gate of -70 LUFS are counted into a histogram of
+        0.1 LU bins, so the relative gate (10 LU below the mean of those) is applied over
+        any length of programme in fixed memory, to within a bin.
+
+        The matching gain for Auto Output is worked out on the audio thread, from the
+        short-term power of the input and of the output with the output gain taken out
+        again, so it follows each step the same way in real time and in a render.
+    */
+    class LoudnessMeter : private TimeSliceClient
+    {
+    public:
+        static constexpr float silence = -100.0f;
+        static constexpr double stepSeconds = 0.1;
+        static constexpr int momentarySteps = 4, shortTermSteps = 30;
+        static constexpr double absoluteGate = -70.0, relativeGate = -10.0;     // LUFS, LU
+        static constexpr double maxMatchingDecibels = 24.0;
+
+        LoudnessMeter();
+        ~LoudnessMeter() override;
+
+        /** Sets up the K-weighting for the sample rate and the channel weights for each
+            bus, and starts every measurement over. Call from prepareToPlay. */
+        void prepare (double sampleRate, const AudioChannelSet& inputLayout, const AudioChannelSet& outputLayout);
+
+        //==============================================================================
+        /** Audio thread: the block as it came in. */
+        template <typename SampleType>
+        void pushInput (const AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+        {
+            measure (input, buffer, numChannels, 1.0);
+        }
+
+        /** Audio thread: the same block as it goes out, and the output gain it got, which
+            the matching gain leaves out. */
+        template <typename SampleType>
+        void pushOutput (const AudioBuffer<SampleType>& buffer, int numChannels, double outputGain) noexcept
+        {
+            measure (output, buffer, numChannels, outputGain);
+            updateMatchingGain();
+        }
+
+        /** Audio thread: the gain that brings the output's short-term loudness, before its
+            output gain, to the input's. Held while either is below the absolute gate. */
+        double getMatchingGain() const noexcept     { return matchingGain; }
+
+        //==============================================================================
+        /** Any thread: the latest readings, as the loudness thread published them. */
+        LoudnessReading getInputReading() const noexcept    { return input.analysis.read(); }
+        LoudnessReading getOutputReading() const noexcept   { return output.analysis.read(); }
+        float getMatchingDecibels() const noexcept          { return matchingDecibels.load (std::memory_order_relaxed); }
+
+        /** Any thread: integrated loudness and the true peak start over. */
+        void resetIntegration() noexcept    { resetRequested.store (true, std::memory_order_relaxed); }
+
+    private:
+        static constexpr int fifoSize = 256;                // steps, 25.6 s, room for a render running far ahead
+        static constexpr int chunkSize = 64;                // samples at a time through the true peak detector
+        static constexpr int historySize = TruePeakDetector<double>::historySize;
+        static constexpr double binWidth = 0.1;             // LU
+        static constexpr int numBins = 1000;                // -70 to +30 LUFS, louder goes in the last
+
+        struct Biquad
+        {
+            double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        };
+
+        struct ChannelState
+        {
+            double shelf1 = 0.0, shelf2 = 0.0, highPass1 = 0.0, highPass2 = 0.0;
+            std::array<double, historySize> history {};     // the true peak detector's last inputs
+        };
+
+        struct Step
+        {
+            double power = 0.0, peak = 0.0;
+            uint32 generation = 0;
+        };
+
+        //==============================================================================
+        /** The loudness thread's side of a signal, and what it publishes. */
+        struct Analysis
+        {
+            void clear() noexcept;
+            void add (const Step& step) noexcept;
+            void publish() noexcept;
+            LoudnessReading read() const noexcept;
+
+            std::array<double, shortTermSteps> recent {};
+            int recentPosition = 0, numRecent = 0;
+            std::array<double, numBins> binPower {};
+            std::array<uint32, numBins> binCount {};
+            double peak = 0.0;
+            uint32 generation = 0;
+
+            std::atomic<float> momentary { silence }, shortTerm { silence }, integrated { silence }, truePeak { silence };
+        };
+
+        /** One signal: the audio thread's filters and sums, the hand over, and the analysis. */
+        struct Signal
+        {
+            void clear() noexcept;
+
+            std::array<ChannelState, maxChannels> channels;
+            std::array<double, maxChannels> weights {};
+            int numChannels = 0;
+
+            // the step being summed; matchPower has the output gain taken out
+            double stepPower = 0.0, stepPeak = 0.0, matchPower = 0.0;
+            int stepPosition = 0;
+
+            // the short-term window the matching gain compares
+            std::array<double, shortTermSteps> recentMatch {};
+            double recentMatchSum = 0.0;
+            int recentMatchPosition = 0, numRecentMatch = 0;
+
+            AbstractFifo fifo { fifoSize };
+            std::array<Step, fifoSize> steps;
+
+            Analysis analysis;
+        };
+
+        template <typename SampleType>
+        void measure (Signal& signal, const AudioBuffer<SampleType>& buffer, int numChannels, double gain) noexcept;
+
+        template <typename SampleType>
+        double measureChunk (Signal& signal, const SampleType* const* channels, int numChannels, int offset, int numSamples,
+                             const TruePeakDetector<SampleType>& detector) noexcept;
+
+        void finishStep (Signal& signal) noexcept;
+        void updateMatchingGain() noexcept;
+
+        static void setWeights (Signal& signal, const AudioChannelSet& layout) noexcept;
+        static double toLufs (double power) noexcept   { return power > 0.0 ? -0.691 + 10.0 * std::log10 (power) : (double) silence; }
+
+        int useTimeSlice() override;
+        void analyse (Signal& signal) noexcept;
+
+        //==============================================================================
+        Biquad shelf, highPass;
+        int stepLength = 4800;
+        uint32 generation = 0;
+        double matchingGain = 1.0;
+
+        Signal input, output;
+        TruePeakDetector<float> floatDetector;
+        TruePeakDetector<double> doubleDetector;
+
+        std::atomic<float> matchingDecibels { 0.0f };
+        std::atomic<bool> resetRequested { false };
+
+        // last, so every meter is gone from the thread before anything it reads
+        SharedResourcePointer<LoudnessThread> thread;
+
+        const TruePeakDetector<float>& getDetector (float) const noexcept     { return floatDetector; }
+        const TruePeakDetector<double>& getDetector (double) const noexcept   { return doubleDetector; }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+    };
+
+    //==============================================================================
+    template <typename SampleType>
+    void LoudnessMeter::measure (Signal& signal, const AudioBuffer<SampleType>& buffer, int numChannels, double gain) noexcept
+    {
+        const auto numSamples = buffer.getNumSamples();
+        const auto* const* channels = buffer.getArrayOfReadPointers();
+        const auto& detector = getDetector (SampleType());
+        const auto unscale = gain > 0.0 ? 1.0 / (gain * gain) : 0.0;
+        numChannels = jmin (numChannels, signal.numChannels);
+
+        for (auto done = 0; done < numSamples;)
+        {
+            const auto length = jmin (chunkSize, numSamples - done, stepLength - signal.stepPosition);
+            const auto power = measureChunk (signal, channels, numChannels, done, length, detector);
+
+            signal.stepPower += power;
+            signal.matchPower += power * unscale;
+            signal.stepPosition += length;
+            done += length;
+
+            if (signal.stepPosition == stepLength)
+                finishStep (signal);
+        }
+    }
+
+    // K-weights and sums the squares, and finds the true peak, for a chunk of every channel
+    template <typename SampleType>
+    double LoudnessMeter::measureChunk (Signal& signal, const SampleType* const* channels, int numChannels, int offset,
+                                        int numSamples, const TruePeakDetector<SampleType>& detector) noexcept
+    {
+        SampleType line[historySize + chunkSize], peaks[chunkSize];
+        auto power = 0.0;
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = signal.channels[(size_t) channel];
+            const auto* samples = channels[channel] + offset;
+            auto s1 = state.shelf1, s2 = state.shelf2, h1 = state.highPass1, h2 = state.highPass2;
+            auto sum = 0.0;
+
+            // transposed direct form II, the shelf into the high pass
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                const auto x = static_cast<double> (samples[i]);
+                const auto shelved = shelf.b0 * x + s1;
+                s1 = shelf.b1 * x - shelf.a1 * shelved + s2;
+                s2 = shelf.b2 * x - shelf.a2 * shelved;
+
+                const auto weighted = shelved + h1;
+                h1 = -2.0 * shelved - highPass.a1 * weighted + h2;
+                h2 = shelved - highPass.a2 * weighted;
+
+                sum += weighted * weighted;
+            }
+
+            // a NaN or Inf would stay in the filters for good, so the channel starts over and the chunk doesn't count
+            if (! std::isfinite (sum))
+            {
+                state = {};
+                continue;
+            }
+
+            state.shelf1 = s1;
+            state.shelf2 = s2;
+            state.highPass1 = h1;
+            state.highPass2 = h2;
+            power += signal.weights[(size_t) channel] * sum;
+
+            // the detector reads the history in front of the chunk, which then becomes its end
+            std::transform (state.history.begin(), state.history.end(), line, [] (double x) { return static_cast<SampleType> (x); });
+            std::copy (samples, samples + numSamples, line + historySize);
+            std::fill (peaks, peaks + numSamples, SampleType (0));
+            detector.detect (line, peaks, numSamples);
+
+            std::transform (line + numSamples, line + numSamples + historySize, state.history.begin(),
+                            [] (SampleType x) { return static_cast<double> (x); });
+            signal.stepPeak = jmax (signal.stepPeak, static_cast<double> (*std::max_element (peaks, peaks + numSamples)));
+        }
+
+        return power;
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoudnessMeter.h"
+
+namespace Gui {
+
+    //==============================================================================
+    /*  The loudness meter's readings as two rows of numbers, input above output, with
+        Auto Output and the gain it applies on the right, and a button that starts the
+        integration over. Repaints only when a reading changed by what it shows.
+    */
+    class LoudnessPanel : public Component
+    {
+    public:
+        LoudnessPanel (Dsp::LoudnessMeter& meterToShow, AudioProcessorValueTreeState& state)
+            : meter (meterToShow),
+              autoOutput (*state.getRawParameterValue ("autoOutput")),
+              autoOutputAttachment (state, "autoOutput", autoOutputButton)
+        {
+            addAndMakeVisible (autoOutputButton);
+            addAndMakeVisible (resetButton);
+            resetButton.onClick = [this] { meter.resetIntegration(); };
+        }
+
+        /** Takes the latest readings. Called on every display refresh. */
+        void update()
+        {
+            const auto text = std::make_tuple (describe ("In", meter.getInputReading()), describe ("Out", meter.getOutputReading()),
+                                               autoOutput.load (std::memory_order_relaxed) >= 0.5f
+                                                   ? String (meter.getMatchingDecibels(), 1) + " dB" : String());
+
+            if (text != shown)
+            {
+                shown = text;
+                repaint();
+            }
+        }
+
+        void paint (Graphics& g) override
+        {
+            auto bounds = getTextArea();
+            g.setColour (findColour (Label::textColourId));
+            g.setFont (Font (Font::getDefaultMonospacedFontName(), 13.0f, Font::plain));
+
+            g.drawText (std::get<0> (shown), bounds.removeFromTop (bounds.getHeight() / 2), Justification::centredLeft);
+            g.drawText (std::get<1> (shown), bounds, Justification::centredLeft);
+
+            g.drawText (std::get<2> (shown), getLocalBounds().removeFromRight (controlsWidth).removeFromBottom (getHeight() / 2),
+                        Justification::centredRight);
+        }
+
+        void resized() override
+        {
+            auto controls = getLocalBounds().removeFromRight (controlsWidth);
+            auto top = controls.removeFromTop (getHeight() / 2);
+            resetButton.setBounds (top.removeFromRight (50).reduced (0, 1));
+            autoOutputButton.setBounds (top);
+        }
+
+    private:
+        static constexpr int controlsWidth = 160;
+
+        Rectangle<int> getTextArea() const      { return getLocalBounds().withTrimmedRight (controlsWidth); }
+
+        // M, S and I in LUFS, then the true peak; nothing under the absolute gate shows a number
+        static String describe (const String& name, const Dsp::LoudnessReading& reading)
+        {
+            const auto format = [] (float value, float floor)
+            {
+                return (value > floor ? String (value, 1) : String ("-inf")).paddedLeft (' ', 6);
+            };
+
+            const auto gate = (float) Dsp::LoudnessMeter::absoluteGate;
+
+            return name.paddedRight (' ', 4) + "M" + format (reading.momentary, gate) + "  S" + format (reading.shortTerm, gate)
+                 + "  I" + format (reading.integrated, gate) + " LUFS   TP" + format (reading.truePeak, Dsp::LoudnessMeter::silence) + " dBTP";
+        }
+
+        Dsp::LoudnessMeter& meter;
+        std::atomic<float>& autoOutput;
+        std::tuple<String, String, String> shown;
+
+        ToggleButton autoOutputButton { "Auto Output" };
+        TextButton resetButton { "Reset" };
+        AudioProcessorValueTreeState::ButtonAttachment autoOutputAttachment;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessPanel)
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    struct MeterReading
+    {
+        float rms = -100.0f;        // dB, with the meter's release applied
+        float peak = -100.0f;       // dB, highest since the last read
+        uint32 clipCount = 0;       // blocks that went over 0 dBFS since prepare()
+    };
+
+    //==============================================================================
+    /*  Level meter values handed from the audio thread to the editor.
+
+        Every channel is a handful of independent atomics in a fixed array, so neither
+        thread ever locks or allocates. The release ballistics are only ever touched by
+        the audio thread; the editor just reads the published values.
+    */
+    template <int maxChannels>
+    class MeterBus
+    {
+    public:
+        static constexpr float silence = -100.0f;
+
+        /** Called from prepareToPlay with the number of channels the bus really has. */
+        void prepare (double sampleRate, int numChannelsInUse) noexcept
+        {
+            for (auto& channel : channels)
+            {
+                channel.ballistics.reset (sampleRate, 0.5);
+                channel.clipCount.store (0, std::memory_order_relaxed);
+            }
+
+            reset();
+            numChannels.store (jlimit (0, maxChannels, numChannelsInUse), std::memory_order_release);
+        }
+
+        void reset() noexcept
+        {
+            for (auto& channel : channels)
+            {
+                channel.ballistics.setCurrentAndTarget (silence);
+                channel.rms.store (silence, std::memory_order_relaxed);
+                channel.peak.store (silence, std::memory_order_relaxed);
+            }
+        }
+
+        //==============================================================================
+        /** Audio thread: publishes one block's RMS and peak for a channel, both in dB. */
+        void push (int channel, float rmsDb, float peakDb, int numSamples) noexcept
+        {
+            jassert (isPositiveAndBelow (channel, maxChannels));
+            auto& meter = channels[(size_t) channel];
+
+            meter.ballistics.advance (numSamples);
+
+            if (rmsDb < meter.ballistics.getCurrentValue())
+                meter.ballistics.setTarget (rmsDb); // smooth down
+            else
+                meter.ballistics.setCurrentAndTarget (rmsDb); // immediate set to target
+
+            meter.rms.store (static_cast<float> (meter.ballistics.getCurrentValue()), std::memory_order_relaxed);
+
+            // keep the highest peak until the editor collects it
+            auto previousPeak = meter.peak.load (std::memory_order_relaxed);
+
+            while (peakDb > previousPeak
+                    && ! meter.peak.compare_exchange_weak (previousPeak, peakDb, std::memory_order_relaxed))
+            {
+            }
+
+            if (peakDb > 0.0f)
+                meter.clipCount.fetch_add (1, std::memory_order_relaxed);
+        }
+
+        //==============================================================================
+        /** Message thread: reads a channel, collecting the peak held since the last read. */
+        MeterReading read (int channel) noexcept
+        {
+            jassert (isPositiveAndBelow (channel, maxChannels));
+            auto& meter = channels[(size_t) channel];
+
+            MeterReading reading;
+            reading.rms = meter.rms.load (std::memory_order_relaxed);
+            reading.peak = meter.peak.exchange (silence, std::memory_order_relaxed);
+            reading.clipCount = meter.clipCount.load (std::memory_order_relaxed);
+            return reading;
+        }
+
+        int getNumChannels() const noexcept     { return numChannels.load (std::memory_order_acquire); }
+
+    private:
+        struct Channel
+        {
+            LinearRamp ballistics;
+            std::atomic<float> rms { silence }, peak { silence };
+            std::atomic<uint32> clipCount { 0 };
+        };
+
+        std::array<Channel, maxChannels> channels;
+        std::atomic<int> numChannels { 0 };
+    };
+}
@@ -0,0 +1,221 @@
+#include "Oversampler.h"
+
+namespace Dsp {
+
+namespace {
+
+    //==============================================================================
+    // Vectorised across outputs rather than taps: every tap is one broadcast multiply-add
+    // into a whole register of outputs, so there is no horizontal sum per sample.
+    template <typename Vec, typename FloatType>
+    inline void convolve (const FloatType* input, const FloatType* coefficients, int numTaps,
+                          FloatType* output, int numOutputs) noexcept
+    {
+        auto m = 0;
+
+        for (; m + 2 * Vec::size <= numOutputs; m += 2 * Vec::size)
+        {
+            auto sum0 = Vec::broadcast (0);
+            auto sum1 = Vec::broadcast (0);
+
+            for (auto t = 0; t < numTaps; ++t)
+            {
+                const auto c = Vec::broadcast (coefficients[t]);
+                sum0 = Vec::mulAdd (Vec::load (input + m + t), c, sum0);
+                sum1 = Vec::mulAdd (Vec::load (input + m + t + Vec::size), c, sum1);
+            }
+
+            Vec::store (output + m, sum0);
+            Vec::store (output + m + Vec::size, sum1);
+        }
+
+        for (; m < numOutputs; ++m)
+        {
+            FloatType sum = 0;
+
+            for (auto t = 0; t < numTaps; ++t)
+                sum += input[m + t] * coefficients[t];
+
+            output[m] = sum;
+        }
+    }
+
+    //==============================================================================
+    template <typename FloatType>
+    using ConvolveFunction = void (*) (const FloatType*, const FloatType*, int, FloatType*, int) noexcept;
+
+    void convolveScalarFloat  (const float* i, const float* c, int t, float* o, int n) noexcept    { convolve<ScalarVec<float>> (i, c, t, o, n); }
+    void convolveScalarDouble (const double* i, const double* c, int t, double* o, int n) noexcept { convolve<ScalarVec<double>> (i, c, t, o, n); }
+
+   #if JUCE_INTEL
+    void convolveSse2Float  (const float* i, const float* c, int t, float* o, int n) noexcept    { convolve<Sse2Float> (i, c, t, o, n); }
+    void convolveSse2Double (const double* i, const double* c, int t, double* o, int n) noexcept { convolve<Sse2Double> (i, c, t, o, n); }
+
+    INFLATION_KERNEL ("avx2,fma") void convolveAvx2Float  (const float* i, const float* c, int t, float* o, int n) noexcept    { convolve<Avx2Float> (i, c, t, o, n); }
+    INFLATION_KERNEL ("avx2,fma") void convolveAvx2Double (const double* i, const double* c, int t, double* o, int n) noexcept { convolve<Avx2Double> (i, c, t, o, n); }
+
+    INFLATION_KERNEL ("avx512f") void convolveAvx512Float  (const float* i, const float* c, int t, float* o, int n) noexcept    { convolve<Avx512Float> (i, c, t, o, n); }
+    INFLATION_KERNEL ("avx512f") void convolveAvx512Double (const double* i, const double* c, int t, double* o, int n) noexcept { convolve<Avx512Double> (i, c, t, o, n); }
+   #endif
+
+    //==============================================================================
+    struct Kernels
+    {
+        ConvolveFunction<float>  convolveFloat  = convolveScalarFloat;
+        ConvolveFunction<double> convolveDouble = convolveScalarDouble;
+    };
+
+    Kernels selectKernels (Isa isa) noexcept
+    {
+        Kernels kernels;
+
+        switch (isa)
+        {
+           #if JUCE_INTEL
+            case Isa::avx512:
+                kernels.convolveFloat  = convolveAvx512Float;
+                kernels.convolveDouble = convolveAvx512Double;
+                break;
+
+            case Isa::avx2:
+                kernels.convolveFloat  = convolveAvx2Float;
+                kernels.convolveDouble = convolveAvx2Double;
+                break;
+
+            case Isa::sse2:
+                kernels.convolveFloat  = convolveSse2Float;
+                kernels.convolveDouble = convolveSse2Double;
+                break;
+           #endif
+
+            case Isa::scalar:
+            default:
+                break;
+        }
+
+        return kernels;
+    }
+
+    // picked while the library loads, so the audio thread never takes a static's guard for it
+    const Kernels kernels = selectKernels (detectIsa());
+
+    const Kernels& getKernels() noexcept
+    {
+        return kernels;
+    }
+
+    //==============================================================================
+    double besselI0 (double x)
+    {
+        auto sum = 1.0, term = 1.0;
+
+        for (auto k = 1; term > 1.0e-12 * sum; ++k)
+        {
+            const auto half = x / (2.0 * k);
+            term *= half * half;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // elliptic half-band design after Valenzuela & Constantinides, as used by HIIR
+    double iirNumeratorSum (double q, int order, int c)
+    {
+        auto result = 0.0, current = 0.0;
+        auto sign = 1;
+
+        for (auto i = 0; i == 0 || std::abs (current) > 1.0e-100; ++i, sign = -sign)
+        {
+            current = std::pow (q, i * (i + 1)) * std::sin ((i * 2 + 1) * c * MathConstants<double>::pi / order) * sign;
+            result += current;
+        }
+
+        return result;
+    }
+
+    double iirDenominatorSum (double q, int order, int c)
+    {
+        auto result = 0.0, current = 0.0;
+        auto sign = -1;
+
+        for (auto i = 1; i == 1 || std::abs (current) > 1.0e-100; ++i, sign = -sign)
+        {
+            current = std::pow (q, i * i) * std::cos (i * 2 * c * MathConstants<double>::pi / order) * sign;
+            result += current;
+        }
+
+        return result;
+    }
+}
+
+//==============================================================================
+std::vector<double> HalfBand::designFir (int numOddTaps, double kaiserBeta)
+{
+    jassert (numOddTaps > 0 && numOddTaps % 2 == 0);
+
+    // h[n] = sinc (n / 2) / 2 windowed, non zero for n = 0 and odd n only. Odd tap t sits
+    // at n = 2t - numOddTaps + 1, so the set is symmetric and needs no reversing.
+    const auto halfLength = static_cast<double> (numOddTaps);
+    std::vector<double> taps;
+
+    for (auto t = 0; t < numOddTaps; ++t)
+    {
+        const auto n = static_cast<double> (2 * t - numOddTaps + 1);
+        const auto sinc = std::sin (MathConstants<double>::halfPi * n) / (MathConstants<double>::pi * n);
+        taps.push_back (sinc * kaiser (n / halfLength, kaiserBeta));
+    }
+
+    // normalise the DC gain of the odd phase to exactly 0.5, matching the centre tap
+    auto sum = 0.0;
+
+    for (auto tap : taps)
+        sum += tap;
+
+    for (auto& tap : taps)
+        tap *= 0.5 / sum;
+
+    return taps;
+}
+
+double HalfBand::kaiser (double ratio, double beta)
+{
+    return besselI0 (beta * std::sqrt (jmax (0.0, 1.0 - ratio * ratio))) / besselI0 (beta);
+}
+
+std::vector<double> HalfBand::designIir (int numCoefficients, double transitionBandwidth)
+{
+    const auto order = numCoefficients * 2 + 1;
+
+    auto k = std::tan ((1.0 - transitionBandwidth * 2.0) * MathConstants<double>::pi / 4.0);
+    k *= k;
+    const auto kSqrt = std::pow (1.0 - k * k, 0.25);
+    const auto e = 0.5 * (1.0 - kSqrt) / (1.0 + kSqrt);
+    const auto e4 = e * e * e * e;
+    const auto q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+    std::vector<double> coefficients;
+
+    for (auto index = 0; index < numCoefficients; ++index)
+    {
+        const auto c = index + 1;
+        const auto ww = iirNumeratorSum (q, order, c) * std::pow (q, 0.25) / (iirDenominatorSum (q, order, c) + 0.5);
+        const auto wwSquared = ww * ww;
+        const auto x = std::sqrt ((1.0 - wwSquared * k) * (1.0 - wwSquared / k)) / (1.0 + wwSquared);
+        coefficients.push_back ((1.0 - x) / (1.0 + x));
+    }
+
+    return coefficients;
+}
+
+void HalfBand::convolve (const float* input, const float* coefficients, int numTaps, float* output, int numOutputs) noexcept
+{
+    getKernels().convolveFloat (input, coefficients, numTaps, output, numOutputs);
+}
+
+void HalfBand::convolve (const double* input, const double* coefficients, int numTaps, double* output, int numOutputs) noexcept
+{
+    getKernels().convolveDouble (input, coefficients, numTaps, output, numOutputs);
+}
+
+}
@@ -0,0 +1,473 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VectorIsa.h"
+#include "ScratchArena.h"
+#include "SharedResources.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  Filter design and the vectorised inner loop shared by every half-band stage.
+        The design functions run on the message thread from prepare().
+    */
+    struct HalfBand
+    {
+        /** Odd-phase taps of a Kaiser windowed half-band FIR, the centre tap being 0.5. */
+        static std::vector<double> designFir (int numOddTaps, double kaiserBeta);
+
+        /** The Kaiser window at ratio -1 to 1 of its half length. */
+        static double kaiser (double ratio, double beta);
+
+        /** Allpass coefficients of a polyphase IIR half-band (two paths, interleaved). */
+        static std::vector<double> designIir (int numCoefficients, double transitionBandwidth);
+
+        /** output[m] = sum of coefficients[t] * input[m + t], for numOutputs outputs. */
+        static void convolve (const float* input, const float* coefficients, int numTaps, float* output, int numOutputs) noexcept;
+        static void convolve (const double* input, const double* coefficients, int numTaps, double* output, int numOutputs) noexcept;
+    };
+
+    //==============================================================================
+    /*  Cascaded 2x half-band resampler, up to 16x.
+
+        The linear phase filters are polyphase FIRs: only the odd phase is convolved, the
+        even phase is a plain delay. The zero latency filters are polyphase allpass IIRs.
+        All stages and buffers for 16x are taken from the arena in prepare(), so switching
+        factor or filter on the audio thread never allocates. The coefficients are only
+        read, so one copy serves every instance.
+    */
+    template <typename FloatType>
+    class Oversampler
+    {
+    public:
+        enum class Filter
+        {
+            linearPhase = 0,
+            zeroLatency
+        };
+
+        static constexpr int maxOrder = 4;
+
+        //==============================================================================
+        /** The filters of every stage. They don't depend on the sample rate, so every
+            instance in the process shares one design. */
+        struct Kernels
+        {
+            std::array<std::vector<FloatType>, maxOrder> firUp, firDown, iir;
+
+            static Kernels design()
+            {
+                Kernels kernels;
+
+                for (auto stage = 0; stage < maxOrder; ++stage)
+                {
+                    // the first stage needs the steep transition, later ones only have to
+                    // keep their images out of the band the first stage passes; with the
+                    // centre tap that's 95 taps (47 samples of latency at 2x), then 23
+                    const auto oddTaps = stage == 0 ? 48 : 12;
+                    const auto numIirCoefficients = stage == 0 ? 10 : 4;
+                    const auto transition = stage == 0 ? 0.035 : 0.2;
+
+                    for (auto c : HalfBand::designFir (oddTaps, 10.0))
+                    {
+                        kernels.firUp[stage].push_back (static_cast<FloatType> (2.0 * c));
+                        kernels.firDown[stage].push_back (static_cast<FloatType> (c));
+                    }
+
+                    for (auto c : HalfBand::designIir (numIirCoefficients, transition))
+                        kernels.iir[stage].push_back (static_cast<FloatType> (c));
+                }
+
+                return kernels;
+            }
+
+            size_t getSizeInBytes() const noexcept
+            {
+                auto bytes = sizeof (Kernels);
+
+                for (auto stage = 0; stage < maxOrder; ++stage)
+                    bytes += (firUp[stage].capacity() + firDown[stage].capacity() + iir[stage].capacity()) * sizeof (FloatType);
+
+                return bytes;
+            }
+        };
+
+        Oversampler()
+            : kernels (SharedCache<int, Kernels>::get (maxOrder, &Kernels::design))
+        {
+        }
+
+        /** Takes the buffers for blocks of up to maxBlockSize samples, and of no more than
+            maxOversampledBlockSize once oversampled. Call from the arena's layout function. */
+        void prepare (ScratchArena& arena, int numChannelsToUse, int maxBlockSize, int maxOversampledBlockSize)
+        {
+            jassert (numChannelsToUse <= maxChannels);
+
+            numChannels = jmin (numChannelsToUse, maxChannels);
+            maxSamples = maxBlockSize;
+            maxOversampledSamples = maxOversampledBlockSize;
+
+            for (auto channel = 0; channel < numChannels; ++channel)
+            {
+                auto& state = channels[(size_t) channel];
+
+                for (auto stage = 0; stage < maxOrder; ++stage)
+                {
+                    const auto numTaps = static_cast<int> (kernels->firUp[stage].size());
+                    const auto stageInput = jmin (maxBlockSize << stage, maxOversampledBlockSize / 2);
+
+                    state.buffers[stage] = arena.take<FloatType> (stageInput * 2);
+                    state.fir[stage].up = arena.take<FloatType> (stageInput + numTaps - 1);
+                    state.fir[stage].downOdd = arena.take<FloatType> (stageInput + numTaps - 1);
+                    state.fir[stage].downEven = arena.take<FloatType> (stageInput + numTaps / 2 - 1);
+                    state.fir[stage].odd = arena.take<FloatType> (stageInput);
+                }
+
+                state.padDelay = arena.take<FloatType> (1 << maxOrder);
+            }
+
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+            {
+                auto& state = channels[(size_t) channel];
+
+                for (auto& fir : state.fir)
+                {
+                    fir.up.clear();
+                    fir.downOdd.clear();
+                    fir.downEven.clear();
+                }
+
+                for (auto& iir : state.iir)
+                    iir = {};
+
+                state.padDelay.clear();
+                state.padPosition = 0;
+            }
+        }
+
+        /** order 0 bypasses, 1 to 4 select 2x to 16x. Clears the filter state when it changes. */
+        void setOrder (int newOrder, Filter newFilter) noexcept
+        {
+            newOrder = jlimit (0, maxOrder, newOrder);
+
+            if (newOrder == order && newFilter == filter)
+                return;
+
+            order = newOrder;
+            filter = newFilter;
+            updateLatency();
+            reset();
+        }
+
+        int getOrder() const noexcept           { return order; }
+        int getFactor() const noexcept          { return 1 << order; }
+        Filter getFilter() const noexcept       { return filter; }
+
+        /** Whole base rate samples between input and output, zero for the IIR filters. */
+        int getLatencyInSamples() const noexcept  { return latency; }
+
+        /** The latency of the longest setting, for sizing delay compensation. */
+        int getMaxLatencyInSamples() const noexcept
+        {
+            auto pad = 0;
+            return computeLatency (maxOrder, Filter::linearPhase, pad);
+        }
+
+        //==============================================================================
+        /** Upsamples one channel and returns the oversampled block, numSamples * getFactor() long. */
+        FloatType* processUp (int channel, const FloatType* input, int numSamples) noexcept
+        {
+            jassert (order > 0 && numSamples <= maxSamples && (numSamples << order) <= maxOversampledSamples);
+            auto& state = channels[static_cast<size_t> (channel)];
+
+            for (auto stage = 0; stage < order; ++stage)
+            {
+                auto* output = state.buffers[stage].data();
+
+                if (filter == Filter::linearPhase)
+                    upFir (state.fir[stage], kernels->firUp[stage], input, output, numSamples << stage);
+                else
+                    upIir (state.iir[stage], kernels->iir[stage], input, output, numSamples << stage);
+
+                input = output;
+            }
+
+            auto* oversampled = state.buffers[order - 1].data();
+
+            if (padLength > 0)
+                delayTopRate (state, oversampled, numSamples << order);
+
+            return oversampled;
+        }
+
+        /** Filters the block returned by processUp back down to the base rate into output. */
+        void processDown (int channel, FloatType* output, int numSamples) noexcept
+        {
+            auto& state = channels[static_cast<size_t> (channel)];
+
+            for (auto stage = order; --stage >= 0;)
+            {
+                const auto* input = state.buffers[stage].data();
+                auto* destination = stage > 0 ? state.buffers[stage - 1].data() : output;
+
+                if (filter == Filter::linearPhase)
+                    downFir (state.fir[stage], kernels->firDown[stage], input, destination, numSamples << stage);
+                else
+                    downIir (state.iir[stage], kernels->iir[stage], input, destination, numSamples << stage);
+            }
+        }
+
+    private:
+        //==============================================================================
+        struct FirState
+        {
+            // each holds numTaps - 1 samples of history followed by the new block
+            ArenaArray<FloatType> up, downOdd, downEven, odd;
+        };
+
+        struct IirState
+        {
+            static constexpr int maxCoefficients = 16;
+            FloatType upX[maxCoefficients] {}, upY[maxCoefficients] {};
+            FloatType downX[maxCoefficients] {}, downY[maxCoefficients] {};
+        };
+
+        struct Channel
+        {
+            std::array<ArenaArray<FloatType>, maxOrder> buffers;
+            std::array<FirState, maxOrder> fir;
+            std::array<IirState, maxOrder> iir;
+            ArenaArray<FloatType> padDelay;
+            int padPosition = 0;
+        };
+
+        //==============================================================================
+        static void upFir (FirState& state, const std::vector<FloatType>& coefficients,
+                           const FloatType* input, FloatType* output, int numSamples) noexcept
+        {
+            const auto numTaps = static_cast<int> (coefficients.size());
+            const auto history = numTaps - 1;
+            auto* work = state.up.data();
+            auto* odd = state.odd.data();
+
+            std::copy (input, input + numSamples, work + history);
+            HalfBand::convolve (work, coefficients.data(), numTaps, odd, numSamples);
+
+            // the even phase is the centre tap, i.e. the input delayed by half the taps
+            const auto* even = work + numTaps / 2 - 1;
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                output[2 * i]     = even[i];
+                output[2 * i + 1] = odd[i];
+            }
+
+            std::copy (work + numSamples, work + numSamples + history, work);
+        }
+
+        static void downFir (FirState& state, const std::vector<FloatType>& coefficients,
+                             const FloatType* input, FloatType* output, int numSamples) noexcept
+        {
+            const auto numTaps = static_cast<int> (coefficients.size());
+            const auto oddHistory = numTaps - 1;
+            const auto evenHistory = numTaps / 2 - 1;
+            auto* odd = state.downOdd.data();
+            auto* even = state.downEven.data();
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                even[evenHistory + i] = input[2 * i];
+                odd[oddHistory + i]   = input[2 * i + 1];
+            }
+
+            HalfBand::convolve (odd, coefficients.data(), numTaps, output, numSamples);
+
+            for (auto i = 0; i < numSamples; ++i)
+                output[i] += FloatType (0.5) * even[i];
+
+            std::copy (odd + numSamples, odd + numSamples + oddHistory, odd);
+            std::copy (even + numSamples, even + numSamples + evenHistory, even);
+        }
+
+        //==============================================================================
+        // first order allpasses y = c * (x - y') + x', alternating between the two paths
+        static forcedinline void allpassPair (const std::vector<FloatType>& coefficients,
+                                              FloatType* x, FloatType* y,
+                                              FloatType& path0, FloatType& path1) noexcept
+        {
+            const auto numCoefficients = static_cast<int> (coefficients.size());
+
+            for (auto i = 0; i < numCoefficients; i += 2)
+            {
+                const auto out0 = (path0 - y[i]) * coefficients[(size_t) i] + x[i];
+                x[i] = path0;
+                y[i] = out0;
+                path0 = out0;
+
+                if (i + 1 < numCoefficients)
+                {
+                    const auto out1 = (path1 - y[i + 1]) * coefficients[(size_t) i + 1] + x[i + 1];
+                    x[i + 1] = path1;
+                    y[i + 1] = out1;
+                    path1 = out1;
+                }
+            }
+        }
+
+        static void upIir (IirState& state, const std::vector<FloatType>& coefficients,
+                           const FloatType* input, FloatType* output, int numSamples) noexcept
+        {
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                auto path0 = input[i];
+                auto path1 = input[i];
+                allpassPair (coefficients, state.upX, state.upY, path0, path1);
+                output[2 * i]     = path0;
+                output[2 * i + 1] = path1;
+            }
+        }
+
+        static void downIir (IirState& state, const std::vector<FloatType>& coefficients,
+                             const FloatType* input, FloatType* output, int numSamples) noexcept
+        {
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                auto path0 = input[2 * i + 1];
+                auto path1 = input[2 * i];
+                allpassPair (coefficients, state.downX, state.downY, path0, path1);
+                output[i] = FloatType (0.5) * (path0 + path1);
+            }
+        }
+
+        //==============================================================================
+        // pads the top rate signal so the round trip is a whole number of base samples
+        void delayTopRate (Channel& state, FloatType* data, int numSamples) noexcept
+        {
+            auto* line = state.padDelay.data();
+            auto position = state.padPosition;
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                const auto delayed = line[position];
+                line[position] = data[i];
+                data[i] = delayed;
+
+                if (++position == padLength)
+                    position = 0;
+            }
+
+            state.padPosition = position;
+        }
+
+        void updateLatency() noexcept
+        {
+            latency = computeLatency (order, filter, padLength);
+        }
+
+        int computeLatency (int forOrder, Filter forFilter, int& pad) const noexcept
+        {
+            pad = 0;
+
+            if (forFilter != Filter::linearPhase || forOrder == 0)
+                return 0;
+
+            // each stage delays by numTaps - 1 samples at its own high rate (up plus down)
+            auto topRateDelay = 0;
+
+            for (auto stage = 0; stage < forOrder; ++stage)
+            {
+                const auto fullLength = 2 * static_cast<int> (kernels->firUp[stage].size()) - 1;
+                topRateDelay += (fullLength - 1) << (forOrder - stage - 1);
+            }
+
+            const auto factor = 1 << forOrder;
+            pad = (factor - topRateDelay % factor) % factor;
+            return (topRateDelay + pad) / factor;
+        }
+
+        //==============================================================================
+        typename SharedCache<int, Kernels>::Handle kernels;
+        std::array<Channel, maxChannels> channels;
+
+        int numChannels = 0, maxSamples = 0, maxOversampledSamples = 0;
+        int order = 0;
+        Filter filter = Filter::linearPhase;
+        int latency = 0, padLength = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+    };
+
+    //==============================================================================
+    /** Delays the dry signal by the wet path's latency so the two stay aligned when mixed. */
+    template <typename FloatType>
+    class DelayCompensation
+    {
+    public:
+        /** Call from the arena's layout function. */
+        void prepare (ScratchArena& arena, int numChannelsToUse, int maxDelayInSamples)
+        {
+            jassert (numChannelsToUse <= maxChannels);
+
+            numChannels = jmin (numChannelsToUse, maxChannels);
+            capacity = maxDelayInSamples + 1;
+            delay = jmin (delay, maxDelayInSamples);
+
+            for (auto channel = 0; channel < numChannels; ++channel)
+                lines[(size_t) channel] = arena.take<FloatType> (capacity);
+
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+                lines[(size_t) channel].clear();
+
+            positions.fill (0);
+        }
+
+        void setDelay (int newDelay) noexcept
+        {
+            jassert (newDelay < capacity);
+
+            if (newDelay != delay)
+            {
+                delay = jlimit (0, capacity - 1, newDelay);
+                reset();
+            }
+        }
+
+        void process (int channel, FloatType* data, int numSamples) noexcept
+        {
+            if (delay == 0)
+                return;
+
+            auto* line = lines[static_cast<size_t> (channel)].data();
+            auto& position = positions[static_cast<size_t> (channel)];
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                line[position] = data[i];
+                auto readPosition = position - delay;
+
+                if (readPosition < 0)
+                    readPosition += capacity;
+
+                data[i] = line[readPosition];
+
+                if (++position == capacity)
+                    position = 0;
+            }
+        }
+
+    private:
+        std::array<ArenaArray<FloatType>, maxChannels> lines;
+        std::array<int, maxChannels> positions {};
+        int numChannels = 0, capacity = 1, delay = 0;
+    };
+}
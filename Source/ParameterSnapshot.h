@@ -0,0 +1,276 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+
+    //==============================================================================
+    /** Band Split takes 2 to 6 bands, so up to 5 crossovers. */
+    constexpr int maxBands = 6;
+    constexpr int maxCrossovers = maxBands - 1;
+
+    /** Where the crossovers start, lowest first. The first two are the old fixed three band split's. */
+    constexpr float defaultCrossovers[maxCrossovers] = { 240.0f, 2400.0f, 5000.0f, 8000.0f, 12000.0f };
+
+    //==============================================================================
+    /** Every parameter's ID. The binary state stores the values in this order, so new
+        parameters go at the end. */
+    constexpr const char* parameterIds[] = { "preGain", "postGain", "mix", "curve", "zeroClip", "bandSplit",
+                                             "oversampling", "oversamplingFilter", "truePeakLimit",
+                                             "bands",
+                                             "crossover1", "crossover2", "crossover3", "crossover4", "crossover5",
+                                             "bandCurve1", "bandCurve2", "bandCurve3", "bandCurve4", "bandCurve5", "bandCurve6",
+                                             "bandClip1", "bandClip2", "bandClip3", "bandClip4", "bandClip5", "bandClip6",
+                                             "adaa", "renderQuality", "autoOutput" };
+
+    constexpr int numParameters = (int) std::size (parameterIds);
+
+    // where the per crossover and per band parameters start in parameterIds
+    constexpr int firstCrossoverParameter = 10;
+    constexpr int firstBandCurveParameter = firstCrossoverParameter + maxCrossovers;
+    constexpr int firstBandClipParameter = firstBandCurveParameter + maxBands;
+    constexpr int adaaParameter = firstBandClipParameter + maxBands;
+    constexpr int renderQualityParameter = adaaParameter + 1;
+    constexpr int autoOutputParameter = renderQualityParameter + 1;
+
+    static_assert (autoOutputParameter + 1 == numParameters, "parameterIds and the band parameters disagree");
+
+    /** The parameters as they hold them, in their own units and in parameterIds order. */
+    using RawParameterValues = std::array<float, (size_t) numParameters>;
+
+    //==============================================================================
+    /** Plain copy of every parameter, taken once at the start of a block. */
+    struct ParameterSnapshot
+    {
+        float preGain = 0.0f;           // dB
+        float postGain = 0.0f;          // dB
+        float mix = 1.0f;               // 0 to 1
+        float curve = 0.0f;             // -50 to 50
+        bool zeroClip = true;
+        bool bandSplit = false;
+        int oversampling = 0;           // 0 = off, 1 to 4 = 2x to 16x
+        int oversamplingFilter = 0;     // 0 = linear phase, 1 = zero latency
+        int truePeakLimit = 0;          // 0 = off, 1 to 3 = ceiling of -0.1, -0.3 or -1 dBTP
+
+        // Band Split: the first numBands - 1 crossovers are used, each band's curve is Curve plus
+        // its own offset, and a band is clipped when both Zero Clip and its own clip are on
+        int numBands = 3;
+        std::array<float, maxCrossovers> crossovers { defaultCrossovers[0], defaultCrossovers[1], defaultCrossovers[2],
+                                                      defaultCrossovers[3], defaultCrossovers[4] };     // Hz
+        std::array<float, maxBands> bandCurves {};                                                      // -50 to 50
+        std::array<bool, maxBands> bandClips { true, true, true, true, true, true };
+
+        bool adaa = false;              // antiderivative anti-aliasing of the shaper
+        int renderQuality = 0;          // offline renders: 0 = as playback, 1 = best
+        bool autoOutput = false;        // output loudness matched to the input's, Output is then an offset
+
+        static ParameterSnapshot fromRawValues (const RawParameterValues& values) noexcept
+        {
+            ParameterSnapshot snapshot;
+            snapshot.preGain            = values[0];
+            snapshot.postGain           = values[1];
+            snapshot.mix                = values[2] / 100.0f;
+            snapshot.curve              = values[3];
+            snapshot.zeroClip           = values[4] >= 0.5f;
+            snapshot.bandSplit          = values[5] >= 0.5f;
+            snapshot.oversampling       = roundToInt (values[6]);
+            snapshot.oversamplingFilter = roundToInt (values[7]);
+            snapshot.truePeakLimit      = roundToInt (values[8]);
+            snapshot.numBands           = jlimit (2, maxBands, roundToInt (values[9]));
+
+            for (size_t i = 0; i < (size_t) maxCrossovers; ++i)
+                snapshot.crossovers[i] = values[(size_t) firstCrossoverParameter + i];
+
+            for (size_t i = 0; i < (size_t) maxBands; ++i)
+            {
+                snapshot.bandCurves[i] = values[(size_t) firstBandCurveParameter + i];
+                snapshot.bandClips[i]  = values[(size_t) firstBandClipParameter + i] >= 0.5f;
+            }
+
+            snapshot.adaa = values[(size_t) adaaParameter] >= 0.5f;
+            snapshot.renderQuality = roundToInt (values[(size_t) renderQualityParameter]);
+            snapshot.autoOutput = values[(size_t) autoOutputParameter] >= 0.5f;
+
+            return snapshot;
+        }
+
+        RawParameterValues toRawValues() const noexcept
+        {
+            RawParameterValues values { preGain, postGain, mix * 100.0f, curve, zeroClip ? 1.0f : 0.0f, bandSplit ? 1.0f : 0.0f,
+                                        (float) oversampling, (float) oversamplingFilter, (float) truePeakLimit, (float) numBands };
+
+            for (size_t i = 0; i < (size_t) maxCrossovers; ++i)
+                values[(size_t) firstCrossoverParameter + i] = crossovers[i];
+
+            for (size_t i = 0; i < (size_t) maxBands; ++i)
+            {
+                values[(size_t) firstBandCurveParameter + i] = bandCurves[i];
+                values[(size_t) firstBandClipParameter + i]  = bandClips[i] ? 1.0f : 0.0f;
+            }
+
+            values[(size_t) adaaParameter] = adaa ? 1.0f : 0.0f;
+            values[(size_t) renderQualityParameter] = (float) renderQuality;
+            values[(size_t) autoOutputParameter] = autoOutput ? 1.0f : 0.0f;
+
+            return values;
+        }
+    };
+
+    //==============================================================================
+    /*  Resolves the parameters' value atomics once, so the audio thread never has to look
+        a parameter up by its ID again.
+    */
+    class ParameterCache
+    {
+    public:
+        explicit ParameterCache (AudioProcessorValueTreeState& state)
+        {
+            for (auto i = 0; i < numParameters; ++i)
+            {
+                values[(size_t) i] = state.getRawParameterValue (parameterIds[i]);
+                jassert (values[(size_t) i] != nullptr);
+            }
+        }
+
+        ParameterSnapshot load() const noexcept     { return ParameterSnapshot::fromRawValues (loadRaw()); }
+
+        RawParameterValues loadRaw() const noexcept
+        {
+            RawParameterValues raw;
+
+            for (size_t i = 0; i < (size_t) numParameters; ++i)
+                raw[i] = values[i]->load (std::memory_order_relaxed);
+
+            return raw;
+        }
+
+    private:
+        std::array<std::atomic<float>*, (size_t) numParameters> values {};
+
+        JUCE_DECLARE_NON_COPYABLE (ParameterCache)
+    };
+
+    //==============================================================================
+    /*  Switches the audio thread to a whole new set of parameters at once.
+
+        Setting the parameters one by one for a preset or a restored state leaves them half
+        old and half new for a while, and a block taken then would run a mix of both.
+        Instead, begin() hands the complete snapshot over through a triple buffer, and
+        blocks use it until end() says the parameters have all caught up. Neither side
+        ever locks or allocates; begin() and end() come from one thread at a time.
+    */
+    class SnapshotHandOver
+    {
+    public:
+        /** From now on, blocks run with snapshot whatever the parameters say. */
+        void begin (const ParameterSnapshot& snapshot) noexcept
+        {
+            slots[(size_t) writeSlot] = snapshot;
+            writeSlot = latest.exchange (writeSlot | fresh, std::memory_order_acq_rel) & slotMask;
+            started.fetch_add (1, std::memory_order_release);
+        }
+
+        /** The parameters hold the snapshot now, blocks can follow them again. */
+        void end() noexcept     { finished.fetch_add (1, std::memory_order_release); }
+
+        /** Audio thread: the parameters for a block. */
+        ParameterSnapshot load (const ParameterCache& parameters) noexcept
+        {
+            const auto done = finished.load (std::memory_order_acquire);
+
+            if (started.load (std::memory_order_acquire) == done)
+            {
+                const auto snapshot = parameters.load();
+
+                // a switch that began while the parameters were read may have torn them
+                std::atomic_thread_fence (std::memory_order_acquire);
+
+                if (started.load (std::memory_order_relaxed) == done)
+                    return snapshot;
+            }
+
+            if ((latest.load (std::memory_order_relaxed) & fresh) != 0)
+                readSlot = latest.exchange (readSlot, std::memory_order_acq_rel) & slotMask;
+
+            return slots[(size_t) readSlot];
+        }
+
+    private:
+        static constexpr int fresh = 4, slotMask = 3;
+
+        std::array<ParameterSnapshot, 3> slots;
+        std::atomic<int> latest { 1 };
+        int writeSlot = 0, readSlot = 2;
+        std::atomic<uint32> started { 0 }, finished { 0 };
+    };
+
+    //==============================================================================
+    /** Where a smoothed value starts and ends over one block. Kept in double, the
+        kernels round it to their own precision. */
+    struct BlockRamp
+    {
+        double start = 0.0, end = 0.0;
+
+        bool isConstant() const noexcept                    { return start == end; }
+
+        /** Per sample step across a block of numSamples, so sample i gets start + i * step. */
+        double getIncrement (int numSamples) const noexcept { return (end - start) / static_cast<double> (numSamples); }
+    };
+
+    //==============================================================================
+    /*  Moves linearly to a new target over a fixed time. Each block is handed out as one
+        straight segment; a ramp that would end part way through a block finishes at the
+        end of it instead, so the kernels never have to handle a kink.
+    */
+    class LinearRamp
+    {
+    public:
+        void reset (double sampleRate, double rampLengthInSeconds) noexcept
+        {
+            rampLength = jmax (1, roundToInt (sampleRate * rampLengthInSeconds));
+            setCurrentAndTarget (target);
+        }
+
+        void setCurrentAndTarget (double newValue) noexcept
+        {
+            current = target = newValue;
+            stepsRemaining = 0;
+        }
+
+        void setTarget (double newTarget) noexcept
+        {
+            if (newTarget == target)
+                return;
+
+            target = newTarget;
+            stepsRemaining = rampLength;
+            step = (target - current) / static_cast<double> (rampLength);
+        }
+
+        BlockRamp advance (int numSamples) noexcept
+        {
+            const auto start = current;
+
+            if (stepsRemaining > numSamples)
+            {
+                current += step * static_cast<double> (numSamples);
+                stepsRemaining -= numSamples;
+            }
+            else
+            {
+                current = target;
+                stepsRemaining = 0;
+            }
+
+            return { start, current };
+        }
+
+        bool isSmoothing() const noexcept       { return stepsRemaining > 0; }
+        double getCurrentValue() const noexcept { return current; }
+        double getTarget() const noexcept       { return target; }
+
+    private:
+        double current = 0.0, target = 0.0, step = 0.0;
+        int rampLength = 1, stepsRemaining = 0;
+    };
+}
@@ -0,0 +1,539 @@
+#include "Pipeline.h"
+
+namespace Dsp {
+
+namespace {
+
+    //==============================================================================
+    /** A Segment spread across the lanes of a register; folds to a constant when not ramping. */
+    template <typename Vec, typename FloatType, bool ramping>
+    struct LaneRamp
+    {
+        using Register = typename Vec::Register;
+
+        explicit LaneRamp (const Segment<FloatType>& segment) noexcept
+            : start (Vec::broadcast (segment.start)),
+              step (Vec::broadcast (segment.increment))
+        {
+        }
+
+        Register at (Register index) const noexcept
+        {
+            if constexpr (ramping)
+                return Vec::mulAdd (index, step, start);
+            else
+                return start;
+        }
+
+        Register start, step;
+    };
+
+    template <typename Vec, typename FloatType, bool ramping>
+    struct ShaperRamp
+    {
+        using Register = typename Vec::Register;
+        using Ramp = LaneRamp<Vec, FloatType, ramping>;
+
+        ShaperRamp (const ShaperCoefficients<FloatType>& start, const ShaperCoefficients<FloatType>& increment) noexcept
+            : k1 ({ start.k1, increment.k1 }), k2 ({ start.k2, increment.k2 }),
+              k3 ({ start.k3, increment.k3 }), k4 ({ start.k4, increment.k4 })
+        {
+        }
+
+        Register apply (Register x, Register index) const noexcept
+        {
+            auto y = Vec::mulAdd (x, k4.at (index), k3.at (index));
+            y = Vec::mulAdd (y, x, k2.at (index));
+            y = Vec::mulAdd (y, x, k1.at (index));
+            return Vec::mul (y, x);
+        }
+
+        Ramp k1, k2, k3, k4;
+    };
+
+    template <typename Vec, typename FloatType>
+    inline typename Vec::Register firstIndex (int begin) noexcept
+    {
+        return Vec::add (Vec::load (LaneIndex<FloatType>::values), Vec::broadcast (static_cast<FloatType> (begin)));
+    }
+
+    //==============================================================================
+    // Each stage runs its body over [begin, end) with a given Vec, so the same body
+    // handles the vectorised part of a block and the scalar tail.
+    template <bool clip, bool fullWet, bool ramping>
+    struct FusedStage
+    {
+        template <typename Vec, typename FloatType>
+        static inline void run (int begin, int end, FloatType* data, const PipelineSettings<FloatType>& settings,
+                                ChannelLevels<FloatType>& input, ChannelLevels<FloatType>& output) noexcept
+        {
+            const LaneRamp<Vec, FloatType, ramping> preGain (settings.preGain), mix (settings.mix), postGain (settings.postGain);
+            const ShaperRamp<Vec, FloatType, ramping> shaper (settings.shaper, settings.shaperIncrement);
+            const auto lower = Vec::broadcast (-1), upper = Vec::broadcast (1);
+            const auto width = Vec::broadcast (static_cast<FloatType> (Vec::size));
+            auto index = firstIndex<Vec, FloatType> (begin);
+            LaneLevels<Vec, FloatType> inputLevels, outputLevels;
+
+            for (auto i = begin; i < end; i += Vec::size)
+            {
+                const auto dry = Vec::mul (Vec::load (data + i), preGain.at (index));
+                inputLevels.add (dry);
+
+                auto wet = dry;
+
+                if constexpr (clip)
+                    wet = Vec::min (Vec::max (wet, lower), upper);
+
+                wet = shaper.apply (wet, index);
+
+                if constexpr (! fullWet)
+                    wet = Vec::mulAdd (Vec::sub (wet, dry), mix.at (index), dry);
+
+                wet = Vec::mul (wet, postGain.at (index));
+                outputLevels.add (wet);
+
+                Vec::store (data + i, wet);
+                index = Vec::add (index, width);
+            }
+
+            inputLevels.addTo (input);
+            outputLevels.addTo (output);
+        }
+    };
+
+    template <bool withDry, bool ramping>
+    struct InputStage
+    {
+        template <typename Vec, typename FloatType>
+        static inline void run (int begin, int end, FloatType* data, FloatType* dry,
+                                const PipelineSettings<FloatType>& settings, ChannelLevels<FloatType>& input) noexcept
+        {
+            const LaneRamp<Vec, FloatType, ramping> preGain (settings.preGain);
+            const auto width = Vec::broadcast (static_cast<FloatType> (Vec::size));
+            auto index = firstIndex<Vec, FloatType> (begin);
+            LaneLevels<Vec, FloatType> inputLevels;
+
+            for (auto i = begin; i < end; i += Vec::size)
+            {
+                const auto x = Vec::mul (Vec::load (data + i), preGain.at (index));
+                inputLevels.add (x);
+                Vec::store (data + i, x);
+
+                if constexpr (withDry)
+                    Vec::store (dry + i, x);
+
+                index = Vec::add (index, width);
+            }
+
+            inputLevels.addTo (input);
+        }
+    };
+
+    template <bool clip, bool ramping>
+    struct NonLinearStage
+    {
+        template <typename Vec, typename FloatType>
+        static inline void run (int begin, int end, FloatType* data,
+                                const ShaperCoefficients<FloatType>& start, const ShaperCoefficients<FloatType>& increment) noexcept
+        {
+            const ShaperRamp<Vec, FloatType, ramping> shaper (start, increment);
+            const auto lower = Vec::broadcast (-1), upper = Vec::broadcast (1);
+            const auto width = Vec::broadcast (static_cast<FloatType> (Vec::size));
+            auto index = firstIndex<Vec, FloatType> (begin);
+
+            for (auto i = begin; i < end; i += Vec::size)
+            {
+                auto x = Vec::load (data + i);
+
+                if constexpr (clip)
+                    x = Vec::min (Vec::max (x, lower), upper);
+
+                Vec::store (data + i, shaper.apply (x, index));
+                index = Vec::add (index, width);
+            }
+        }
+    };
+
+    // Runs backwards, so every output can go over its own input while the input before it
+    // is still there to be read; the first sample pairs with the previous block's last.
+    template <bool clip, bool ramping>
+    struct AntiderivativeStage
+    {
+        template <typename Vec, typename FloatType>
+        static inline void run (int begin, int end, FloatType* data, const ShaperCoefficients<FloatType>& start,
+                                const ShaperCoefficients<FloatType>& increment, FloatType history) noexcept
+        {
+            using Mean = Antiderivative<Vec, FloatType>;
+            const ShaperRamp<Vec, FloatType, ramping> shaper (start, increment);
+            const auto lower = Vec::broadcast (-1), upper = Vec::broadcast (1);
+            const auto width = Vec::broadcast (static_cast<FloatType> (Vec::size));
+            auto index = firstIndex<Vec, FloatType> (end - Vec::size);
+
+            for (auto i = end - Vec::size; i >= begin; i -= Vec::size)
+            {
+                jassert (i > 0 || Vec::size == 1);
+
+                const auto x = Vec::load (data + i);
+                const auto previous = i > 0 ? Vec::load (data + i - 1) : Vec::broadcast (history);
+                const auto k1 = shaper.k1.at (index), k2 = shaper.k2.at (index);
+                const auto k3 = shaper.k3.at (index), k4 = shaper.k4.at (index);
+
+                if constexpr (clip)
+                {
+                    // f(1) and f(-1)
+                    const auto atUpper = Vec::add (Vec::add (k1, k2), Vec::add (k3, k4));
+                    const auto atLower = Vec::add (Vec::sub (k2, k1), Vec::sub (k4, k3));
+                    Vec::store (data + i, Mean::clippedMean (x, previous, lower, upper, atLower, atUpper, k1, k2, k3, k4));
+                }
+                else
+                {
+                    Vec::store (data + i, Mean::mean (x, previous, k1, k2, k3, k4));
+                }
+
+                index = Vec::sub (index, width);
+            }
+        }
+    };
+
+    template <bool fullWet, bool ramping>
+    struct OutputStage
+    {
+        template <typename Vec, typename FloatType>
+        static inline void run (int begin, int end, FloatType* data, const FloatType* dry,
+                                const PipelineSettings<FloatType>& settings, ChannelLevels<FloatType>& output) noexcept
+        {
+            const LaneRamp<Vec, FloatType, ramping> mix (settings.mix), postGain (settings.postGain);
+            const auto width = Vec::broadcast (static_cast<FloatType> (Vec::size));
+            auto index = firstIndex<Vec, FloatType> (begin);
+            LaneLevels<Vec, FloatType> outputLevels;
+
+            for (auto i = begin; i < end; i += Vec::size)
+            {
+                auto wet = Vec::load (data + i);
+
+                if constexpr (! fullWet)
+                {
+                    const auto d = Vec::load (dry + i);
+                    wet = Vec::mulAdd (Vec::sub (wet, d), mix.at (index), d);
+                }
+
+                wet = Vec::mul (wet, postGain.at (index));
+                outputLevels.add (wet);
+
+                Vec::store (data + i, wet);
+                index = Vec::add (index, width);
+            }
+
+            outputLevels.addTo (output);
+        }
+    };
+
+    struct MeasureStage
+    {
+        template <typename Vec, typename FloatType>
+        static inline void run (int begin, int end, const FloatType* data, ChannelLevels<FloatType>& levels) noexcept
+        {
+            LaneLevels<Vec, FloatType> lanes;
+
+            for (auto i = begin; i < end; i += Vec::size)
+                lanes.add (Vec::load (data + i));
+
+            lanes.addTo (levels);
+        }
+    };
+
+    template <typename Vec, typename Stage, typename Sample, typename... Args>
+    inline void runWithTail (int numSamples, Sample* data, Args&&... args) noexcept
+    {
+        const auto vectorEnd = numSamples - numSamples % Vec::size;
+        Stage::template run<Vec> (0, vectorEnd, data, args...);
+        Stage::template run<ScalarVec<std::remove_const_t<Sample>>> (vectorEnd, numSamples, data, args...);
+    }
+
+    template <typename Vec, typename Stage, typename FloatType, typename... Args>
+    inline void runBackwards (int numSamples, FloatType* data, FloatType& history, Args&&... args) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        // the scalar head is at least a sample long, so the vectorised part never reads before data
+        const auto head = (numSamples - 1) % Vec::size + 1;
+        const auto last = data[numSamples - 1];
+
+        Stage::template run<Vec> (head, numSamples, data, args..., history);
+        Stage::template run<ScalarVec<FloatType>> (0, head, data, args..., history);
+        history = last;
+    }
+
+    //==============================================================================
+    template <typename FloatType>
+    using FusedFunction = void (*) (FloatType*, int, const PipelineSettings<FloatType>&, ChannelLevels<FloatType>&, ChannelLevels<FloatType>&) noexcept;
+
+    template <typename FloatType>
+    using InputFunction = void (*) (FloatType*, FloatType*, int, const PipelineSettings<FloatType>&, ChannelLevels<FloatType>&) noexcept;
+
+    template <typename FloatType>
+    using NonLinearFunction = void (*) (FloatType*, int, const ShaperCoefficients<FloatType>&, const ShaperCoefficients<FloatType>&) noexcept;
+
+    template <typename FloatType>
+    using AntiderivativeFunction = void (*) (FloatType*, int, const ShaperCoefficients<FloatType>&, const ShaperCoefficients<FloatType>&, FloatType&) noexcept;
+
+    template <typename FloatType>
+    using OutputFunction = void (*) (FloatType*, const FloatType*, int, const PipelineSettings<FloatType>&, ChannelLevels<FloatType>&) noexcept;
+
+    template <typename FloatType>
+    using MeasureFunction = void (*) (const FloatType*, int, ChannelLevels<FloatType>&) noexcept;
+
+    // Entry points per instruction set. SSE2 and scalar helpers are forcedinline, so they
+    // need no attributes; the AVX ones are targeted and flattened, see VectorIsa.h.
+    #define INFLATION_PIPELINE_ENTRIES(Name, attributes) \
+        template <typename Vec> \
+        struct Name \
+        { \
+            template <bool clip, bool fullWet, bool ramping, typename FloatType> \
+            attributes static void fused (FloatType* data, int numSamples, const PipelineSettings<FloatType>& settings, \
+                                          ChannelLevels<FloatType>& input, ChannelLevels<FloatType>& output) noexcept \
+            { runWithTail<Vec, FusedStage<clip, fullWet, ramping>> (numSamples, data, settings, input, output); } \
+            \
+            template <bool withDry, bool ramping, typename FloatType> \
+            attributes static void input (FloatType* data, FloatType* dry, int numSamples, \
+                                          const PipelineSettings<FloatType>& settings, ChannelLevels<FloatType>& input) noexcept \
+            { runWithTail<Vec, InputStage<withDry, ramping>> (numSamples, data, dry, settings, input); } \
+            \
+            template <bool clip, bool ramping, typename FloatType> \
+            attributes static void nonLinear (FloatType* data, int numSamples, \
+                                              const ShaperCoefficients<FloatType>& start, const ShaperCoefficients<FloatType>& increment) noexcept \
+            { runWithTail<Vec, NonLinearStage<clip, ramping>> (numSamples, data, start, increment); } \
+            \
+            template <bool clip, bool ramping, typename FloatType> \
+            attributes static void antiderivative (FloatType* data, int numSamples, const ShaperCoefficients<FloatType>& start, \
+                                                   const ShaperCoefficients<FloatType>& increment, FloatType& history) noexcept \
+            { runBackwards<Vec, AntiderivativeStage<clip, ramping>> (numSamples, data, history, start, increment); } \
+            \
+            template <bool fullWet, bool ramping, typename FloatType> \
+            attributes static void output (FloatType* data, const FloatType* dry, int numSamples, \
+                                           const PipelineSettings<FloatType>& settings, ChannelLevels<FloatType>& output) noexcept \
+            { runWithTail<Vec, OutputStage<fullWet, ramping>> (numSamples, data, dry, settings, output); } \
+            \
+            template <typename FloatType> \
+            attributes static void measure (const FloatType* data, int numSamples, ChannelLevels<FloatType>& levels) noexcept \
+            { runWithTail<Vec, MeasureStage> (numSamples, data, levels); } \
+        };
+
+    INFLATION_PIPELINE_ENTRIES (PortableEntries, )
+
+   #if JUCE_INTEL
+    INFLATION_PIPELINE_ENTRIES (Avx2Entries, INFLATION_KERNEL ("avx2,fma"))
+    INFLATION_PIPELINE_ENTRIES (Avx512Entries, INFLATION_KERNEL ("avx512f"))
+   #endif
+
+    #undef INFLATION_PIPELINE_ENTRIES
+
+    //==============================================================================
+    template <typename FloatType>
+    struct Table
+    {
+        FusedFunction<FloatType> fused[2][2][2];        // [clip][fullWet][ramping]
+        InputFunction<FloatType> input[2][2];           // [withDry][ramping]
+        NonLinearFunction<FloatType> nonLinear[2][2];   // [clip][ramping]
+        AntiderivativeFunction<FloatType> antiderivative[2][2];
+        OutputFunction<FloatType> output[2][2];         // [fullWet][ramping]
+        MeasureFunction<FloatType> measure;
+    };
+
+    template <typename Entries, typename FloatType>
+    Table<FloatType> makeTable() noexcept
+    {
+        Table<FloatType> table;
+
+        table.fused[0][0][0] = Entries::template fused<false, false, false, FloatType>;
+        table.fused[0][0][1] = Entries::template fused<false, false, true,  FloatType>;
+        table.fused[0][1][0] = Entries::template fused<false, true,  false, FloatType>;
+        table.fused[0][1][1] = Entries::template fused<false, true,  true,  FloatType>;
+        table.fused[1][0][0] = Entries::template fused<true,  false, false, FloatType>;
+        table.fused[1][0][1] = Entries::template fused<true,  false, true,  FloatType>;
+        table.fused[1][1][0] = Entries::template fused<true,  true,  false, FloatType>;
+        table.fused[1][1][1] = Entries::template fused<true,  true,  true,  FloatType>;
+
+        table.input[0][0] = Entries::template input<false, false, FloatType>;
+        table.input[0][1] = Entries::template input<false, true,  FloatType>;
+        table.input[1][0] = Entries::template input<true,  false, FloatType>;
+        table.input[1][1] = Entries::template input<true,  true,  FloatType>;
+
+        table.nonLinear[0][0] = Entries::template nonLinear<false, false, FloatType>;
+        table.nonLinear[0][1] = Entries::template nonLinear<false, true,  FloatType>;
+        table.nonLinear[1][0] = Entries::template nonLinear<true,  false, FloatType>;
+        table.nonLinear[1][1] = Entries::template nonLinear<true,  true,  FloatType>;
+
+        table.antiderivative[0][0] = Entries::template antiderivative<false, false, FloatType>;
+        table.antiderivative[0][1] = Entries::template antiderivative<false, true,  FloatType>;
+        table.antiderivative[1][0] = Entries::template antiderivative<true,  false, FloatType>;
+        table.antiderivative[1][1] = Entries::template antiderivative<true,  true,  FloatType>;
+
+        table.output[0][0] = Entries::template output<false, false, FloatType>;
+        table.output[0][1] = Entries::template output<false, true,  FloatType>;
+        table.output[1][0] = Entries::template output<true,  false, FloatType>;
+        table.output[1][1] = Entries::template output<true,  true,  FloatType>;
+
+        table.measure = Entries::template measure<FloatType>;
+
+        return table;
+    }
+
+    struct Kernels
+    {
+        Table<float> floats;
+        Table<double> doubles;
+
+        const Table<float>& get (float) const noexcept    { return floats; }
+        const Table<double>& get (double) const noexcept  { return doubles; }
+    };
+
+    Kernels selectKernels (Isa isa) noexcept
+    {
+        switch (isa)
+        {
+           #if JUCE_INTEL
+            case Isa::avx512:
+                return { makeTable<Avx512Entries<Avx512Float>, float>(), makeTable<Avx512Entries<Avx512Double>, double>() };
+
+            case Isa::avx2:
+                return { makeTable<Avx2Entries<Avx2Float>, float>(), makeTable<Avx2Entries<Avx2Double>, double>() };
+
+            case Isa::sse2:
+                return { makeTable<PortableEntries<Sse2Float>, float>(), makeTable<PortableEntries<Sse2Double>, double>() };
+           #endif
+
+            case Isa::scalar:
+            default:
+                return { makeTable<PortableEntries<ScalarVec<float>>, float>(), makeTable<PortableEntries<ScalarVec<double>>, double>() };
+        }
+    }
+
+    // picked while the library loads, so the audio thread never takes a static's guard for it
+    const Kernels kernels = selectKernels (detectIsa());
+
+    template <typename FloatType>
+    const Table<FloatType>& getTable() noexcept
+    {
+        return kernels.get (FloatType());
+    }
+
+    //==============================================================================
+    template <typename FloatType>
+    void process (FloatType* data, int numSamples, const PipelineSettings<FloatType>& settings,
+                  ChannelLevels<FloatType>& input, ChannelLevels<FloatType>& output) noexcept
+    {
+        getTable<FloatType>().fused[settings.zeroClip][settings.fullWet][settings.ramping] (data, numSamples, settings, input, output);
+    }
+
+    template <typename FloatType>
+    void processInput (FloatType* data, FloatType* dry, int numSamples, const PipelineSettings<FloatType>& settings,
+                       ChannelLevels<FloatType>& input) noexcept
+    {
+        getTable<FloatType>().input[dry != nullptr][settings.ramping] (data, dry, numSamples, settings, input);
+    }
+
+    template <typename FloatType>
+    void processNonLinear (FloatType* data, int numSamples, const ShaperCoefficients<FloatType>& start,
+                           const ShaperCoefficients<FloatType>& increment, bool zeroClip, bool ramping) noexcept
+    {
+        getTable<FloatType>().nonLinear[zeroClip][ramping] (data, numSamples, start, increment);
+    }
+
+    template <typename FloatType>
+    void processAntiderivative (FloatType* data, int numSamples, const ShaperCoefficients<FloatType>& start,
+                                const ShaperCoefficients<FloatType>& increment, bool zeroClip, bool ramping, FloatType& history) noexcept
+    {
+        getTable<FloatType>().antiderivative[zeroClip][ramping] (data, numSamples, start, increment, history);
+    }
+
+    template <typename FloatType>
+    void processOutput (FloatType* data, const FloatType* dry, int numSamples, const PipelineSettings<FloatType>& settings,
+                        ChannelLevels<FloatType>& output) noexcept
+    {
+        jassert (settings.fullWet || dry != nullptr);
+        getTable<FloatType>().output[settings.fullWet][settings.ramping] (data, dry, numSamples, settings, output);
+    }
+
+    template <typename FloatType>
+    void measure (const FloatType* data, int numSamples, ChannelLevels<FloatType>& levels) noexcept
+    {
+        getTable<FloatType>().measure (data, numSamples, levels);
+    }
+}
+
+//==============================================================================
+void Pipeline::process (float* data, int numSamples, const PipelineSettings<float>& settings,
+                        ChannelLevels<float>& input, ChannelLevels<float>& output) noexcept
+{
+    Dsp::process (data, numSamples, settings, input, output);
+}
+
+void Pipeline::process (double* data, int numSamples, const PipelineSettings<double>& settings,
+                        ChannelLevels<double>& input, ChannelLevels<double>& output) noexcept
+{
+    Dsp::process (data, numSamples, settings, input, output);
+}
+
+void Pipeline::processInput (float* data, float* dry, int numSamples, const PipelineSettings<float>& settings,
+                             ChannelLevels<float>& input) noexcept
+{
+    Dsp::processInput (data, dry, numSamples, settings, input);
+}
+
+void Pipeline::processInput (double* data, double* dry, int numSamples, const PipelineSettings<double>& settings,
+                             ChannelLevels<double>& input) noexcept
+{
+    Dsp::processInput (data, dry, numSamples, settings, input);
+}
+
+void Pipeline::processNonLinear (float* data, int numSamples, const ShaperCoefficients<float>& start,
+                                 const ShaperCoefficients<float>& increment, bool zeroClip, bool ramping) noexcept
+{
+    Dsp::processNonLinear (data, numSamples, start, increment, zeroClip, ramping);
+}
+
+void Pipeline::processNonLinear (double* data, int numSamples, const ShaperCoefficients<double>& start,
+                                 const ShaperCoefficients<double>& increment, bool zeroClip, bool ramping) noexcept
+{
+    Dsp::processNonLinear (data, numSamples, start, increment, zeroClip, ramping);
+}
+
+void Pipeline::processAntiderivative (float* data, int numSamples, const ShaperCoefficients<float>& start,
+                                      const ShaperCoefficients<float>& increment, bool zeroClip, bool ramping,
+                                      float& history) noexcept
+{
+    Dsp::processAntiderivative (data, numSamples, start, increment, zeroClip, ramping, history);
+}
+
+void Pipeline::processAntiderivative (double* data, int numSamples, const ShaperCoefficients<double>& start,
+                                      const ShaperCoefficients<double>& increment, bool zeroClip, bool ramping,
+                                      double& history) noexcept
+{
+    Dsp::processAntiderivative (data, numSamples, start, increment, zeroClip, ramping, history);
+}
+
+void Pipeline::processOutput (float* data, const float* dry, int numSamples, const PipelineSettings<float>& settings,
+                              ChannelLevels<float>& output) noexcept
+{
+    Dsp::processOutput (data, dry, numSamples, settings, output);
+}
+
+void Pipeline::processOutput (double* data, const double* dry, int numSamples, const PipelineSettings<double>& settings,
+                              ChannelLevels<double>& output) noexcept
+{
+    Dsp::processOutput (data, dry, numSamples, settings, output);
+}
+
+void Pipeline::measure (const float* data, int numSamples, ChannelLevels<float>& levels) noexcept
+{
+    Dsp::measure (data, numSamples, levels);
+}
+
+void Pipeline::measure (const double* data, int numSamples, ChannelLevels<double>& levels) noexcept
+{
+    Dsp::measure (data, numSamples, levels);
+}
+
+}
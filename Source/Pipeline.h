@@ -0,0 +1,151 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VectorIsa.h"
+#include "WaveShaper.h"
+#include "ParameterSnapshot.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /** A value that moves linearly over a block, sample i gets start + i * increment. */
+    template <typename FloatType>
+    struct Segment
+    {
+        FloatType start = 0, increment = 0;
+
+        static Segment fromRamp (BlockRamp ramp, int numSamples) noexcept
+        {
+            return { static_cast<FloatType> (ramp.start), static_cast<FloatType> (ramp.getIncrement (numSamples)) };
+        }
+    };
+
+    //==============================================================================
+    /** Everything one channel's pass needs for a block, worked out once per block. */
+    template <typename FloatType>
+    struct PipelineSettings
+    {
+        Segment<FloatType> preGain, mix, postGain;
+        ShaperCoefficients<FloatType> shaper, shaperIncrement;
+
+        bool zeroClip = true;
+        bool fullWet = true;        // mix sits at 100% for the whole block, so the dry signal isn't needed
+        bool ramping = false;       // something above moves during the block
+
+        static PipelineSettings make (BlockRamp preGain, BlockRamp mix, BlockRamp postGain, BlockRamp curve,
+                                      int numSamples, bool zeroClip) noexcept
+        {
+            PipelineSettings settings;
+            settings.preGain  = Segment<FloatType>::fromRamp (preGain, numSamples);
+            settings.mix      = Segment<FloatType>::fromRamp (mix, numSamples);
+            settings.postGain = Segment<FloatType>::fromRamp (postGain, numSamples);
+
+            // D is quadratic in the curve, so ramp the coefficients themselves between the
+            // block's end points rather than recomputing them from a ramped curve
+            settings.shaper = ShaperCoefficients<FloatType>::fromCurve (curve.start);
+            settings.shaperIncrement = settings.shaper.getIncrementTo (ShaperCoefficients<FloatType>::fromCurve (curve.end), numSamples);
+
+            settings.zeroClip = zeroClip;
+            settings.fullWet = mix.isConstant() && mix.start >= 1.0;
+            settings.ramping = ! (preGain.isConstant() && mix.isConstant() && postGain.isConstant() && curve.isConstant());
+            return settings;
+        }
+    };
+
+    //==============================================================================
+    /** Level measured on the way through, so metering doesn't need passes of its own. */
+    template <typename FloatType>
+    struct ChannelLevels
+    {
+        FloatType sumOfSquares = 0, peak = 0;
+
+        float getRmsDecibels (int numSamples) const noexcept
+        {
+            return static_cast<float> (Decibels::gainToDecibels (std::sqrt (sumOfSquares / static_cast<FloatType> (jmax (1, numSamples)))));
+        }
+
+        float getPeakDecibels() const noexcept  { return static_cast<float> (Decibels::gainToDecibels (peak)); }
+    };
+
+    /** ChannelLevels kept per lane of a kernel's registers until the end of its range. */
+    template <typename Vec, typename FloatType>
+    struct LaneLevels
+    {
+        using Register = typename Vec::Register;
+
+        LaneLevels() noexcept : squares (Vec::broadcast (0)), peak (Vec::broadcast (0)) {}
+
+        void add (Register x) noexcept
+        {
+            squares = Vec::mulAdd (x, x, squares);
+            peak = Vec::max (peak, Vec::abs (x));
+        }
+
+        void addTo (ChannelLevels<FloatType>& levels) const noexcept
+        {
+            alignas (64) FloatType squareLanes[Vec::size], peakLanes[Vec::size];
+            Vec::store (squareLanes, squares);
+            Vec::store (peakLanes, peak);
+
+            for (auto i = 0; i < Vec::size; ++i)
+            {
+                levels.sumOfSquares += squareLanes[i];
+                levels.peak = jmax (levels.peak, peakLanes[i]);
+            }
+        }
+
+        Register squares, peak;
+    };
+
+    //==============================================================================
+    /*  The per-channel signal chain
+
+            pre-gain → input level → clip → shape → mix → post-gain → output level
+
+        as one streaming pass. Zero clip, 100% wet and ramping are template arguments of
+        the kernels, so every combination is its own branch-free loop; at 100% wet the dry
+        signal is never stored anywhere.
+
+        When the shaper runs oversampled, band split or anti-aliased it can't share a loop
+        with the base rate stages, so the chain is also available as an input, a non-linear
+        and an output stage.
+    */
+    struct Pipeline
+    {
+        static void process (float* data, int numSamples, const PipelineSettings<float>& settings,
+                             ChannelLevels<float>& input, ChannelLevels<float>& output) noexcept;
+        static void process (double* data, int numSamples, const PipelineSettings<double>& settings,
+                             ChannelLevels<double>& input, ChannelLevels<double>& output) noexcept;
+
+        /** Pre-gain and input level. The gained signal is copied to dry unless dry is nullptr. */
+        static void processInput (float* data, float* dry, int numSamples, const PipelineSettings<float>& settings,
+                                  ChannelLevels<float>& input) noexcept;
+        static void processInput (double* data, double* dry, int numSamples, const PipelineSettings<double>& settings,
+                                  ChannelLevels<double>& input) noexcept;
+
+        /** Clip and shape, at whatever rate data runs at. */
+        static void processNonLinear (float* data, int numSamples, const ShaperCoefficients<float>& start,
+                                      const ShaperCoefficients<float>& increment, bool zeroClip, bool ramping) noexcept;
+        static void processNonLinear (double* data, int numSamples, const ShaperCoefficients<double>& start,
+                                      const ShaperCoefficients<double>& increment, bool zeroClip, bool ramping) noexcept;
+
+        /** Clip and shape with antiderivative anti-aliasing, see Dsp::Antiderivative. history holds
+            the channel's last input before the block, and is left holding the block's last. */
+        static void processAntiderivative (float* data, int numSamples, const ShaperCoefficients<float>& start,
+                                           const ShaperCoefficients<float>& increment, bool zeroClip, bool ramping,
+                                           float& history) noexcept;
+        static void processAntiderivative (double* data, int numSamples, const ShaperCoefficients<double>& start,
+                                           const ShaperCoefficients<double>& increment, bool zeroClip, bool ramping,
+                                           double& history) noexcept;
+
+        /** Mix against dry, post-gain and output level. dry is ignored when settings.fullWet is set. */
+        static void processOutput (float* data, const float* dry, int numSamples, const PipelineSettings<float>& settings,
+                                   ChannelLevels<float>& output) noexcept;
+        static void processOutput (double* data, const double* dry, int numSamples, const PipelineSettings<double>& settings,
+                                   ChannelLevels<double>& output) noexcept;
+
+        /** Adds the level of data to levels without changing it. A non-finite sample makes the sum of squares non-finite. */
+        static void measure (const float* data, int numSamples, ChannelLevels<float>& levels) noexcept;
+        static void measure (const double* data, int numSamples, ChannelLevels<double>& levels) noexcept;
+    };
+}
@@ -3,25 +3,59 @@
 
 InflationPluginAudioProcessor::InflationPluginAudioProcessor()
 : AudioProcessor (getBusesProperties()),
-                state (*this, nullptr, "state",
+                state (*this, nullptr, "state", createParameterLayout()),
+                parameters (state)
+{
+    // Add a sub-tree to store the state of our UI
+    state.state.addChild ({ "uiState", { { "width",  600 }, { "height", 700 } }, {} }, -1, nullptr);
+    
+    processDouble = &InflationPluginAudioProcessor::process<Dsp::DoublePrecision>;
+}
+
+AudioProcessorValueTreeState::ParameterLayout InflationPluginAudioProcessor::createParameterLayout()
+{
+    AudioProcessorValueTreeState::ParameterLayout layout
                        { std::make_unique<AudioParameterFloat> (ParameterID { "preGain",  1 }, "Input",  NormalisableRange<float> (-100.0f, 12.0f, 0.1f, 4.f), 0.0f),  // start, end, interval, skew
                          std::make_unique<AudioParameterFloat> (ParameterID { "postGain", 1 }, "Output", NormalisableRange<float>(-100.0f, 0.0f, 0.1f, 4.f), 0.0f),
                          std::make_unique<AudioParameterFloat> (ParameterID { "mix", 1 }, "Wet/Dry", NormalisableRange<float> (0.0f, 100.0f, 0.1f), 100.0f),
                          std::make_unique<AudioParameterFloat> (ParameterID { "curve", 1 }, "Curve", NormalisableRange<float>(-50.0f, 50.0f, 0.1f), 0.0f),
                          std::make_unique<AudioParameterBool>  (ParameterID( "zeroClip", 1), "Zero Clip", true),
                         std::make_unique<AudioParameterBool>  (ParameterID( "bandSplit", 1), "Band Split", false),
-                    
-                })
-{
-    // Add a sub-tree to store the state of our UI
-    state.state.addChild ({ "uiState", { { "width",  600 }, { "height", 450 } }, {} }, -1, nullptr);
-
-    resetMeterValues();
+                         std::make_unique<AudioParameterChoice> (ParameterID { "oversampling", 1 }, "Oversampling", StringArray { "Off", "2x", "4x", "8x", "16x" }, 0),
+                         std::make_unique<AudioParameterChoice> (ParameterID { "oversamplingFilter", 1 }, "Oversampling Filter", StringArray { "Linear Phase", "Zero Latency" }, 0),
+                         std::make_unique<AudioParameterChoice> (ParameterID { "truePeakLimit", 1 }, "True Peak Limit", StringArray { "No Limit", "-0.1 dBTP", "-0.3 dBTP", "-1 dBTP" }, 0),
+                         std::make_unique<AudioParameterInt> (ParameterID { "bands", 1 }, "Bands", 2, Dsp::maxBands, 3) };
+    
+    // Band Split's crossovers and bands, in parameterIds order; the crossovers are skewed so the knob travels about evenly per octave
+    for (auto i = 0; i < Dsp::maxCrossovers; ++i)
+        layout.add (std::make_unique<AudioParameterFloat> (ParameterID { Dsp::parameterIds[Dsp::firstCrossoverParameter + i], 1 },
+                                                           "Crossover " + String (i + 1),
+                                                           NormalisableRange<float> (20.0f, 20000.0f, 1.0f, 0.25f),
+                                                           Dsp::defaultCrossovers[i]));
+    
+    for (auto i = 0; i < Dsp::maxBands; ++i)
+        layout.add (std::make_unique<AudioParameterFloat> (ParameterID { Dsp::parameterIds[Dsp::firstBandCurveParameter + i], 1 },
+                                                           "Band " + String (i + 1) + " Curve",
+                                                           NormalisableRange<float> (-50.0f, 50.0f, 0.1f), 0.0f));
+    
+    for (auto i = 0; i < Dsp::maxBands; ++i)
+        layout.add (std::make_unique<AudioParameterBool> (ParameterID { Dsp::parameterIds[Dsp::firstBandClipParameter + i], 1 },
+                                                          "Band " + String (i + 1) + " Clip", true));
+    
+    // antiderivative anti-aliasing, the cheap alternative to oversampling
+    layout.add (std::make_unique<AudioParameterBool> (ParameterID { "adaa", 1 }, "ADAA", false));
+    
+    // what an offline render runs, see getRenderParameters
+    layout.add (std::make_unique<AudioParameterChoice> (ParameterID { "renderQuality", 1 }, "Render Quality", StringArray { "As Playback", "Best" }, 0));
+    
+    // keeps the output as loud as the input, see Dsp::LoudnessMeter
+    layout.add (std::make_unique<AudioParameterBool> (ParameterID { "autoOutput", 1 }, "Auto Output", false));
+    
+    return layout;
 }
 
 bool InflationPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    // Only mono/stereo and input/output must have same layout
     const auto& mainOutput = layouts.getMainOutputChannelSet();
     const auto& mainInput  = layouts.getMainInputChannelSet();
 
@@ -29,116 +63,251 @@ bool InflationPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
     if (! mainInput.isDisabled() && mainInput != mainOutput)
         return false;
 
-    // only allow stereo and mono
-    if (mainOutput.size() > 2)
-        return false;
-
-    return true;
+    // every channel is processed the same way, so any layout will do up to the lane count
+    return mainOutput.size() >= 1 && mainOutput.size() <= maxNumChannels;
 }
 
 void InflationPluginAudioProcessor::prepareToPlay (double newSampleRate, int samplesPerBlock)
 {
+    // host blocks of any size are cut into sub-blocks, so the host's block size doesn't size anything
+    ignoreUnused (samplesPerBlock);
+    
     reset();
     
     // reinitilise meter
-    for (auto i = 0; i < inputRMS.size(); ++i)
-        inputRMS[i].reset(newSampleRate, 0.5f);
-                    
-    for (auto i = 0; i < outputRMS.size(); ++i)
-        outputRMS[i].reset(newSampleRate, 0.5f);
-    
-    lpf.reset();
-    hpf.reset();
-    
-    lpf.setType(dsp::StateVariableTPTFilterType::lowpass);
-    hpf.setType(dsp::StateVariableTPTFilterType::highpass);
-    
-    juce::dsp::ProcessSpec spec {
-        newSampleRate,
-        static_cast<juce::uint32> (samplesPerBlock),
-        static_cast<juce::uint32> (getTotalNumInputChannels())
-    };
-    lpf.prepare(spec);
-    hpf.prepare(spec);
-    
-    // 12 db per octave
-    lpf.setResonance(1.0f / std::sqrt(2));
-    hpf.setResonance(1.0f / std::sqrt(2));
-    
-    lpf.setCutoffFrequency(240.0f);
-    hpf.setCutoffFrequency(2400.0f);
-    
-    if (isUsingDoublePrecision())
+    inputMeterBus.prepare (newSampleRate, getTotalNumInputChannels());
+    outputMeterBus.prepare (newSampleRate, getTotalNumOutputChannels());
+    analyzer.prepare (newSampleRate);
+    loudnessMeter.prepare (newSampleRate, getChannelLayoutOfBus (true, 0), getChannelLayoutOfBus (false, 0));
+    
+   #if INFLATION_PROFILING
+    profiler.prepare (newSampleRate);
+   #endif
+    
+    // a bounce runs the render settings in longer sub-blocks, with the channels shared out over
+    // the workers; hosts can go offline and back without preparing again, so the threads and
+    // the memory are ready for either, see followRenderMode()
+    rendering = isNonRealtime();
+    
+    if (jmin (maxRenderWorkers, getTotalNumOutputChannels()) > 1)
+        workers.prepare (jmin (maxRenderWorkers, getTotalNumOutputChannels()));
+    else
+        workers.release();
+    
+    // start the smoothers on the current values so playback doesn't begin with a ramp
+    const auto params = getRenderParameters (parameters.load());
+    
+    preGainRamp.reset (newSampleRate, 0.05);
+    postGainRamp.reset (newSampleRate, 0.05);
+    mixRamp.reset (newSampleRate, 0.05);
+    curveRamp.reset (newSampleRate, 0.05);
+    matchingRamp.reset (newSampleRate, 0.1);
+    
+    preGainRamp.setCurrentAndTarget (Decibels::decibelsToGain ((double) params.preGain));
+    postGainRamp.setCurrentAndTarget (Decibels::decibelsToGain ((double) params.postGain));
+    mixRamp.setCurrentAndTarget (params.mix);
+    curveRamp.setCurrentAndTarget (params.curve);
+    matchingRamp.setCurrentAndTarget (1.0);
+    
+    // crossovers move in octaves, so a sweep sounds even
+    for (size_t i = 0; i < crossoverRamps.size(); ++i)
+    {
+        crossoverRamps[i].reset (newSampleRate, 0.05);
+        crossoverRamps[i].setCurrentAndTarget (std::log2 ((double) params.crossovers[i]));
+    }
+    
+    for (size_t i = 0; i < bandCurveRamps.size(); ++i)
     {
-        dryBuffer_double.setSize (getTotalNumInputChannels(), samplesPerBlock);
-        lowBuffer_double.setSize (getTotalNumInputChannels(), samplesPerBlock);
-        highBuffer_double.setSize (getTotalNumInputChannels(), samplesPerBlock);
-        dryBuffer_float .setSize (1, 1);
-        lowBuffer_float .setSize (1, 1);
-        highBuffer_float .setSize (1, 1);
+        bandCurveRamps[i].reset (newSampleRate, 0.05);
+        bandCurveRamps[i].setCurrentAndTarget (params.bandCurves[i]);
+    }
+    
+    // the input is either the output's layout or disabled, in which case the output starts from silence
+    const auto numChannels = getTotalNumOutputChannels();
+    preparedSampleRate = newSampleRate;
+    decaySamples = roundToInt (newSampleRate * silenceDecaySeconds);
+    
+    // the precision policy is settled here; blocks never branch on it
+    mixedPrecision = isUsingDoublePrecision() && mixedPrecisionRequested;
+    processDouble = mixedPrecision ? &InflationPluginAudioProcessor::process<Dsp::MixedPrecision>
+                                   : &InflationPluginAudioProcessor::process<Dsp::DoublePrecision>;
+    
+    const auto useDoubleEngine = isUsingDoublePrecision() && ! mixedPrecision;
+    
+    const auto numWorkers = jmin (maxRenderWorkers, workers.getNumWorkers());
+    
+    // both engines take from the one arena, the one not in use takes nothing; it's sized for a
+    // render's longer sub-blocks, so switching to one and back never allocates
+    arena.build ([&] (Dsp::ScratchArena& memory)
+    {
+        floatEngine.prepare (memory, useDoubleEngine ? 0 : numChannels, mixedPrecision, newSampleRate,
+                             renderSubBlockSize, renderOversampledSubBlockSize, numWorkers);
+        doubleEngine.prepare (memory, useDoubleEngine ? numChannels : 0, false, newSampleRate,
+                              renderSubBlockSize, renderOversampledSubBlockSize, numWorkers);
+    });
+    
+    floatEngine.crossover.setNumGroups (rendering ? numWorkers : 1);
+    doubleEngine.crossover.setNumGroups (rendering ? numWorkers : 1);
+    
+    if (useDoubleEngine)
+    {
+        updateOversampling (doubleEngine, params, true);
+        updateLimiter (doubleEngine, params, true);
     }
     else
     {
-        dryBuffer_float.setSize (getTotalNumInputChannels(), samplesPerBlock);
-        lowBuffer_float.setSize (getTotalNumInputChannels(), samplesPerBlock);
-        highBuffer_float.setSize (getTotalNumInputChannels(), samplesPerBlock);
-        dryBuffer_double.setSize (1, 1);
-        lowBuffer_double.setSize (1, 1);
-        highBuffer_double.setSize (1, 1);
+        updateOversampling (floatEngine, params, true);
+        updateLimiter (floatEngine, params, true);
     }
 }
 
-void InflationPluginAudioProcessor::releaseResources()
+template <typename FloatType>
+void InflationPluginAudioProcessor::Engine<FloatType>::prepare (Dsp::ScratchArena& memory, int numChannels,
+                                                                bool convertsIo, double sampleRate,
+                                                                int maxSubBlockSize, int maxOversampledSubBlockSize, int numWorkers)
 {
+    takeChannels (memory, dryBuffer, numChannels, maxSubBlockSize);
+    takeChannels (memory, ioBuffer, convertsIo ? numChannels : 0, maxSubBlockSize);
+    oversampler.prepare (memory, numChannels, maxSubBlockSize, maxOversampledSubBlockSize);
+    dryDelay.prepare (memory, numChannels, oversampler.getMaxLatencyInSamples());
+    crossover.prepare (memory, numChannels, numChannels > 0 ? maxOversampledSubBlockSize : 0, sampleRate, numWorkers);
+    limiter.prepare (memory, numChannels, maxSubBlockSize, sampleRate);
 }
 
-void InflationPluginAudioProcessor::reset()
+template <typename FloatType>
+void InflationPluginAudioProcessor::Engine<FloatType>::reset()
+{
+    dryBuffer.clear();
+    ioBuffer.clear();
+    crossover.reset();
+    oversampler.reset();
+    shaperHistory.fill (0);
+    dryHistory.fill (0);
+    dryDelay.reset();
+    limiter.reset();
+}
+
+template <typename FloatType>
+void InflationPluginAudioProcessor::takeChannels (Dsp::ScratchArena& memory, AudioBuffer<FloatType>& buffer,
+                                                  int numChannels, int numSamples)
+{
+    FloatType* channels[maxNumChannels] = {};
+    
+    for (auto i = 0; i < numChannels; ++i)
+        channels[i] = memory.take<FloatType> (numSamples).data();
+    
+    // refers to the arena, an AudioBuffer only allocates its channel list above 32 channels
+    buffer.setDataToReferTo (channels, numChannels, numChannels > 0 ? numSamples : 0);
+}
+
+template <typename FloatType>
+void InflationPluginAudioProcessor::updateOversampling (Engine<FloatType>& engine, const Dsp::ParameterSnapshot& params, bool force)
+{
+    auto order = params.oversampling;
+    auto filter = params.oversamplingFilter == 0 ? Dsp::Oversampler<FloatType>::Filter::linearPhase
+                                                 : Dsp::Oversampler<FloatType>::Filter::zeroLatency;
+    
+    if (! force && order == engine.oversampler.getOrder() && filter == engine.oversampler.getFilter())
+        return;
+    
+    engine.oversampler.setOrder (order, filter);
+    engine.dryDelay.setDelay (engine.oversampler.getLatencyInSamples());
+    updateLatency (engine);
+    
+    // the bands run on the oversampled signal, the dry path's all passes at the host's rate
+    engine.crossover.setSampleRate (preparedSampleRate, engine.oversampler.getFactor());
+    engine.crossover.reset();
+}
+
+template <typename FloatType>
+void InflationPluginAudioProcessor::updateLimiter (Engine<FloatType>& engine, const Dsp::ParameterSnapshot& params, bool force)
 {
-    // reset temp buffers
-    dryBuffer_float.clear();
-    dryBuffer_double.clear();
+    const auto shouldLimit = params.truePeakLimit > 0;
     
-    lowBuffer_float.clear();
-    lowBuffer_double.clear();
+    if (shouldLimit)
+        engine.limiter.setCeiling (getLimiterCeiling (params.truePeakLimit));
     
-    highBuffer_float.clear();
-    highBuffer_double.clear();
+    if (! force && shouldLimit == limiting)
+        return;
+    
+    // the lookahead only counts towards the latency while the limiter is in
+    limiting = shouldLimit;
+    engine.limiter.reset();
+    updateLatency (engine);
+}
+
+template <typename FloatType>
+void InflationPluginAudioProcessor::updateLatency (Engine<FloatType>& engine)
+{
+    setLatencySamples (engine.oversampler.getLatencyInSamples() + (limiting ? engine.limiter.getLatencyInSamples() : 0));
+}
+
+void InflationPluginAudioProcessor::releaseResources()
+{
+}
+
+void InflationPluginAudioProcessor::reset()
+{
+    // reset temp buffers, band split, resampler and latency compensation state
+    floatEngine.reset();
+    doubleEngine.reset();
     
     // reset meter values
-    resetMeterValues();
+    inputMeterBus.reset();
+    outputMeterBus.reset();
+    
+    // awake until the input has been silent for long enough again
+    silentSamples = 0;
+    sleeping = false;
 }
 
-void InflationPluginAudioProcessor::resetMeterValues()
+void InflationPluginAudioProcessor::followRenderMode() noexcept
 {
-    inputRMS.clear();
-    outputRMS.clear();
+    // a host may go offline, or come back, without preparing again
+    if (isNonRealtime() == rendering)
+        return;
     
-    for (auto i = 0; i < getTotalNumInputChannels(); ++i)
-    {
-        juce::LinearSmoothedValue<float> val;
-        val.setTargetValue(-100.0f);
-        inputRMS.push_back(val);
-    }
-                    
-    for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
+    rendering = ! rendering;
+    
+    // the render settings' oversampling follows with the next parameters, the band split
+    // regroups its channels for the workers
+    const auto numGroups = rendering ? jmin (maxRenderWorkers, workers.getNumWorkers()) : 1;
+    floatEngine.crossover.setNumGroups (numGroups);
+    doubleEngine.crossover.setNumGroups (numGroups);
+}
+
+Dsp::ParameterSnapshot InflationPluginAudioProcessor::getRenderParameters (Dsp::ParameterSnapshot params) const noexcept
+{
+    // the band split's crossovers are IIR with no linear phase form, so Best is all in the oversampling
+    if (rendering && params.renderQuality == 1)
     {
-        juce::LinearSmoothedValue<float> val;
-        val.setTargetValue(-100.0f);
-        outputRMS.push_back(val);
+        params.oversampling = Dsp::Oversampler<float>::maxOrder;
+        params.oversamplingFilter = 0;
     }
+    
+    return params;
+}
+
+Dsp::MemoryReport InflationPluginAudioProcessor::getMemoryReport() const noexcept
+{
+    Dsp::MemoryReport report;
+    report.instanceBytes = sizeof (*this) + arena.getSizeInBytes();
+    report.sharedBytes = Dsp::SharedMemory::getBytes();
+    report.numSharedResources = Dsp::SharedMemory::getNumResources();
+    return report;
 }
 
 //==============================================================================
 void InflationPluginAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
 {
     jassert (! isUsingDoublePrecision());
-    process (buffer, dryBuffer_float, lowBuffer_float, highBuffer_float);
+    process<Dsp::SinglePrecision> (buffer);
 }
 
 void InflationPluginAudioProcessor::processBlock (AudioBuffer<double>& buffer, MidiBuffer& midiMessages)
 {
     jassert (isUsingDoublePrecision());
-    process (buffer, dryBuffer_double, lowBuffer_double, highBuffer_double);
+    (this->*processDouble) (buffer);
 }
 
 //==============================================================================
@@ -155,245 +324,519 @@ AudioProcessorEditor* InflationPluginAudioProcessor::createEditor()
 //==============================================================================
 void InflationPluginAudioProcessor::getStateInformation (MemoryBlock& destData)
 {
-    // Store an xml representation of our state.
-    if (auto xmlState = state.copyState().createXml())
-        copyXmlToBinary (*xmlState, destData);
+    // a short binary record, see Dsp::StateFormat
+    const auto uiState = state.state.getChildWithName ("uiState");
+    
+    Dsp::StateFormat::State stateToSave;
+    stateToSave.values = parameters.loadRaw();
+    stateToSave.width = uiState.getProperty ("width", stateToSave.width);
+    stateToSave.height = uiState.getProperty ("height", stateToSave.height);
+    stateToSave.program = currentProgram;
+    
+    Dsp::StateFormat::write (stateToSave, destData);
 }
 
 void InflationPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // Restore our plug-in's state from the xml representation stored in the above
-    // method.
+    // anything the data doesn't have goes back to its default
+    Dsp::StateFormat::State restored;
+    
+    for (auto i = 0; i < Dsp::numParameters; ++i)
+        if (auto* parameter = state.getParameter (Dsp::parameterIds[i]))
+            restored.values[(size_t) i] = parameter->convertFrom0to1 (parameter->getDefaultValue());
+    
+    if (Dsp::StateFormat::read (data, sizeInBytes, restored))
+    {
+        // the data is the host's and may be damaged: NaN or Inf goes back to the default,
+        // everything else onto the nearest value the parameter can actually take
+        for (auto i = 0; i < Dsp::numParameters; ++i)
+        {
+            if (auto* parameter = state.getParameter (Dsp::parameterIds[i]))
+            {
+                auto& value = restored.values[(size_t) i];
+                
+                if (! std::isfinite (value))
+                    value = parameter->convertFrom0to1 (parameter->getDefaultValue());
+                
+                value = parameter->getNormalisableRange().snapToLegalValue (value);
+            }
+        }
+        
+        applyParameters (restored.values);
+        currentProgram = jlimit (0, getNumPrograms() - 1, restored.program);
+        
+        auto uiState = state.state.getChildWithName ("uiState");
+        uiState.setProperty ("width", restored.width, nullptr);
+        uiState.setProperty ("height", restored.height, nullptr);
+        return;
+    }
+    
+    // sessions saved before the binary format hold the state tree as XML
     if (auto xmlState = getXmlFromBinary (data, sizeInBytes))
         state.replaceState (ValueTree::fromXml (*xmlState));
 }
 
-template <typename FloatType>
-void InflationPluginAudioProcessor::process (AudioBuffer<FloatType>& buffer,
-                                             AudioBuffer<FloatType>& dry_buffer,
-                                             AudioBuffer<FloatType>& low_buffer,
-                                             AudioBuffer<FloatType>& high_buffer)
+void InflationPluginAudioProcessor::setCurrentProgram (int index)
+{
+    if (! isPositiveAndBelow (index, getNumPrograms()))
+        return;
+    
+    currentProgram = index;
+    applyParameters (Dsp::getFactoryPresets()[(size_t) index].values.toRawValues());
+}
+
+const String InflationPluginAudioProcessor::getProgramName (int index)
+{
+    return isPositiveAndBelow (index, getNumPrograms()) ? Dsp::getFactoryPresets()[(size_t) index].name : "";
+}
+
+void InflationPluginAudioProcessor::selectComparisonSlot (int slot)
 {
+    jassert (slot == 0 || slot == 1);
+    
+    if (slot == comparisonSlot)
+        return;
+    
+    comparisonValues[(size_t) comparisonSlot] = parameters.loadRaw();
+    comparisonStored[(size_t) comparisonSlot] = true;
+    comparisonSlot = slot;
+    
+    // the first visit to a slot starts from the settings just left
+    if (comparisonStored[(size_t) slot])
+        applyParameters (comparisonValues[(size_t) slot]);
+}
+
+void InflationPluginAudioProcessor::applyParameters (const Dsp::RawParameterValues& values)
+{
+    // the parameters change one at a time, but from here until end() every block runs the
+    // complete new set, so none of them mixes old and new settings
+    parameterHandOver.begin (Dsp::ParameterSnapshot::fromRawValues (values));
+    
+    for (auto i = 0; i < Dsp::numParameters; ++i)
+        if (auto* parameter = state.getParameter (Dsp::parameterIds[i]))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (values[(size_t) i]));
+    
+    parameterHandOver.end();
+}
+
+template <typename Policy>
+void InflationPluginAudioProcessor::process (AudioBuffer<typename Policy::IoType>& buffer)
+{
+    using FloatType = typename Policy::ComputeType;
+    auto& engine = getEngine (FloatType());
+    
+    // the band split's filter tails decay into denormals, which the CPU handles slowly
+    ScopedNoDenormals noDenormals;
+    
     // deal with it
     if (buffer.getNumSamples() == 0){
         return; // there is nothing to do
     }
     
-    //Returns 0 to 1 values
-    auto preGainRawValue  = state.getParameter ("preGain")->getValue();
-    auto postGainRawValue = state.getParameter ("postGain")->getValue();
-    auto mixRawValue = state.getParameter("mix")->getValue();
-    auto curveRawValue = state.getParameter("curve")->getValue();
-    auto toClipValue = state.getParameter("zeroClip")->getValue();
-    auto toBandSplit = state.getParameter("bandSplit")->getValue();
-    
-    // convert back to representation
-    auto preGainParamValue  = state.getParameter ("preGain")->convertFrom0to1(preGainRawValue);
-    auto postGainParamValue  = state.getParameter ("postGain")->convertFrom0to1(postGainRawValue);
-    auto mixParamValue  = mixRawValue;
-    auto curveParamValue  = state.getParameter ("curve")->convertFrom0to1(curveRawValue);
-    bool toClipParamValue = state.getParameter("zeroClip")->convertFrom0to1(toClipValue);
-    bool toBandSplitParamValue = state.getParameter("bandSplit")->convertFrom0to1(toBandSplit);
+    INFLATION_PROFILE_BLOCK (profiler, buffer.getNumSamples());
+    
+    followRenderMode();
+    
+    // one lock-free read of every parameter for this block, or the preset being switched to
+    const auto params = getRenderParameters (parameterHandOver.load (parameters));
     
     auto numSamples = buffer.getNumSamples();
+    
+    // pick up oversampling and limiter changes, these also report the new latency
+    updateOversampling (engine, params);
+    updateLimiter (engine, params);
+    
+    // smoothed values for this block; when none of them move the pipeline runs its non-ramping kernels
+    preGainRamp.setTarget (Decibels::decibelsToGain ((double) params.preGain));
+    postGainRamp.setTarget (Decibels::decibelsToGain ((double) params.postGain));
+    mixRamp.setTarget (params.mix);
+    curveRamp.setTarget (params.curve);
+    
+    // the matching gain moves once per 100 ms step of the loudness meter, and back to unity when Auto Output is off
+    matchingRamp.setTarget (params.autoOutput ? loudnessMeter.getMatchingGain() : 1.0);
+    
+    for (size_t i = 0; i < crossoverRamps.size(); ++i)
+        crossoverRamps[i].setTarget (std::log2 ((double) params.crossovers[i]));
+    
+    for (size_t i = 0; i < bandCurveRamps.size(); ++i)
+        bandCurveRamps[i].setTarget (params.bandCurves[i]);
+    
+    // a different band count is a different set of filters, which start over
+    engine.crossover.setNumBands (params.numBands);
 
     // In case we have more outputs than inputs, we'll clear any output
     // channels that didn't contain input data, (because these aren't
     // guaranteed to be empty - they may contain garbage).
     for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
         buffer.clear (i, 0, numSamples);
-
-    // Apply our gain change to the outgoing data..
-    applyGain (buffer, Decibels::decibelsToGain(preGainParamValue));
     
-    // calculate input rms for metering
-    for (auto i = 0; i < getTotalNumInputChannels(); ++i)
-    {
-        const auto channelRMS =  static_cast<float>(Decibels::gainToDecibels(buffer.getRMSLevel(i, 0, numSamples)));
-        
-        inputRMS[i].skip(numSamples);
-        
-        if (channelRMS < inputRMS[i].getCurrentValue())
-        {
-            inputRMS[i].setTargetValue(channelRMS); // smooth down
-        }
-        else
-        {
-            inputRMS[i].setCurrentAndTargetValue(channelRMS); // immediate set to target
-        }
-    }
+    const auto numChannels = jmin (buffer.getNumChannels(), maxNumChannels);
+    Dsp::ChannelLevels<FloatType> inputLevels[maxNumChannels], outputLevels[maxNumChannels];
+    
+    // the analyzer gets the block as it came in and as it goes out, only while an editor is open
+    analyzer.pushInput (buffer, numChannels);
+    analyzer.setShape (params.curve, params.zeroClip);
     
-    // add dry signal
-    for (auto i = 0; i < buffer.getNumChannels(); ++i)
     {
-        dry_buffer.copyFrom(i, 0, buffer.getWritePointer(i), buffer.getNumSamples());
+        INFLATION_PROFILE_STAGE (profiler, loudness);
+        loudnessMeter.pushInput (buffer, jmin (numChannels, getTotalNumInputChannels()));
     }
     
-    // process wet
-    if (toBandSplitParamValue)
+    const auto inputSilent = isSilent (buffer, numChannels);
+    silentSamples = inputSilent ? silentSamples + numSamples : 0;
+    
+    if (inputSilent && sleeping.load (std::memory_order_relaxed))
     {
-        // bandspliting
-        for (auto i = 0; i < buffer.getNumChannels(); ++i)
-        {
-            low_buffer.copyFrom(i, 0, buffer.getWritePointer(i), buffer.getNumSamples());
-        }
-        
-        juce::dsp::AudioBlock<FloatType> low_block (low_buffer);
-        juce::dsp::ProcessContextReplacing<FloatType> low_context (low_block);
-
-        for (auto i = 0; i < buffer.getNumChannels(); ++i)
-        {
-            high_buffer.copyFrom(i, 0, buffer.getWritePointer(i), buffer.getNumSamples());
-        }
-        
-        juce::dsp::AudioBlock<FloatType> high_block (high_buffer);
-        juce::dsp::ProcessContextReplacing<FloatType> high_context (high_block);
-
-        lpf.process(low_context);
-        hpf.process(high_context);
-        
-        // get mid stuff by cancelling lows and highs
-        buffer.applyGain(-1.0f); // invert phase
-        for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
-        {
-            buffer.addFrom(i, 0, low_buffer, i, 0, low_buffer.getNumSamples());
-            buffer.addFrom(i, 0, high_buffer, i, 0, high_buffer.getNumSamples());
-        }
-        buffer.applyGain(-1.0f); // revert phase
-        
-        // by now, buffer contains mid info
-        
-        // zero cliping
-        if (toClipParamValue)
-            for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
-            {
-                FloatVectorOperations::clip (low_buffer.getWritePointer (i), low_buffer.getWritePointer (i),
-                                             -1.0f, 1.0f, numSamples);
-                FloatVectorOperations::clip (buffer.getWritePointer (i), buffer.getWritePointer (i),
-                                             -1.0f, 1.0f, numSamples);
-                FloatVectorOperations::clip (high_buffer.getWritePointer (i), high_buffer.getWritePointer (i),
-                                             -1.0f, 1.0f, numSamples);
-            }
+        // nothing left in the state, so silence in is silence out; the smoothers skip
+        // ahead so a wake up starts on the current settings
+        buffer.clear();
         
-        // apply wave shaping independently
-        applyWaveShaping(low_buffer, curveParamValue);
-        applyWaveShaping(buffer, curveParamValue);
-        applyWaveShaping(high_buffer, curveParamValue);
+        for (auto* ramp : { &preGainRamp, &postGainRamp, &mixRamp, &curveRamp, &matchingRamp })
+            ramp->setCurrentAndTarget (ramp->getTarget());
         
-        // sum back
-        for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
-        {
-            buffer.addFrom(i, 0, low_buffer, i, 0, low_buffer.getNumSamples());
-            buffer.addFrom(i, 0, high_buffer, i, 0, high_buffer.getNumSamples());
-        }
-    }
-    else
-    {
-        // no bandsplit
+        for (auto& ramp : crossoverRamps)
+            ramp.setCurrentAndTarget (ramp.getTarget());
         
-        // zero cliping
-        if (toClipParamValue)
-            for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
-               FloatVectorOperations::clip (buffer.getWritePointer (i), buffer.getWritePointer (i),
-                                            -1.0f, 1.0f, numSamples);
+        for (auto& ramp : bandCurveRamps)
+            ramp.setCurrentAndTarget (ramp.getTarget());
         
-        applyWaveShaping(buffer, curveParamValue);
+        pushMeters (inputLevels, outputLevels, numChannels, numSamples);
+        pushLoudness (buffer, numChannels);
+        analyzer.pushOutput (buffer, numChannels);
+        return;
     }
     
-    // add wet
-    applyMixing(buffer, dry_buffer, mixParamValue);
-        
-    // apply output gain
-    applyGain (buffer, Decibels::decibelsToGain(postGainParamValue));
+    sleeping = false;
     
-    // calculate output rms for metering
-    for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
+    // whatever the host's block size, the work is done in sub-blocks that keep every
+    // stage's buffers in cache, and that the scratch arena is sized for
+    const auto subBlockSize = getSubBlockSize (engine.oversampler.getOrder());
+    
+    for (auto start = 0; start < numSamples; start += subBlockSize)
     {
-        const auto channelRMS =  static_cast<float>(Decibels::gainToDecibels(buffer.getRMSLevel(i, 0, numSamples)));
-        
-        outputRMS[i].skip(numSamples);
+        const auto subBlockLength = jmin (subBlockSize, numSamples - start);
         
-        if (channelRMS < outputRMS[i].getCurrentValue())
+        if constexpr (Policy::converts)
         {
-            outputRMS[i].setTargetValue(channelRMS); // smooth down
+            // the chain runs on a converted copy of the host's samples
+            AudioBuffer<FloatType> subBlock (engine.ioBuffer.getArrayOfWritePointers(), numChannels, subBlockLength);
+            
+            for (auto i = 0; i < numChannels; ++i)
+                Dsp::convertSamples (buffer.getReadPointer (i, start), subBlock.getWritePointer (i), subBlockLength);
+            
+            processSubBlock (subBlock, engine, params, inputLevels, outputLevels);
+            recoverFromNonFinite (subBlock, engine, outputLevels);
+            
+            for (auto i = 0; i < numChannels; ++i)
+                Dsp::convertSamples (subBlock.getReadPointer (i), buffer.getWritePointer (i, start), subBlockLength);
         }
         else
         {
-            outputRMS[i].setCurrentAndTargetValue(channelRMS); // immediate targt
+            AudioBuffer<FloatType> subBlock (buffer.getArrayOfWritePointers(), numChannels, start, subBlockLength);
+            processSubBlock (subBlock, engine, params, inputLevels, outputLevels);
+            recoverFromNonFinite (subBlock, engine, outputLevels);
         }
     }
+    
+    pushMeters (inputLevels, outputLevels, numChannels, numSamples);
+    pushLoudness (buffer, numChannels);
+    analyzer.pushOutput (buffer, numChannels);
+    
+    // go to sleep once the input has been silent for longer than anything can ring, and
+    // the output agrees; the state is cleared so that waking up starts from exact zeros
+    if (silentSamples >= getLatencySamples() + decaySamples
+         && std::all_of (outputLevels, outputLevels + numChannels,
+                         [] (const auto& levels) { return levels.peak <= static_cast<FloatType> (silenceThreshold); }))
+    {
+        engine.reset();
+        dryDelayPrimed = false;
+        sleeping = true;
+    }
 }
 
 template <typename FloatType>
-void InflationPluginAudioProcessor::applyMixing(AudioBuffer<FloatType>& buffer, AudioBuffer<FloatType>& dryBuffer, float mix)
+void InflationPluginAudioProcessor::pushMeters (const Dsp::ChannelLevels<FloatType>* inputLevels,
+                                                const Dsp::ChannelLevels<FloatType>* outputLevels,
+                                                int numChannels, int numSamples)
 {
-    // use linear
-    auto dryValue = (1.0f) - mix;
-    auto wetValue = mix;
+    INFLATION_PROFILE_STAGE (profiler, meters);
+    
+    // metering, measured on the way through
+    for (auto i = 0; i < jmin (numChannels, getTotalNumInputChannels()); ++i)
+        inputMeterBus.push (i, inputLevels[i].getRmsDecibels (numSamples), inputLevels[i].getPeakDecibels(), numSamples);
+    
+    for (auto i = 0; i < jmin (numChannels, getTotalNumOutputChannels()); ++i)
+        outputMeterBus.push (i, outputLevels[i].getRmsDecibels (numSamples), outputLevels[i].getPeakDecibels(), numSamples);
+}
 
-    buffer.applyGain(wetValue);
-    dryBuffer.applyGain(dryValue);
+template <typename SampleType>
+void InflationPluginAudioProcessor::pushLoudness (const AudioBuffer<SampleType>& buffer, int numChannels)
+{
+    INFLATION_PROFILE_STAGE (profiler, loudness);
     
-    for (auto i = 0; i < getTotalNumOutputChannels(); ++i)
-        buffer.addFrom(i, 0, dryBuffer, i, 0, buffer.getNumSamples());
+    // the output gain the block ended on, which Auto Output's matching leaves out
+    loudnessMeter.pushOutput (buffer, jmin (numChannels, getTotalNumOutputChannels()),
+                              postGainRamp.getCurrentValue() * matchingRamp.getCurrentValue());
 }
 
 template <typename FloatType>
-void InflationPluginAudioProcessor::applyGain (AudioBuffer<FloatType>& buffer, float gainLevel)
+void InflationPluginAudioProcessor::recoverFromNonFinite (AudioBuffer<FloatType>& subBlock, Engine<FloatType>& engine,
+                                                          Dsp::ChannelLevels<FloatType>* outputLevels)
 {
-    for (auto channel = 0; channel < getTotalNumOutputChannels(); ++channel)
-        buffer.applyGain (channel, 0, buffer.getNumSamples(), gainLevel);
+    const auto numChannels = subBlock.getNumChannels();
+    
+    // a NaN or Inf anywhere in a channel leaves its sum of squares non-finite, so the
+    // output meter already tells whether something blew up, e.g. a huge input into x⁴
+    if (std::all_of (outputLevels, outputLevels + numChannels,
+                     [] (const auto& levels) { return std::isfinite (levels.sumOfSquares); }))
+        return;
+    
+    // it would stay in the filters and delay lines, so drop the sub-block and start over
+    subBlock.clear();
+    engine.reset();
+    dryDelayPrimed = false;
+    std::fill (outputLevels, outputLevels + numChannels, Dsp::ChannelLevels<FloatType>());
+    ++numNonFiniteResets;
 }
 
 template <typename FloatType>
-void InflationPluginAudioProcessor::applyWaveShaping (AudioBuffer<FloatType>& buffer, float curve)
+bool InflationPluginAudioProcessor::isSilent (const AudioBuffer<FloatType>& buffer, int numChannels) noexcept
 {
-    //    where the coefficients A, B, C and D are given by the Curve parameter:
-    //
-    //    A(curve) = 1 + (curve + 50)/100
-    //    B(curve) = - curve/50
-    //    C(curve) = (curve - 50)/100
-    //    D(curve) = ¹⁄₁₆ - curve/400 + curve²/(4⋅10⁴)
-    auto a = 1.0f + (curve + 50.0f) / 100.0f;
-    auto b = -curve / 50.0f;
-    auto c = (curve - 50.0f) / 100.0f;
-    auto d = 1.0f / 16.0f - curve / 400.0f + curve * curve / (40000.0f);
+    INFLATION_PROFILE_STAGE (profiler, silenceCheck);
     
-    // f(x) = A⋅x + B⋅x² + C⋅x³ - D⋅(x² - 2⋅x³ + x⁴)
+    for (auto i = 0; i < numChannels; ++i)
+    {
+        Dsp::ChannelLevels<FloatType> levels;
+        Dsp::Pipeline::measure (buffer.getReadPointer (i), buffer.getNumSamples(), levels);
+        
+        // NaN compares false, so it never counts as silence
+        if (! (levels.peak <= static_cast<FloatType> (silenceThreshold) && std::isfinite (levels.sumOfSquares)))
+            return false;
+    }
     
-    auto numSamples = buffer.getNumSamples();
+    return true;
+}
 
-    for (auto channel = 0; channel < getTotalNumInputChannels(); ++channel)
+template <typename FloatType>
+void InflationPluginAudioProcessor::processSubBlock (AudioBuffer<FloatType>& buffer,
+                                                     Engine<FloatType>& engine,
+                                                     const Dsp::ParameterSnapshot& params,
+                                                     Dsp::ChannelLevels<FloatType>* inputLevels,
+                                                     Dsp::ChannelLevels<FloatType>* outputLevels)
+{
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = buffer.getNumChannels();
+    auto& dry_buffer = engine.dryBuffer;
+    auto& oversampler = engine.oversampler;
+    auto& dry_delay = engine.dryDelay;
+    auto& crossover = engine.crossover;
+    
+    const auto preGain = preGainRamp.advance (numSamples);
+    const auto matching = matchingRamp.advance (numSamples);
+    auto postGain = postGainRamp.advance (numSamples);
+    postGain = { postGain.start * matching.start, postGain.end * matching.end };
+    const auto mix = mixRamp.advance (numSamples);
+    const auto curve = curveRamp.advance (numSamples);
+    
+    const auto settings = Dsp::PipelineSettings<FloatType>::make (preGain, mix, postGain, curve, numSamples, params.zeroClip);
+    
+    // the band split's ramps keep time while it's off too, so switching it on starts from the current settings
+    Dsp::BlockRamp crossovers[Dsp::maxCrossovers], bandCurves[Dsp::maxBands];
+    bool bandClips[Dsp::maxBands];
+    
+    for (auto i = 0; i < Dsp::maxCrossovers; ++i)
     {
-        auto channelData = buffer.getWritePointer (channel);
-      
-        for (auto i = 0; i < numSamples; ++i)
+        const auto octaves = crossoverRamps[(size_t) i].advance (numSamples);
+        crossovers[i] = { std::exp2 (octaves.start), std::exp2 (octaves.end) };
+    }
+    
+    for (auto i = 0; i < Dsp::maxBands; ++i)
+    {
+        const auto offset = bandCurveRamps[(size_t) i].advance (numSamples);
+        bandCurves[i] = { jlimit (-50.0, 50.0, curve.start + offset.start), jlimit (-50.0, 50.0, curve.end + offset.end) };
+        bandClips[i] = params.zeroClip && params.bandClips[(size_t) i];
+    }
+    
+    // the shaper's last inputs are only kept while ADAA is on, so it starts again from silence
+    if (params.adaa != engine.antiderivative)
+    {
+        engine.antiderivative = params.adaa;
+        engine.shaperHistory.fill (0);
+        engine.dryHistory.fill (0);
+    }
+    
+    crossover.setAntiderivative (params.adaa);
+    
+    if (params.bandSplit)
+    {
+        crossover.setCrossovers (crossovers, numSamples);
+        crossover.setBands (bandCurves, bandClips, numSamples);
+    }
+    
+    // with the limiter in, the output is measured after it instead
+    Dsp::ChannelLevels<FloatType> unlimitedLevels[maxNumChannels];
+    auto* pipelineLevels = limiting ? unlimitedLevels : outputLevels;
+    
+    if (oversampler.getOrder() == 0 && ! params.bandSplit && ! params.adaa)
+    {
+        // everything in one pass per channel, the dry signal never leaves the registers
+        INFLATION_PROFILE_STAGE (profiler, fused);
+        
+        for (auto i = 0; i < numChannels; ++i)
+            Dsp::Pipeline::process (buffer.getWritePointer (i), numSamples, settings, inputLevels[i], pipelineLevels[i]);
+    }
+    else
+    {
+        // the delay line isn't fed while fully wet, so start it from silence when the dry signal comes back
+        if (settings.fullWet)
+            dryDelayPrimed = false;
+        else if (! dryDelayPrimed)
+        {
+            dry_delay.reset();
+            crossover.resetDry();
+            engine.dryHistory.fill (0);
+            dryDelayPrimed = true;
+        }
+        
         {
-            auto x = channelData[i];
-            channelData[i] = a * x +
-                             b * std::pow(x, 2) +
-                             c * std::pow(x, 3) -
-                             d * (std::pow(x, 2) - 2 * std::pow(x, 3) + std::pow(x, 4));
+            INFLATION_PROFILE_STAGE (profiler, gain);
+            
+            for (auto i = 0; i < numChannels; ++i)
+            {
+                auto* dry = settings.fullWet ? nullptr : dry_buffer.getWritePointer (i);
+                Dsp::Pipeline::processInput (buffer.getWritePointer (i), dry, numSamples, settings, inputLevels[i]);
+            }
         }
+        
+        if (! settings.fullWet)
+        {
+            INFLATION_PROFILE_STAGE (profiler, dryPath);
+            
+            // the band sum is phase shifted by the crossover, so shift the dry path to match
+            if (params.bandSplit)
+                crossover.processDry (dry_buffer.getArrayOfWritePointers(), numChannels, numSamples);
+            
+            // ADAA averages each sample with the one before at the rate it shapes at, which is half a
+            // sample of delay there; the dry signal gets the same, or the mix combs towards Nyquist.
+            // Without oversampling that's exactly the two tap average ADAA is in its linear region
+            if (params.adaa)
+            {
+                const auto fraction = FloatType (0.5) / static_cast<FloatType> (oversampler.getFactor());
+                
+                for (auto i = 0; i < numChannels; ++i)
+                    delayByFraction (dry_buffer.getWritePointer (i), numSamples, fraction, engine.dryHistory[(size_t) i]);
+            }
+            
+            // delayed to line up with the oversampled wet signal
+            for (auto i = 0; i < numChannels; ++i)
+                dry_delay.process (i, dry_buffer.getWritePointer (i), numSamples);
+        }
+        
+        // process wet: up through the oversampler, clip and shape, and back down. The band split
+        // takes a group of channels at once, every band of every channel in lanes of its own;
+        // the shaper goes a channel at a time. An offline render shares the groups or the
+        // channels out over the workers
+        const auto wetSamples = numSamples * oversampler.getFactor();
+        FloatType* wet[maxNumChannels] {};
+        
+        const auto upsample = [&] (int channel)
+        {
+            wet[channel] = buffer.getWritePointer (channel);
+            
+            if (oversampler.getOrder() > 0)
+            {
+                INFLATION_PROFILE_STAGE (profiler, oversampling);
+                wet[channel] = oversampler.processUp (channel, wet[channel], numSamples);
+            }
+        };
+        
+        const auto downsample = [&] (int channel)
+        {
+            if (oversampler.getOrder() > 0)
+            {
+                INFLATION_PROFILE_STAGE (profiler, oversampling);
+                oversampler.processDown (channel, buffer.getWritePointer (channel), numSamples);
+            }
+        };
+        
+        const auto processWet = [&] (int task, int)
+        {
+            if (! params.bandSplit)
+            {
+                upsample (task);
+                applyNonLinearity (wet[task], wetSamples, curve, params.zeroClip, params.adaa, engine.shaperHistory[(size_t) task]);
+                downsample (task);
+                return;
+            }
+            
+            const auto channels = crossover.getGroupChannels (task, numChannels);
+            
+            for (auto i = channels.getStart(); i < channels.getEnd(); ++i)
+                upsample (i);
+            
+            {
+                // each sample is split, clipped, shaped and summed back in one go, every band
+                // with its own curve and clip as set up above
+                INFLATION_PROFILE_STAGE (profiler, split);
+                crossover.processGroup (task, wet, numChannels, wetSamples);
+            }
+            
+            for (auto i = channels.getStart(); i < channels.getEnd(); ++i)
+                downsample (i);
+        };
+        
+        const auto numTasks = params.bandSplit ? crossover.getNumGroups() : numChannels;
+        
+        if (rendering)
+        {
+            workers.run (numTasks, processWet);
+        }
+        else
+        {
+            for (auto i = 0; i < numTasks; ++i)
+                processWet (i, 0);
+        }
+        
+        // add wet, apply output gain
+        INFLATION_PROFILE_STAGE (profiler, mix);
+        
+        for (auto i = 0; i < numChannels; ++i)
+            Dsp::Pipeline::processOutput (buffer.getWritePointer (i), dry_buffer.getReadPointer (i), numSamples,
+                                          settings, pipelineLevels[i]);
+    }
+    
+    // true peak safety after the output gain
+    if (limiting)
+    {
+        INFLATION_PROFILE_STAGE (profiler, limiter);
+        engine.limiter.process (buffer.getArrayOfWritePointers(), numChannels, numSamples, outputLevels);
     }
 }
 
-std::vector<float> InflationPluginAudioProcessor::getInputRMSValue()
+template <typename FloatType>
+void InflationPluginAudioProcessor::applyNonLinearity (FloatType* data, int numSamples, Dsp::BlockRamp curve,
+                                                       bool toClip, bool antiderivative, FloatType& history)
 {
-    std::vector<float> rmsValues;
-    for (auto i : inputRMS)
-    {
-        rmsValues.push_back(i.getCurrentValue());
-    }
-    return rmsValues;
+    // f(x) = A⋅x + B⋅x² + C⋅x³ - D⋅(x² - 2⋅x³ + x⁴), see Dsp::ShaperCoefficients
+    const auto coefficients = Dsp::ShaperCoefficients<FloatType>::fromCurve (curve.start);
+    const auto increment = coefficients.getIncrementTo (Dsp::ShaperCoefficients<FloatType>::fromCurve (curve.end), numSamples);
+    
+    INFLATION_PROFILE_STAGE (profiler, clipAndShape);
+    
+    // ADAA shapes the mean between neighbouring samples instead, see Dsp::Antiderivative
+    if (antiderivative)
+        Dsp::Pipeline::processAntiderivative (data, numSamples, coefficients, increment, toClip, ! curve.isConstant(), history);
+    else
+        Dsp::Pipeline::processNonLinear (data, numSamples, coefficients, increment, toClip, ! curve.isConstant());
 }
 
-std::vector<float> InflationPluginAudioProcessor::getOutputRMSValue()
+template <typename FloatType>
+void InflationPluginAudioProcessor::delayByFraction (FloatType* data, int numSamples, FloatType fraction, FloatType& history) noexcept
 {
-    std::vector<float> rmsValues;
-    for (auto i : outputRMS)
+    for (auto i = 0; i < numSamples; ++i)
     {
-        rmsValues.push_back(i.getCurrentValue());
+        const auto x = data[i];
+        data[i] = (1 - fraction) * x + fraction * history;
+        history = x;
     }
-    return rmsValues;
 }
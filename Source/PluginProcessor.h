@@ -3,6 +3,22 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "WaveShaper.h"
+#include "Oversampler.h"
+#include "Crossover.h"
+#include "TruePeakLimiter.h"
+#include "ParameterSnapshot.h"
+#include "StateFormat.h"
+#include "Presets.h"
+#include "Pipeline.h"
+#include "MeterBus.h"
+#include "ScratchArena.h"
+#include "Precision.h"
+#include "SharedResources.h"
+#include "Profiler.h"
+#include "Analyzer.h"
+#include "LoudnessMeter.h"
+#include "WorkerPool.h"
 
 class InflationPluginAudioProcessor  : public AudioProcessor
 {
@@ -35,12 +51,14 @@ public:
     bool acceptsMidi() const override                                 { return false; }
     bool producesMidi() const override                                { return false; }
     double getTailLengthSeconds() const override                      { return 0.0; }
+    bool supportsDoublePrecisionProcessing() const override           { return true; }
 
     //==============================================================================
-    int getNumPrograms() override                                     { return 0; }
-    int getCurrentProgram() override                                  { return 0; }
-    void setCurrentProgram (int) override                             {}
-    const String getProgramName (int) override                        { return "None"; }
+    // the factory presets
+    int getNumPrograms() override                                     { return (int) Dsp::getFactoryPresets().size(); }
+    int getCurrentProgram() override                                  { return currentProgram; }
+    void setCurrentProgram (int index) override;
+    const String getProgramName (int index) override;
     void changeProgramName (int, const String&) override              {}
 
     //==============================================================================
@@ -51,38 +69,209 @@ public:
     // Our plug-in's current state
     AudioProcessorValueTreeState state;
     
-    std::vector<float> getInputRMSValue();
-    std::vector<float> getOutputRMSValue();
+    // any discrete or surround layout up to 16 channels, the dry path's all passes have a SIMD lane for each
+    static constexpr int maxNumChannels = Dsp::maxChannels;
+    
+    using MeterBus = Dsp::MeterBus<maxNumChannels>;
+    
+    // read by the editor on every display refresh, written once per block by the audio thread
+    MeterBus& getInputMeterBus() noexcept   { return inputMeterBus; }
+    MeterBus& getOutputMeterBus() noexcept  { return outputMeterBus; }
+    
+    /** When the host processes in double, run the chain in float between double I/O.
+        Takes effect at the next prepareToPlay. */
+    void setMixedPrecision (bool shouldUseMixedPrecision) noexcept  { mixedPrecisionRequested = shouldUseMixedPrecision; }
+    bool isUsingMixedPrecision() const noexcept                     { return mixedPrecision; }
+    
+    /** The most threads an offline render shares its channels out over, the calling thread
+        included; 1 renders on the calling thread alone. Takes effect at the next prepareToPlay. */
+    void setMaxRenderWorkers (int numWorkers) noexcept              { maxRenderWorkers = jmax (1, numWorkers); }
+    
+    /** This instance's own memory next to what it shares with every other instance.
+        Leaves out the parameter tree, which JUCE allocates. */
+    Dsp::MemoryReport getMemoryReport() const noexcept;
+    
+    /** True while the input has been silent long enough for every filter and delay line to
+        run out; blocks are then cleared instead of processed. Any thread may ask. */
+    bool isSleeping() const noexcept                { return sleeping.load (std::memory_order_relaxed); }
+    
+    /** How many times the state was thrown away because a sub-block came out as NaN or Inf. */
+    int getNumNonFiniteResets() const noexcept      { return numNonFiniteResets.load (std::memory_order_relaxed); }
+    
+    /** A/B comparison: keeps the current settings in the slot being left and switches to
+        what was kept in the other, if anything was. Message thread. */
+    void selectComparisonSlot (int slot);
+    int getComparisonSlot() const noexcept          { return comparisonSlot; }
+    
+    /** Spectrum and transfer curve for the editor, which starts and stops its thread. */
+    Dsp::Analyzer& getAnalyzer() noexcept           { return analyzer; }
+    
+    /** BS.1770 loudness and true peak of the input and the output, and Auto Output's gain. */
+    Dsp::LoudnessMeter& getLoudnessMeter() noexcept { return loudnessMeter; }
+    
+   #if INFLATION_PROFILING
+    /** Stage and block timings of the audio thread, see Dsp::Profiler. */
+    Dsp::Profiler& getProfiler() noexcept           { return profiler; }
+   #endif
 
 private:
     //==============================================================================
+    /** Everything that runs at one compute precision. Its sample memory is in the arena. */
+    template <typename FloatType>
+    struct Engine
+    {
+        AudioBuffer<FloatType> dryBuffer;
+        AudioBuffer<FloatType> ioBuffer;    // the host's samples converted, mixed precision only
+        Dsp::Oversampler<FloatType> oversampler;
+        Dsp::DelayCompensation<FloatType> dryDelay;
+        Dsp::MultiBandCrossover<FloatType> crossover;
+        Dsp::TruePeakLimiter<FloatType> limiter;
+        
+        // each channel's last input to the shaper, and its last dry sample, kept while ADAA is on
+        std::array<FloatType, Dsp::maxChannels> shaperHistory {};
+        std::array<FloatType, Dsp::maxChannels> dryHistory {};
+        bool antiderivative = false;
+        
+        void prepare (Dsp::ScratchArena& memory, int numChannels, bool convertsIo, double sampleRate,
+                      int maxSubBlockSize, int maxOversampledSubBlockSize, int numWorkers);
+        void reset();
+    };
+    
+    template <typename Policy>
+    void process (AudioBuffer<typename Policy::IoType>& buffer);
+    
+    template <typename FloatType>
+    void processSubBlock (AudioBuffer<FloatType>& buffer,
+                          Engine<FloatType>& engine,
+                          const Dsp::ParameterSnapshot& params,
+                          Dsp::ChannelLevels<FloatType>* inputLevels,
+                          Dsp::ChannelLevels<FloatType>* outputLevels);
+    
+    template <typename FloatType>
+    void pushMeters (const Dsp::ChannelLevels<FloatType>* inputLevels,
+                     const Dsp::ChannelLevels<FloatType>* outputLevels, int numChannels, int numSamples);
+    
+    template <typename SampleType>
+    void pushLoudness (const AudioBuffer<SampleType>& buffer, int numChannels);
+    
+    template <typename FloatType>
+    void recoverFromNonFinite (AudioBuffer<FloatType>& subBlock, Engine<FloatType>& engine,
+                               Dsp::ChannelLevels<FloatType>* outputLevels);
+    
     template <typename FloatType>
-    void process (AudioBuffer<FloatType>& buffer,
-                  AudioBuffer<FloatType>& dry_buffer,
-                  AudioBuffer<FloatType>& low_buffer,
-                  AudioBuffer<FloatType>& high_buffer);
+    bool isSilent (const AudioBuffer<FloatType>& buffer, int numChannels) noexcept;
     
     template <typename FloatType>
-    void applyGain (AudioBuffer<FloatType>& buffer, float gainLevel);
+    void applyNonLinearity (FloatType* data, int numSamples, Dsp::BlockRamp curve,
+                            bool toClip, bool antiderivative, FloatType& history);
     
+    // delays by a fraction of a sample, the weight of the one before; ADAA's delay on the dry path
     template <typename FloatType>
-    void applyWaveShaping(AudioBuffer<FloatType>& buffer, float curve);
+    static void delayByFraction (FloatType* data, int numSamples, FloatType fraction, FloatType& history) noexcept;
     
     template <typename FloatType>
-    void applyMixing(AudioBuffer<FloatType>& buffer, AudioBuffer<FloatType>& dryBuffer, float mix);
+    void updateOversampling (Engine<FloatType>& engine, const Dsp::ParameterSnapshot& params, bool force = false);
+    
+    template <typename FloatType>
+    void updateLimiter (Engine<FloatType>& engine, const Dsp::ParameterSnapshot& params, bool force = false);
+    
+    template <typename FloatType>
+    void updateLatency (Engine<FloatType>& engine);
+    
+    Engine<float>& getEngine (float) noexcept     { return floatEngine; }
+    Engine<double>& getEngine (double) noexcept   { return doubleEngine; }
+    
+    // sets every parameter, with blocks running the complete new set from the start
+    void applyParameters (const Dsp::RawParameterValues& values);
+    
+    // picks up a change of isNonRealtime() since the last block
+    void followRenderMode() noexcept;
+    
+    // what actually runs: while rendering at Best, the highest oversampling with linear phase filters
+    Dsp::ParameterSnapshot getRenderParameters (Dsp::ParameterSnapshot params) const noexcept;
+    
+    template <typename FloatType>
+    static void takeChannels (Dsp::ScratchArena& memory, AudioBuffer<FloatType>& buffer, int numChannels, int numSamples);
+    
+    // host blocks are cut into sub-blocks of at most 256 samples, fewer when oversampling
+    // so that a sub-block is never more than 1024 samples at the oversampled rate; offline
+    // renders use eight times that, where latency doesn't matter and fewer, longer passes do
+    static constexpr int realtimeSubBlockSize = 256;
+    static constexpr int realtimeOversampledSubBlockSize = 1024;
+    static constexpr int renderSubBlockSize = 8 * realtimeSubBlockSize;
+    static constexpr int renderOversampledSubBlockSize = 8 * realtimeOversampledSubBlockSize;
+    
+    int getSubBlockSize (int oversamplingOrder) const noexcept
+    {
+        return rendering ? jmin (renderSubBlockSize, renderOversampledSubBlockSize >> oversamplingOrder)
+                         : jmin (realtimeSubBlockSize, realtimeOversampledSubBlockSize >> oversamplingOrder);
+    }
+    
+    // below this a block counts as silent (-120 dBFS); sleep starts once the input has been
+    // silent for the latency plus the time the filters take to decay, and the output too
+    static constexpr double silenceThreshold = 1.0e-6;
+    static constexpr double silenceDecaySeconds = 0.1;
+    
+    // the True Peak Limit choices after Off, in dBTP
+    static constexpr double getLimiterCeiling (int choice) noexcept
+    {
+        return choice == 1 ? -0.1 : (choice == 2 ? -0.3 : -1.0);
+    }
+    
+    static AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     static BusesProperties getBusesProperties(){
         return BusesProperties().withInput  ("Input",  AudioChannelSet::stereo(), true)
                                 .withOutput ("Output", AudioChannelSet::stereo(), true);
     }
     
-    std::vector<juce::LinearSmoothedValue<float>> inputRMS, outputRMS;
-    void resetMeterValues();
+    Dsp::ParameterCache parameters;
+    Dsp::SnapshotHandOver parameterHandOver;
+    
+    int currentProgram = 0;
+    
+    // the settings kept for A/B, with a flag for whether a slot has been used yet
+    std::array<Dsp::RawParameterValues, 2> comparisonValues {};
+    std::array<bool, 2> comparisonStored {};
+    int comparisonSlot = 0;
+    Dsp::LinearRamp preGainRamp, postGainRamp, mixRamp, curveRamp;
+    Dsp::LinearRamp matchingRamp;   // Auto Output's gain, on top of the output gain
+    std::array<Dsp::LinearRamp, Dsp::maxCrossovers> crossoverRamps;   // in octaves, log2 of Hz
+    std::array<Dsp::LinearRamp, Dsp::maxBands> bandCurveRamps;
+    
+    MeterBus inputMeterBus, outputMeterBus;
+    
+    // all sample memory of both engines lives in here, the engines only refer to it
+    Dsp::ScratchArena arena;
+    
+    // float serves single and mixed precision, double only true double
+    Engine<float> floatEngine;
+    Engine<double> doubleEngine;
+    
+    // the policy for double precision blocks, picked in prepareToPlay
+    using DoubleProcess = void (InflationPluginAudioProcessor::*) (AudioBuffer<double>&);
+    DoubleProcess processDouble = nullptr;
+    bool mixedPrecisionRequested = false, mixedPrecision = false;
+    
+    double preparedSampleRate = 44100.0;
+    bool rendering = false;     // isNonRealtime() as of the last block
+    int maxRenderWorkers = Dsp::maxChannels;
+    bool dryDelayPrimed = false;
+    bool limiting = false;
+    
+    int64 silentSamples = 0, decaySamples = 0;
+    std::atomic<bool> sleeping { false };
+    std::atomic<int> numNonFiniteResets { 0 };
+    
+    Dsp::Analyzer analyzer;
+    Dsp::LoudnessMeter loudnessMeter;
     
-    dsp::StateVariableTPTFilter<float> lpf, hpf;
+    // offline renders share the channels out over these, they sleep while playing in real time
+    Dsp::WorkerPool workers;
     
-    AudioBuffer<float> dryBuffer_float, lowBuffer_float, highBuffer_float;
-    AudioBuffer<double> dryBuffer_double, lowBuffer_double, highBuffer_double;
+   #if INFLATION_PROFILING
+    Dsp::Profiler profiler;
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InflationPluginAudioProcessor)
 };
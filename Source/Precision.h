@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  What a processor instance exchanges with the host (IoType) and what every DSP stage
+        computes in (ComputeType). The processor picks one in prepareToPlay and runs it
+        for every block until the next prepare.
+
+        Mixed precision keeps the host's double buffers but runs the chain in float, so
+        every vector kernel gets twice the lanes. The samples are converted on the way in
+        and out of each sub-block.
+    */
+    template <typename Io, typename Compute>
+    struct PrecisionPolicy
+    {
+        using IoType = Io;
+        using ComputeType = Compute;
+
+        static constexpr bool converts = ! std::is_same<Io, Compute>::value;
+    };
+
+    using SinglePrecision = PrecisionPolicy<float, float>;
+    using DoublePrecision = PrecisionPolicy<double, double>;
+    using MixedPrecision  = PrecisionPolicy<double, float>;
+
+    /** Copies a block between precisions, the compiler vectorises the conversion. */
+    template <typename Source, typename Destination>
+    inline void convertSamples (const Source* source, Destination* destination, int numSamples) noexcept
+    {
+        for (auto i = 0; i < numSamples; ++i)
+            destination[i] = static_cast<Destination> (source[i]);
+    }
+}
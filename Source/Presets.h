@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /** A named set of parameters, ready to hand to the audio thread as it is. */
+    struct Preset
+    {
+        const char* name;
+        ParameterSnapshot values;
+    };
+
+    //==============================================================================
+    /** The presets the host lists as programs. The first is the parameters' defaults. */
+    inline const std::vector<Preset>& getFactoryPresets()
+    {
+        static const std::vector<Preset> presets = []
+        {
+            auto make = [] (const char* name, float preGain, float postGain, float mix, float curve,
+                            bool zeroClip, bool bandSplit, int oversampling, int truePeakLimit)
+            {
+                ParameterSnapshot values;
+                values.preGain = preGain;
+                values.postGain = postGain;
+                values.mix = mix;
+                values.curve = curve;
+                values.zeroClip = zeroClip;
+                values.bandSplit = bandSplit;
+                values.oversampling = oversampling;
+                values.truePeakLimit = truePeakLimit;
+                return Preset { name, values };
+            };
+
+            //                                 in     out   mix    curve  clip   split  over  limit
+            return std::vector<Preset> {
+                make ("Default",           0.0f,  0.0f, 1.0f,   0.0f, true,  false, 0,    0),
+                make ("Gentle Glue",       0.0f,  0.0f, 0.5f, -20.0f, true,  false, 0,    0),
+                make ("Mix Bus Warmth",    1.0f, -1.0f, 0.6f,   0.0f, true,  false, 1,    0),
+                make ("Band Split Punch",  2.0f, -1.0f, 1.0f,  10.0f, true,  true,  1,    0),
+                make ("Loud Master",       3.0f,  0.0f, 1.0f,  20.0f, true,  false, 2,    3),
+                make ("Hard Edge",         6.0f, -3.0f, 1.0f,  50.0f, true,  false, 2,    1),
+            };
+        }();
+
+        return presets;
+    }
+}
@@ -9,7 +9,14 @@ InflationPluginAudioProcessorEditor:: InflationPluginAudioProcessorEditor(Inflat
     mixAttachment           (owner.state, "mix", mixSlider),
     curveAttachment         (owner.state, "curve", curveSlider),
     zeroClipButtonAttachment(owner.state, "zeroClip", zeroClipButton),
-    bandSplitButtonAttachment(owner.state, "bandSplit", bandSplitButton)
+    bandSplitButtonAttachment(owner.state, "bandSplit", bandSplitButton),
+    adaaButtonAttachment    (owner.state, "adaa", adaaButton),
+    analyzerDisplay         (owner.getAnalyzer()),
+    bandPanel               (owner.state),
+    loudnessPanel           (owner.getLoudnessMeter(), owner.state)
+   #if INFLATION_PROFILING
+    , profilerPanel (owner.getProfiler())
+   #endif
 {
     
     // add some components..
@@ -19,13 +26,62 @@ InflationPluginAudioProcessorEditor:: InflationPluginAudioProcessorEditor(Inflat
     addAndMakeVisible (curveSlider);
     addAndMakeVisible (zeroClipButton);
     addAndMakeVisible (bandSplitButton);
+    addAndMakeVisible (adaaButton);
+    addAndMakeVisible (oversamplingBox);
+    addAndMakeVisible (oversamplingFilterBox);
+    addAndMakeVisible (truePeakLimitBox);
+    addAndMakeVisible (renderQualityBox);
     addAndMakeVisible (titleLabel);
+    addAndMakeVisible (presetBox);
+    addAndMakeVisible (comparisonAButton);
+    addAndMakeVisible (comparisonBButton);
+    addAndMakeVisible (analyzerDisplay);
+    addAndMakeVisible (bandPanel);
+    addAndMakeVisible (loudnessPanel);
         
     resetMeters(); // adds meters and make visible
     
     // set label text
     zeroClipButton.setButtonText("0 dB Clip");
     bandSplitButton.setButtonText("Band Split");
+    adaaButton.setButtonText("ADAA");
+    
+    // combo boxes take their items from the choice parameters
+    if (auto* oversamplingParam = dynamic_cast<AudioParameterChoice*> (owner.state.getParameter ("oversampling")))
+        oversamplingBox.addItemList (oversamplingParam->choices, 1);
+    
+    if (auto* filterParam = dynamic_cast<AudioParameterChoice*> (owner.state.getParameter ("oversamplingFilter")))
+        oversamplingFilterBox.addItemList (filterParam->choices, 1);
+    
+    if (auto* limitParam = dynamic_cast<AudioParameterChoice*> (owner.state.getParameter ("truePeakLimit")))
+        truePeakLimitBox.addItemList (limitParam->choices, 1);
+    
+    // "As Playback" and "Best" need saying what they're for, next to the oversampling boxes
+    if (auto* renderParam = dynamic_cast<AudioParameterChoice*> (owner.state.getParameter ("renderQuality")))
+        for (auto i = 0; i < renderParam->choices.size(); ++i)
+            renderQualityBox.addItem ("Render " + renderParam->choices[i], i + 1);
+    
+    // presets switch on the audio thread as a whole, see InflationPluginAudioProcessor::applyParameters
+    for (auto i = 0; i < owner.getNumPrograms(); ++i)
+        presetBox.addItem (owner.getProgramName (i), i + 1);
+    
+    presetBox.setSelectedItemIndex (owner.getCurrentProgram(), dontSendNotification);
+    presetBox.onChange = [this] { getProcessor().setCurrentProgram (presetBox.getSelectedItemIndex()); };
+    
+    for (auto* button : { &comparisonAButton, &comparisonBButton })
+    {
+        button->setClickingTogglesState (true);
+        button->setRadioGroupId (1);
+    }
+    
+    (owner.getComparisonSlot() == 0 ? comparisonAButton : comparisonBButton).setToggleState (true, dontSendNotification);
+    comparisonAButton.onClick = [this] { if (comparisonAButton.getToggleState()) getProcessor().selectComparisonSlot (0); };
+    comparisonBButton.onClick = [this] { if (comparisonBButton.getToggleState()) getProcessor().selectComparisonSlot (1); };
+    
+    oversamplingAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment> (owner.state, "oversampling", oversamplingBox);
+    oversamplingFilterAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment> (owner.state, "oversamplingFilter", oversamplingFilterBox);
+    truePeakLimitAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment> (owner.state, "truePeakLimit", truePeakLimitBox);
+    renderQualityAttachment = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment> (owner.state, "renderQuality", renderQualityBox);
     
     // slider init
     preGainSlider.setSliderStyle (Slider::LinearVertical);
@@ -46,11 +102,11 @@ InflationPluginAudioProcessorEditor:: InflationPluginAudioProcessorEditor(Inflat
     mixLabel.attachToComponent (&mixSlider, false);
     curveLabel.attachToComponent (&curveSlider, false);
     
-    preGainLabel.setFont (Font (sonicLookAndFeel.getFontSize()));
-    postGainLabel.setFont (Font (sonicLookAndFeel.getFontSize()));
-    mixLabel.setFont (Font (sonicLookAndFeel.getFontSize()));
-    curveLabel.setFont (Font (sonicLookAndFeel.getFontSize()));
-    titleLabel.setFont(sonicLookAndFeel.getTitleFont());
+    preGainLabel.setFont (Font (sonicLookAndFeel->getFontSize()));
+    postGainLabel.setFont (Font (sonicLookAndFeel->getFontSize()));
+    mixLabel.setFont (Font (sonicLookAndFeel->getFontSize()));
+    curveLabel.setFont (Font (sonicLookAndFeel->getFontSize()));
+    titleLabel.setFont(sonicLookAndFeel->getTitleFont());
         
     preGainLabel.setJustificationType(juce::Justification::centred);
     postGainLabel.setJustificationType(juce::Justification::centred);
@@ -63,7 +119,7 @@ InflationPluginAudioProcessorEditor:: InflationPluginAudioProcessorEditor(Inflat
     curveSlider.setTextBoxStyle(juce::Slider::TextBoxAbove, false, curveSlider.getTextBoxWidth(), curveSlider.getTextBoxHeight());
 
     // set resize limits for this plug-in
-    setResizeLimits (600, 450, 600, 450);  // prevent resize for now
+    setResizeLimits (600, 700, 600, 700);  // prevent resize for now
     setResizable (false, false);
         
 //    setResizeLimits (600, 450, 1200, 900);
@@ -72,18 +128,23 @@ InflationPluginAudioProcessorEditor:: InflationPluginAudioProcessorEditor(Inflat
     lastUIWidth.referTo (owner.state.state.getChildWithName ("uiState").getPropertyAsValue ("width",  nullptr));
     lastUIHeight.referTo (owner.state.state.getChildWithName ("uiState").getPropertyAsValue ("height", nullptr));
 
-    // set our component's initial size to be the last one that was stored in the filter's settings
-    setSize (lastUIWidth.getValue(), lastUIHeight.getValue());
+    // set our component's initial size to be the last one that was stored in the filter's settings,
+    // kept within the limits since older sessions stored a shorter editor
+    auto* constrainer = getConstrainer();
+    setSize (jlimit (constrainer->getMinimumWidth(), constrainer->getMaximumWidth(), (int) lastUIWidth.getValue()),
+             jlimit (constrainer->getMinimumHeight(), constrainer->getMaximumHeight(), (int) lastUIHeight.getValue()));
     
     lastUIWidth.addListener (this);
     lastUIHeight.addListener (this);
         
+   #if INFLATION_PROFILING
+    addChildComponent (profilerPanel);
+    setWantsKeyboardFocus (true);
+   #endif
+    
     // set look and feel
     backgroundColour = juce::Colours::whitesmoke;
-    setLookAndFeel(&sonicLookAndFeel);
-
-    // start a timer to update level meter
-    startTimerHz (24);
+    setLookAndFeel(sonicLookAndFeel);
 }
 
 InflationPluginAudioProcessorEditor::~InflationPluginAudioProcessorEditor()
@@ -103,11 +164,8 @@ InflationPluginAudioProcessorEditor::~InflationPluginAudioProcessorEditor()
 //==============================================================================
 void InflationPluginAudioProcessorEditor::paint (Graphics& g)
 {
-    if(Process::isForegroundProcess())
-    {
-        g.setColour (backgroundColour);
-        g.fillAll();
-    }
+    g.setColour (backgroundColour);
+    g.fillAll();
 }
 
 void InflationPluginAudioProcessorEditor::resized()
@@ -117,11 +175,24 @@ void InflationPluginAudioProcessorEditor::resized()
     
     auto bounds = getLocalBounds();
     
-    titleLabel.setBounds(bounds.removeFromTop(sonicLookAndFeel.getTitleFontSize()));
+    // presets on the left of the title and A/B on the right, the same width each so the title stays centred
+    auto titleRow = bounds.removeFromTop(sonicLookAndFeel->getTitleFontSize());
+    presetBox.setBounds (titleRow.removeFromLeft (160).reduced (10, 15));
+    
+    auto comparisonArea = titleRow.removeFromRight (160).reduced (10, 15);
+    comparisonBButton.setBounds (comparisonArea.removeFromRight (30));
+    comparisonAButton.setBounds (comparisonArea.removeFromRight (30));
+    
+    titleLabel.setBounds(titleRow);
     titleLabel.setJustificationType(Justification::centred);
     
     // add some margin between title and controls
-    bounds.removeFromTop(sonicLookAndFeel.getFontSize() * 2);
+    bounds.removeFromTop(sonicLookAndFeel->getFontSize() * 2);
+    
+    // the analyzer along the bottom with the band controls and the loudness above it, the controls keep the space they had before them
+    analyzerDisplay.setBounds (bounds.removeFromBottom (120).reduced (10, 0).withTrimmedBottom (10));
+    bandPanel.setBounds (bounds.removeFromBottom (90).reduced (10, 5));
+    loudnessPanel.setBounds (bounds.removeFromBottom (40).reduced (10, 2));
     
     // left to right controls
     FlexBox controlsFlexbox;
@@ -134,12 +205,21 @@ void InflationPluginAudioProcessorEditor::resized()
     int sliderHeight = bounds.getHeight() * 0.8;
 
     Array<FlexItem> controlsItemArray;
-    controlsItemArray.add(FlexItem(sliderWidth, sliderHeight, preGainSlider));
-    for (int i = 0; i < inputMeters.size(); i++)
+    
+    // a bus's meters share the space a stereo pair takes, however many channels it has
+    auto addMeters = [&] (OwnedArray<Gui::LevelMeter>& meters)
     {
-        auto meterItem = FlexItem(sliderWidth / 4, sliderHeight, *inputMeters[i]).withMargin(meterMargin);
-        controlsItemArray.add(meterItem);
-    }
+        const int meterSpace = sliderWidth / 2 + meterMargin * 4;
+        const int slotWidth = meterSpace / jmax (1, meters.size());
+        const int margin = jmin (meterMargin, slotWidth / 4);
+        
+        for (auto* meter : meters)
+            controlsItemArray.add(FlexItem(slotWidth - margin * 2, sliderHeight, *meter)
+                                  .withMargin(FlexItem::Margin(meterMargin, margin, meterMargin, margin)));
+    };
+    
+    controlsItemArray.add(FlexItem(sliderWidth, sliderHeight, preGainSlider));
+    addMeters (inputMeters);
 
     controlsItemArray.add(FlexItem(sliderWidth, sliderHeight, mixSlider));
 
@@ -148,53 +228,99 @@ void InflationPluginAudioProcessorEditor::resized()
     buttonFlexBox.flexDirection = FlexBox::Direction::column;
     buttonFlexBox.flexWrap = FlexBox::Wrap::noWrap;
     buttonFlexBox.alignContent = FlexBox::AlignContent::stretch;
-    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel.getFontSize() * 2, bandSplitButton));
-    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel.getFontSize() * 2, zeroClipButton));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, bandSplitButton));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, zeroClipButton));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, adaaButton));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, oversamplingBox));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, oversamplingFilterBox));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, truePeakLimitBox));
+    buttonFlexBox.items.add(FlexItem(sliderWidth, sonicLookAndFeel->getFontSize() * 2, renderQualityBox));
     
     controlsItemArray.add(FlexItem(sliderWidth, sliderHeight, buttonFlexBox)
                           .withFlex(1.0f)
                           .withMargin(
-                                      FlexItem::Margin(bounds.getHeight() / 2, 0, 0, 0)
+                                      // lifted by two rows so all seven fit
+                                      FlexItem::Margin(bounds.getHeight() / 2 - sonicLookAndFeel->getFontSize() * 4, 0, 0, 0)
                                       )
                           );
 
     // continue other items
     controlsItemArray.add(FlexItem(sliderWidth, sliderHeight, curveSlider));
-    for (int i = 0; i < outputMeters.size(); i++)
-    {
-        auto meterItem = FlexItem(sliderWidth/4, sliderHeight, *outputMeters[i]).withMargin(meterMargin);
-        controlsItemArray.add(meterItem);
-    }
+    addMeters (outputMeters);
     controlsItemArray.add(FlexItem(sliderWidth, sliderHeight, postGainSlider));
 
     controlsFlexbox.items = controlsItemArray;
     controlsFlexbox.performLayout(bounds);
+    
+   #if INFLATION_PROFILING
+    profilerPanel.setBounds (getLocalBounds().reduced (20));
+   #endif
 
 }
 
-void InflationPluginAudioProcessorEditor::timerCallback()
+void InflationPluginAudioProcessorEditor::updateDisplay()
 {
-    // update level meter
-    std::vector<float> inputRmsValues = getProcessor().getInputRMSValue();
-    std::vector<float> outputRmsValues = getProcessor().getOutputRMSValue();
+    // the host can change the layout while the editor is open
+    if (inputMeters.size() != getProcessor().getTotalNumInputChannels()
+         || outputMeters.size() != getProcessor().getTotalNumOutputChannels())
+    {
+        resetMeters();
+        resized();
+    }
+    
+    // the meters' holds decay in real time, whatever the display's refresh rate
+    const auto now = Time::getMillisecondCounterHiRes() * 0.001;
+    const auto elapsedSeconds = lastUpdateTime > 0.0 ? jmin (0.25, now - lastUpdateTime) : 0.0;
+    lastUpdateTime = now;
+    
+    // update level meter, straight from the processor's atomics
+    updateMeters (inputMeters, getProcessor().getInputMeterBus(), elapsedSeconds);
+    updateMeters (outputMeters, getProcessor().getOutputMeterBus(), elapsedSeconds);
+    
+    // the host can change the program too
+    if (presetBox.getSelectedItemIndex() != getProcessor().getCurrentProgram())
+        presetBox.setSelectedItemIndex (getProcessor().getCurrentProgram(), dontSendNotification);
     
-//    // TODO: need to improve this when plugin changes it's channel size after initialisation.
-//    jassert(inputRmsValues.size() == inputMeters.size());
-//    jassert(outputRmsValues.size() == outputMeters.size());
+    // repaints only when the analyzer's thread has published a new frame
+    analyzerDisplay.update();
     
-    // it means setting only 1 channel when mono, leaving right channel untouched.
-    for (int i = 0; i < inputRmsValues.size(); i++)
+    // follows the band count, which a preset or the host may change
+    bandPanel.update();
+    
+    // the loudness thread publishes about every 50 ms
+    loudnessPanel.update();
+}
+
+#if INFLATION_PROFILING
+bool InflationPluginAudioProcessorEditor::keyPressed (const KeyPress& key)
+{
+    if (key == KeyPress ('p', ModifierKeys::commandModifier | ModifierKeys::shiftModifier, 0))
     {
-        inputMeters[i]->setLevel(inputRmsValues[i]);
-        if(Process::isForegroundProcess())
-            inputMeters[i]->repaint();
+        profilerPanel.setVisible (! profilerPanel.isVisible());
+        profilerPanel.toFront (false);
+        return true;
     }
+    
+    return false;
+}
+#endif
 
-    for (int i = 0; i < outputRmsValues.size(); i++)
+void InflationPluginAudioProcessorEditor::updateMeters (OwnedArray<Gui::LevelMeter>& meters,
+                                                        InflationPluginAudioProcessor::MeterBus& meterBus,
+                                                        double elapsedSeconds)
+{
+    // the bus only knows the channels it was prepared with, until then the meters stay empty
+    const auto numChannels = jmin (meters.size(), meterBus.getNumChannels());
+    
+    for (int i = 0; i < numChannels; i++)
     {
-        outputMeters[i]->setLevel(outputRmsValues[i]);
-        if ( Process::isForegroundProcess())
-            outputMeters[i]->repaint();
+        const auto reading = meterBus.read (i);
+        meters[i]->setLevel (reading.rms);
+        meters[i]->setPeak (reading.peak, elapsedSeconds);
+        meters[i]->setClipCount (reading.clipCount, elapsedSeconds);
+        
+        // only the rows that changed, and nothing when the level moved less than a pixel
+        meters[i]->update();
     }
 }
     
@@ -217,12 +343,9 @@ int InflationPluginAudioProcessorEditor::getControlParameterIndex (Component& co
 
 void InflationPluginAudioProcessorEditor::resetMeters()
 {
-//    auto inputChannels =  getProcessor().getTotalNumInputChannels();
-//    auto outputChannels =  getProcessor().getTotalNumOutputChannels();
-    
-    // fix at stereo for now
-    auto inputChannels =  2;
-    auto outputChannels =  2;
+    // one meter per channel of the current layout, a disabled input has none
+    auto inputChannels =  getProcessor().getTotalNumInputChannels();
+    auto outputChannels =  getProcessor().getTotalNumOutputChannels();
     
     for (auto levelMeter : inputMeters )
         removeChildComponent(levelMeter);
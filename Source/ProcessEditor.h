@@ -6,9 +6,12 @@
 #include "NumeralSlider.h"
 #include "LevelMeter.h"
 #include "SonicLookAndFeel.h"
+#include "ProfilerPanel.h"
+#include "AnalyzerDisplay.h"
+#include "BandPanel.h"
+#include "LoudnessPanel.h"
 
 class InflationPluginAudioProcessorEditor  : public AudioProcessorEditor,
-                                            private Timer,
                                             private Value::Listener
 {
 public:
@@ -18,8 +21,10 @@ public:
     //==============================================================================
     void paint (Graphics& g) override;
     void resized() override;
-    void timerCallback() override;
     int getControlParameterIndex (Component& control) override;
+   #if INFLATION_PROFILING
+    bool keyPressed (const KeyPress& key) override;
+   #endif
     void resetMeters();
 
 private:
@@ -33,19 +38,51 @@ private:
     NumeralSlider mixSlider, curveSlider;
     AudioProcessorValueTreeState::SliderAttachment preGainAttachment, postGainAttachment,mixAttachment, curveAttachment;
     
-    juce::ToggleButton zeroClipButton, bandSplitButton;
-    AudioProcessorValueTreeState::ButtonAttachment zeroClipButtonAttachment, bandSplitButtonAttachment;
+    juce::ToggleButton zeroClipButton, bandSplitButton, adaaButton;
+    AudioProcessorValueTreeState::ButtonAttachment zeroClipButtonAttachment, bandSplitButtonAttachment, adaaButtonAttachment;
+    
+    // combo box items have to exist before attaching, so these are created in the constructor
+    juce::ComboBox oversamplingBox, oversamplingFilterBox, truePeakLimitBox, renderQualityBox;
+    std::unique_ptr<AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment, oversamplingFilterAttachment,
+                                                                      truePeakLimitAttachment, renderQualityAttachment;
+    
+    // factory presets and A/B, next to the title
+    juce::ComboBox presetBox;
+    juce::TextButton comparisonAButton { "A" }, comparisonBButton { "B" };
     
     OwnedArray<Gui::LevelMeter> inputMeters;
     OwnedArray<Gui::LevelMeter> outputMeters;
     
-    SonicLookAndFeel sonicLookAndFeel;
+    // transfer curve and spectrum along the bottom, its analyzer runs while this exists
+    Gui::AnalyzerDisplay analyzerDisplay;
+    
+    // band count, crossovers and per band curve and clip, above the analyzer
+    Gui::BandPanel bandPanel;
+    
+    // loudness and true peak in and out, with Auto Output, between the controls and the band panel
+    Gui::LoudnessPanel loudnessPanel;
+    
+    // called in step with the display's refresh
+    void updateDisplay();
+    void updateMeters (OwnedArray<Gui::LevelMeter>& meters, InflationPluginAudioProcessor::MeterBus& meterBus, double elapsedSeconds);
+    double lastUpdateTime = 0.0;
+    
+   #if INFLATION_PROFILING
+    // the profiler's numbers, hidden until Cmd/Ctrl+Shift+P
+    Gui::ProfilerPanel profilerPanel;
+   #endif
+    
+    // one look and feel for every open editor, freed with the last one
+    SharedResourcePointer<SonicLookAndFeel> sonicLookAndFeel;
     Colour backgroundColour;
 
     // these are used to persist the UI's size - the values are stored along with the
     // filter's other parameters, and the UI component will update them when it gets
     // resized.
     Value lastUIWidth, lastUIHeight;
+    
+    // last, so it stops before anything it updates goes away
+    VBlankAttachment vBlankAttachment { this, [this] { updateDisplay(); } };
 
     //==============================================================================
     InflationPluginAudioProcessor& getProcessor() const
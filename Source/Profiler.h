@@ -0,0 +1,230 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Set INFLATION_PROFILING=1 in the project's preprocessor definitions to build the profiler
+// in. Left at 0, the macros below expand to nothing and the processor has no profiler.
+#ifndef INFLATION_PROFILING
+ #define INFLATION_PROFILING 0
+#endif
+
+#if INFLATION_PROFILING
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace Dsp {
+
+    //==============================================================================
+    /** The parts of process() that are timed. Clip and shape run inside the band split
+        when it is on, and the fused pipeline does gain, clip, shape, mix and levels in one pass. */
+    enum class ProfileStage
+    {
+        silenceCheck, fused, gain, dryPath, oversampling, split, clipAndShape, mix, limiter, meters, loudness,
+        numStages
+    };
+
+    inline const char* getStageName (ProfileStage stage) noexcept
+    {
+        static const char* const names[] = { "silenceCheck", "fused", "gain", "dryPath", "oversampling",
+                                             "split", "clipAndShape", "mix", "limiter", "meters", "loudness" };
+        static_assert (std::size (names) == (size_t) ProfileStage::numStages, "a stage without a name");
+        return names[(size_t) stage];
+    }
+
+    //==============================================================================
+    /*  Per instance timing of the audio thread: cycles per stage, a histogram of each
+        block's time as a share of its real-time budget, and how many blocks went over.
+
+        The audio thread only adds to relaxed atomics, so it never locks and any thread can
+        take a Snapshot or reset the counters; a snapshot taken mid block can be one stage
+        ahead of its block count.
+    */
+    class Profiler
+    {
+    public:
+        static constexpr int numStages = (int) ProfileStage::numStages;
+        static constexpr int numBins = 21;      // 5% of the budget each, the last is everything over it
+
+        struct Snapshot
+        {
+            std::array<uint64, numStages> cycles {}, calls {};
+            std::array<uint64, numBins> histogram {};
+            uint64 blocks = 0, samples = 0, overBudget = 0;
+            double worstLoad = 0.0;             // the slowest block's time over its budget
+        };
+
+        /** A cycle counter where there is one, the high resolution timer elsewhere. */
+        static uint64 readCycles() noexcept
+        {
+           #if JUCE_INTEL
+            return (uint64) __rdtsc();
+           #else
+            return (uint64) Time::getHighResolutionTicks();
+           #endif
+        }
+
+        //==============================================================================
+        /** Sets the rate block budgets are worked out at. Call from prepareToPlay. */
+        void prepare (double newSampleRate) noexcept    { sampleRate.store (newSampleRate, std::memory_order_relaxed); }
+
+        void addStage (ProfileStage stage, uint64 elapsedCycles) noexcept
+        {
+            cycles[(size_t) stage].fetch_add (elapsedCycles, std::memory_order_relaxed);
+            calls[(size_t) stage].fetch_add (1, std::memory_order_relaxed);
+        }
+
+        void addBlock (int64 elapsedTicks, int numSamples) noexcept
+        {
+            const auto seconds = Time::highResolutionTicksToSeconds (elapsedTicks);
+            const auto budget = numSamples / sampleRate.load (std::memory_order_relaxed);
+            const auto load = seconds / budget;
+            const auto bin = jlimit (0, numBins - 1, (int) (load * (numBins - 1)));
+
+            histogram[(size_t) bin].fetch_add (1, std::memory_order_relaxed);
+            blocks.fetch_add (1, std::memory_order_relaxed);
+            samples.fetch_add ((uint64) numSamples, std::memory_order_relaxed);
+
+            if (load >= 1.0)
+                overBudget.fetch_add (1, std::memory_order_relaxed);
+
+            if (load > worstLoad.load (std::memory_order_relaxed))
+                worstLoad.store (load, std::memory_order_relaxed);
+        }
+
+        //==============================================================================
+        Snapshot getSnapshot() const noexcept
+        {
+            Snapshot snapshot;
+
+            for (size_t i = 0; i < (size_t) numStages; ++i)
+            {
+                snapshot.cycles[i] = cycles[i].load (std::memory_order_relaxed);
+                snapshot.calls[i] = calls[i].load (std::memory_order_relaxed);
+            }
+
+            for (size_t i = 0; i < (size_t) numBins; ++i)
+                snapshot.histogram[i] = histogram[i].load (std::memory_order_relaxed);
+
+            snapshot.blocks = blocks.load (std::memory_order_relaxed);
+            snapshot.samples = samples.load (std::memory_order_relaxed);
+            snapshot.overBudget = overBudget.load (std::memory_order_relaxed);
+            snapshot.worstLoad = worstLoad.load (std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        void reset() noexcept
+        {
+            for (auto* counters : { &cycles, &calls })
+                for (auto& counter : *counters)
+                    counter.store (0, std::memory_order_relaxed);
+
+            for (auto& bin : histogram)
+                bin.store (0, std::memory_order_relaxed);
+
+            blocks.store (0, std::memory_order_relaxed);
+            samples.store (0, std::memory_order_relaxed);
+            overBudget.store (0, std::memory_order_relaxed);
+            worstLoad.store (0.0, std::memory_order_relaxed);
+        }
+
+        //==============================================================================
+        static var toJson (const Snapshot& snapshot)
+        {
+            auto* report = new DynamicObject();
+            report->setProperty ("blocks", (int64) snapshot.blocks);
+            report->setProperty ("samples", (int64) snapshot.samples);
+            report->setProperty ("overBudget", (int64) snapshot.overBudget);
+            report->setProperty ("worstLoad", snapshot.worstLoad);
+
+            Array<var> stages;
+
+            for (auto i = 0; i < numStages; ++i)
+            {
+                auto* stage = new DynamicObject();
+                stage->setProperty ("stage", getStageName ((ProfileStage) i));
+                stage->setProperty ("calls", (int64) snapshot.calls[(size_t) i]);
+                stage->setProperty ("cycles", (int64) snapshot.cycles[(size_t) i]);
+                stage->setProperty ("cyclesPerSample", getCyclesPerSample (snapshot, i));
+                stages.add (var (stage));
+            }
+
+            Array<var> bins;
+
+            for (auto count : snapshot.histogram)
+                bins.add ((int64) count);
+
+            report->setProperty ("stages", stages);
+            report->setProperty ("loadHistogram", bins);
+            return var (report);
+        }
+
+        /** One row per stage, then one per histogram bin, named by the load it starts at. */
+        static String toCsv (const Snapshot& snapshot)
+        {
+            String csv ("name,count,cycles,cyclesPerSample\n");
+
+            for (auto i = 0; i < numStages; ++i)
+                csv << getStageName ((ProfileStage) i) << ',' << (int64) snapshot.calls[(size_t) i] << ','
+                    << (int64) snapshot.cycles[(size_t) i] << ',' << getCyclesPerSample (snapshot, i) << '\n';
+
+            for (auto i = 0; i < numBins; ++i)
+                csv << "load" << getBinStartPercent (i) << ',' << (int64) snapshot.histogram[(size_t) i] << ",,\n";
+
+            csv << "overBudget," << (int64) snapshot.overBudget << ",,\n";
+            return csv;
+        }
+
+        static double getCyclesPerSample (const Snapshot& snapshot, int stage) noexcept
+        {
+            return snapshot.samples > 0 ? (double) snapshot.cycles[(size_t) stage] / (double) snapshot.samples : 0.0;
+        }
+
+        static int getBinStartPercent (int bin) noexcept    { return bin * 100 / (numBins - 1); }
+
+        //==============================================================================
+        struct ScopedStage
+        {
+            ScopedStage (Profiler& p, ProfileStage s) noexcept : profiler (p), stage (s), start (readCycles()) {}
+            ~ScopedStage()  { profiler.addStage (stage, readCycles() - start); }
+
+            Profiler& profiler;
+            const ProfileStage stage;
+            const uint64 start;
+        };
+
+        struct ScopedBlock
+        {
+            ScopedBlock (Profiler& p, int n) noexcept : profiler (p), numSamples (n), start (Time::getHighResolutionTicks()) {}
+            ~ScopedBlock()  { profiler.addBlock (Time::getHighResolutionTicks() - start, numSamples); }
+
+            Profiler& profiler;
+            const int numSamples;
+            const int64 start;
+        };
+
+    private:
+        std::array<std::atomic<uint64>, numStages> cycles {}, calls {};
+        std::array<std::atomic<uint64>, numBins> histogram {};
+        std::atomic<uint64> blocks { 0 }, samples { 0 }, overBudget { 0 };
+        std::atomic<double> worstLoad { 0.0 }, sampleRate { 44100.0 };
+    };
+}
+
+ #define INFLATION_PROFILE_STAGE(profiler, stage) \
+    const Dsp::Profiler::ScopedStage JUCE_JOIN_MACRO (profiledStage, __LINE__) (profiler, Dsp::ProfileStage::stage)
+
+ #define INFLATION_PROFILE_BLOCK(profiler, numSamples) \
+    const Dsp::Profiler::ScopedBlock JUCE_JOIN_MACRO (profiledBlock, __LINE__) (profiler, numSamples)
+
+#else
+
+ #define INFLATION_PROFILE_STAGE(profiler, stage)
+ #define INFLATION_PROFILE_BLOCK(profiler, numSamples)
+
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Profiler.h"
+
+#if INFLATION_PROFILING
+
+namespace Gui {
+
+    //==============================================================================
+    /*  The profiler's counters as text, over the editor. Hidden until Cmd/Ctrl+Shift+P.
+        Reset starts the counters over; the save buttons write what was shown at the
+        time of the click as JSON or CSV.
+    */
+    class ProfilerPanel : public Component,
+                          private Timer
+    {
+    public:
+        explicit ProfilerPanel (Dsp::Profiler& profilerToShow)
+            : profiler (profilerToShow)
+        {
+            report.setMultiLine (true);
+            report.setReadOnly (true);
+            report.setCaretVisible (false);
+            report.setFont (Font (Font::getDefaultMonospacedFontName(), 12.0f, Font::plain));
+
+            resetButton.onClick = [this] { profiler.reset(); update(); };
+            jsonButton.onClick = [this] { save ("json"); };
+            csvButton.onClick = [this] { save ("csv"); };
+
+            addAndMakeVisible (report);
+            addAndMakeVisible (resetButton);
+            addAndMakeVisible (jsonButton);
+            addAndMakeVisible (csvButton);
+        }
+
+        /** Reads the counters again, a few times a second while the panel shows. */
+        void update()
+        {
+            const auto snapshot = profiler.getSnapshot();
+            String text;
+
+            text << "blocks " << (int64) snapshot.blocks << ", over budget " << (int64) snapshot.overBudget
+                 << ", worst " << String (snapshot.worstLoad * 100.0, 1) << "% of the budget\n\n";
+
+            text << "stage           calls      cycles/sample\n";
+
+            for (auto i = 0; i < Dsp::Profiler::numStages; ++i)
+                text << String (Dsp::getStageName ((Dsp::ProfileStage) i)).paddedRight (' ', 16)
+                     << String ((int64) snapshot.calls[(size_t) i]).paddedRight (' ', 11)
+                     << String (Dsp::Profiler::getCyclesPerSample (snapshot, i), 2) << '\n';
+
+            // bars scaled to the fullest bin
+            const auto fullest = jmax ((uint64) 1, *std::max_element (snapshot.histogram.begin(), snapshot.histogram.end()));
+            text << "\nblock time, % of budget\n";
+
+            for (auto i = 0; i < Dsp::Profiler::numBins; ++i)
+            {
+                const auto count = snapshot.histogram[(size_t) i];
+                text << String (Dsp::Profiler::getBinStartPercent (i)).paddedLeft (' ', 4)
+                     << (i == Dsp::Profiler::numBins - 1 ? "+ " : "  ")
+                     << String::repeatedString ("#", (int) (40 * count / fullest)) << ' ' << (int64) count << '\n';
+            }
+
+            report.setText (text, false);
+        }
+
+        void visibilityChanged() override
+        {
+            if (isVisible())
+            {
+                update();
+                startTimerHz (4);
+            }
+            else
+            {
+                stopTimer();
+            }
+        }
+
+        void paint (Graphics& g) override
+        {
+            g.fillAll (Colours::black.withAlpha (0.85f));
+        }
+
+        void resized() override
+        {
+            auto bounds = getLocalBounds().reduced (8);
+            auto buttons = bounds.removeFromBottom (24);
+
+            for (auto* button : { &resetButton, &jsonButton, &csvButton })
+                button->setBounds (buttons.removeFromLeft (90).reduced (2, 0));
+
+            report.setBounds (bounds.withTrimmedBottom (8));
+        }
+
+    private:
+        void timerCallback() override   { update(); }
+
+        void save (const String& extension)
+        {
+            const auto snapshot = profiler.getSnapshot();
+
+            chooser = std::make_unique<FileChooser> ("Save profile",
+                                                     File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("Inflation profile." + extension),
+                                                     "*." + extension);
+
+            chooser->launchAsync (FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles
+                                    | FileBrowserComponent::warnAboutOverwriting,
+                                  [snapshot, extension] (const FileChooser& fileChooser)
+                                  {
+                                      const auto file = fileChooser.getResult();
+
+                                      if (file != File())
+                                          file.replaceWithText (extension == "json" ? JSON::toString (Dsp::Profiler::toJson (snapshot))
+                                                                                    : Dsp::Profiler::toCsv (snapshot));
+                                  });
+        }
+
+        Dsp::Profiler& profiler;
+        TextEditor report;
+        TextButton resetButton { "Reset" }, jsonButton { "Save JSON" }, csvButton { "Save CSV" };
+        std::unique_ptr<FileChooser> chooser;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProfilerPanel)
+    };
+}
+
+#endif
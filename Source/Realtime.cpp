@@ -0,0 +1,88 @@
+#include "Realtime.h"
+
+#if JUCE_LINUX
+ #include <malloc.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <unistd.h>
+#endif
+
+namespace Dsp {
+
+namespace Realtime {
+
+Result lockMemory()
+{
+   #if JUCE_LINUX
+    rlimit limit {};
+
+    if (geteuid() != 0 && (getrlimit (RLIMIT_MEMLOCK, &limit) != 0 || limit.rlim_cur != RLIM_INFINITY))
+        return Result::fail ("memory not locked, the memlock limit isn't unlimited");
+
+    // freed memory stays with the process, where it is locked already, and large blocks come
+    // from the heap rather than from mappings of their own
+    mallopt (M_TRIM_THRESHOLD, -1);
+    mallopt (M_MMAP_MAX, 0);
+
+    if (mlockall (MCL_CURRENT | MCL_FUTURE) != 0)
+        return Result::fail ("memory not locked, " + String (std::strerror (errno)));
+
+    return Result::ok();
+   #else
+    return Result::fail ("memory not locked, only on Linux");
+   #endif
+}
+
+int promoteCurrentThread (int priority) noexcept
+{
+   #if JUCE_LINUX
+    if (getCurrentPriority() >= priority)
+        return 0;
+
+    sched_param parameters {};
+    parameters.sched_priority = jlimit (sched_get_priority_min (SCHED_FIFO), sched_get_priority_max (SCHED_FIFO), priority);
+    return pthread_setschedparam (pthread_self(), SCHED_FIFO, &parameters);
+   #else
+    ignoreUnused (priority);
+    return ENOTSUP;
+   #endif
+}
+
+int getCurrentPriority() noexcept
+{
+   #if JUCE_LINUX
+    auto policy = 0;
+    sched_param parameters {};
+
+    if (pthread_getschedparam (pthread_self(), &policy, &parameters) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR))
+        return parameters.sched_priority;
+   #endif
+
+    return 0;
+}
+
+String describeError (int error)
+{
+   #if JUCE_LINUX
+    if (error == EPERM)
+        return "not real-time, the rtprio limit is too low";
+   #endif
+
+    return "not real-time, " + String (std::strerror (error));
+}
+
+void prefaultStack() noexcept
+{
+    // a quarter of a megabyte, a page at a time; written through volatile so the writes stay
+    constexpr int size = 256 * 1024, pageSize = 4096;
+    char stack[size];
+
+    for (auto i = 0; i < size; i += pageSize)
+        static_cast<volatile char*> (stack)[i] = 0;
+}
+
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  What the low latency standalone asks of the system before it plays: no page
+        faults and a real-time audio thread. Linux only; elsewhere every call fails and
+        changes nothing, and the device's own thread is left as it is.
+
+        Both need the limits a distribution's audio group usually has, e.g. in
+        /etc/security/limits.d/audio.conf:
+
+            @audio - rtprio 95
+            @audio - memlock unlimited
+    */
+    namespace Realtime
+    {
+        /** Locks every page the process has and will ever have into RAM, faulting each one
+            in as it's mapped, and keeps malloc from handing freed memory back. Call once,
+            first thing, so everything allocated later is locked too. Does nothing unless the
+            memlock limit is unlimited (or the process is root): with it locked, an allocation
+            over the limit would fail instead of paging. */
+        Result lockMemory();
+
+        /** Moves the calling thread to SCHED_FIFO at the given priority, unless it already runs
+            real-time at least that high. Returns 0 or the error from pthread_setschedparam;
+            doesn't allocate, so the audio thread can call it. */
+        int promoteCurrentThread (int priority) noexcept;
+
+        /** The calling thread's real-time priority, or 0 when it isn't real-time. */
+        int getCurrentPriority() noexcept;
+
+        /** Why promoteCurrentThread() failed, for the message thread. */
+        String describeError (int error);
+
+        /** Touches the calling thread's stack deeper than a callback goes, so its pages are
+            there before the first one needs them. */
+        void prefaultStack() noexcept;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+
+    /** The most channels the DSP classes are prepared for. Their per-channel bookkeeping
+        is fixed size, so only sample memory comes from the arena. */
+    static constexpr int maxChannels = 16;
+
+    //==============================================================================
+    /** A run of elements inside a ScratchArena. Doesn't own anything. */
+    template <typename T>
+    struct ArenaArray
+    {
+        T* data() const noexcept                { return elements; }
+        int size() const noexcept               { return count; }
+        T* begin() const noexcept               { return elements; }
+        T* end() const noexcept                 { return elements + count; }
+        T& operator[] (int index) const noexcept { jassert (isPositiveAndBelow (index, count)); return elements[index]; }
+
+        void clear() const noexcept             { std::fill (begin(), end(), T()); }
+
+        T* elements = nullptr;
+        int count = 0;
+    };
+
+    //==============================================================================
+    /*  One aligned, zeroed allocation for all of a processor's sample memory.
+
+        build() runs the same layout function twice: the first pass only adds up what
+        it takes (every take returns an empty array), then the block is allocated and
+        the second pass hands out pieces of it. Each piece starts on a cache line, so
+        vector loads never split one and no two channels share one.
+
+        Everything that took from the block must take again in the same layout function
+        when it is rebuilt. A layout that fits in the block already there reuses it,
+        cleared, so switching back to a smaller one (the real-time sub-blocks after an
+        offline render) doesn't allocate.
+    */
+    class ScratchArena
+    {
+    public:
+        static constexpr size_t alignment = 64;
+
+        template <typename LayOut>
+        void build (LayOut&& layOut)
+        {
+            used = 0;
+            sizing = true;
+            layOut (*this);
+
+            const auto needed = used;
+            used = 0;
+            sizing = false;
+
+            if (base != nullptr && needed <= capacity)
+            {
+                std::fill (base, base + capacity, char());
+            }
+            else
+            {
+                capacity = needed;
+                storage.free();
+                storage.allocate (capacity + alignment, true);
+                base = storage.get() + (alignment - reinterpret_cast<uintptr_t> (storage.get()) % alignment) % alignment;
+            }
+
+            layOut (*this);
+
+            jassert (used == needed);
+        }
+
+        template <typename T>
+        ArenaArray<T> take (int count) noexcept
+        {
+            static_assert (std::is_trivially_copyable<T>::value, "arena memory is never constructed or destroyed");
+
+            const auto offset = used;
+            used += (sizeof (T) * static_cast<size_t> (jmax (0, count)) + alignment - 1) / alignment * alignment;
+
+            if (sizing || count <= 0)
+                return {};
+
+            return { reinterpret_cast<T*> (base + offset), count };
+        }
+
+        size_t getSizeInBytes() const noexcept  { return capacity; }
+
+    private:
+        HeapBlock<char> storage;
+        char* base = nullptr;
+        size_t used = 0, capacity = 0;
+        bool sizing = false;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+
+namespace Dsp {
+
+    //==============================================================================
+    /** Running totals over every shared table alive in the process. */
+    struct SharedMemory
+    {
+        static size_t getBytes() noexcept          { return getTotals().bytes.load(); }
+        static int getNumResources() noexcept      { return getTotals().resources.load(); }
+
+        static void added (size_t bytes) noexcept
+        {
+            getTotals().bytes += bytes;
+            ++getTotals().resources;
+        }
+
+        static void removed (size_t bytes) noexcept
+        {
+            getTotals().bytes -= bytes;
+            --getTotals().resources;
+        }
+
+    private:
+        struct Totals
+        {
+            std::atomic<size_t> bytes { 0 };
+            std::atomic<int> resources { 0 };
+        };
+
+        static Totals& getTotals() noexcept
+        {
+            static Totals totals;
+            return totals;
+        }
+    };
+
+    /** What one processor instance costs. Only instanceBytes grows with the instance count. */
+    struct MemoryReport
+    {
+        size_t instanceBytes = 0;       // the object itself and its scratch arena
+        size_t sharedBytes = 0;         // every shared table in the process, paid once
+        int numSharedResources = 0;
+    };
+
+    //==============================================================================
+    /*  Immutable tables computed once per key and shared by every instance loaded from
+        the same binary.
+
+        get() returns the table for a key, calling make() only if no instance holds one.
+        Handles are ref-counted pointers to const: the table is freed when the last user
+        lets go, and since nothing writes to it after make() returns, the audio thread
+        reads it without locking. get() itself locks and may build, so call it from a
+        constructor or prepareToPlay, never from the audio thread.
+
+        Resource needs a getSizeInBytes() for the memory report.
+    */
+    template <typename Key, typename Resource>
+    class SharedCache
+    {
+    public:
+        using Handle = std::shared_ptr<const Resource>;
+
+        template <typename Make>
+        static Handle get (const Key& key, Make&& make)
+        {
+            auto& cache = getInstance();
+            const ScopedLock lock (cache.lock);
+
+            if (auto existing = cache.entries[key].lock())
+                return existing;
+
+            // forget keys nobody uses any more, e.g. a sample rate the session left
+            for (auto entry = cache.entries.begin(); entry != cache.entries.end();)
+                entry = entry->second.expired() ? cache.entries.erase (entry) : std::next (entry);
+
+            auto* resource = new Resource (make());
+            const auto bytes = resource->getSizeInBytes();
+            SharedMemory::added (bytes);
+
+            Handle handle (resource, [bytes] (const Resource* r)
+            {
+                SharedMemory::removed (bytes);
+                delete r;
+            });
+
+            cache.entries[key] = handle;
+            return handle;
+        }
+
+    private:
+        static SharedCache& getInstance()
+        {
+            static SharedCache cache;
+            return cache;
+        }
+
+        CriticalSection lock;
+        std::map<Key, std::weak_ptr<const Resource>> entries;
+    };
+}
@@ -0,0 +1,504 @@
+#include <JuceHeader.h>
+
+// The Linux exporter defines JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP, so the standalone there is
+// this app instead of JUCE's; everywhere else this file compiles to nothing.
+#if JucePlugin_Build_Standalone && JUCE_USE_CUSTOM_PLUGIN_STANDALONE_APP
+
+#include "PluginProcessor.h"
+#include "CallbackMonitor.h"
+#include "Realtime.h"
+
+#if JUCE_LINUX
+ #include <csignal>
+#endif
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+//==============================================================================
+/*  The standalone for an insert on a Linux box: the processor on an ALSA or JACK device
+    at periods down to 32 samples, with its memory locked and its callback real-time, and
+    every callback timed.
+
+        Inflation [--headless [--seconds=<n>]] [--list]
+                  [--type=<ALSA|JACK>] [--device=<name> | --input=<name> --output=<name>]
+                  [--rate=<Hz>] [--period=<samples>] [--priority=<1-99>] [--no-realtime]
+
+    With a window, the strip under the editor shows the device, whether the callback got
+    SCHED_FIFO and the memory got locked, the driver's xruns, the callbacks that came
+    late and the callback time percentiles; the device and the settings are kept from one
+    run to the next. --headless plays the kept settings without a window, prints the same
+    every ten seconds and a summary when it stops (Ctrl+C, or after --seconds, when it
+    exits with 1 if there was an xrun or a late callback). The options override the kept
+    device for that run only. --list prints the device names the options take.
+*/
+namespace {
+
+    struct Options
+    {
+        String type, input, output;
+        double sampleRate = 0.0;            // 0 keeps what the device had
+        int period = 0;
+        int priority = 80;
+        bool realtime = true, headless = false, list = false;
+        double seconds = 0.0;               // 0 runs until stopped
+
+        static Options fromArguments (const ArgumentList& args)
+        {
+            Options options;
+            const auto value = [&] (const char* option) { return args.getValueForOption (option); };
+
+            options.type = value ("--type");
+            options.input = options.output = value ("--device");
+
+            if (args.containsOption ("--input"))    options.input = value ("--input");
+            if (args.containsOption ("--output"))   options.output = value ("--output");
+            if (args.containsOption ("--rate"))     options.sampleRate = value ("--rate").getDoubleValue();
+            if (args.containsOption ("--period"))   options.period = value ("--period").getIntValue();
+            if (args.containsOption ("--priority")) options.priority = jlimit (1, 99, value ("--priority").getIntValue());
+            if (args.containsOption ("--seconds"))  options.seconds = value ("--seconds").getDoubleValue();
+
+            options.realtime = ! args.containsOption ("--no-realtime");
+            options.headless = args.containsOption ("--headless");
+            options.list = args.containsOption ("--list");
+            return options;
+        }
+    };
+
+    std::atomic<bool> stopRequested { false };
+
+    //==============================================================================
+    /** The processor's player, timed. The first callback after each start is left out of
+        the times: it moves its thread to SCHED_FIFO and faults the stack in first. */
+    class MonitoredPlayer : public AudioIODeviceCallback
+    {
+    public:
+        static constexpr int notTried = -1;
+
+        MonitoredPlayer (bool shouldPromote, int priorityToUse)
+            : promote (shouldPromote), priority (priorityToUse)
+        {
+        }
+
+        void audioDeviceIOCallbackWithContext (const float* const* inputs, int numInputs, float* const* outputs, int numOutputs,
+                                               int numSamples, const AudioIODeviceCallbackContext& context) override
+        {
+            // once per start, as a restarted device can call from another thread
+            if (threadPending.exchange (false, std::memory_order_relaxed))
+            {
+                Dsp::Realtime::prefaultStack();
+                threadError.store (promote ? Dsp::Realtime::promoteCurrentThread (priority) : notTried, std::memory_order_relaxed);
+                threadPriority.store (Dsp::Realtime::getCurrentPriority(), std::memory_order_relaxed);
+                player.audioDeviceIOCallbackWithContext (inputs, numInputs, outputs, numOutputs, numSamples, context);
+                return;
+            }
+
+            const Dsp::CallbackMonitor::ScopedCallback timed (monitor, numSamples);
+            player.audioDeviceIOCallbackWithContext (inputs, numInputs, outputs, numOutputs, numSamples, context);
+        }
+
+        void audioDeviceAboutToStart (AudioIODevice* device) override
+        {
+            player.audioDeviceAboutToStart (device);
+            monitor.prepare (device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples());
+            xrunsAtReset = device->getXRunCount();
+            threadPending.store (true, std::memory_order_relaxed);
+        }
+
+        void audioDeviceStopped() override                      { player.audioDeviceStopped(); }
+        void audioDeviceError (const String& message) override  { player.audioDeviceError (message); }
+
+        AudioProcessorPlayer player;
+        Dsp::CallbackMonitor monitor;
+        std::atomic<int> threadError { notTried }, threadPriority { 0 };
+        int xrunsAtReset = 0;                   // the driver's count, which only starts over with the device
+
+    private:
+        const bool promote;
+        const int priority;
+        std::atomic<bool> threadPending { false };
+    };
+
+    //==============================================================================
+    /** The settings, the device and the processor playing on it. */
+    class Session
+    {
+    public:
+        Session (const Options& optionsToUse)
+            : options (optionsToUse),
+              callback (options.realtime, options.priority)
+        {
+            // before anything big is allocated, though everything after is locked as it comes
+            if (options.realtime)
+                memoryResult = Dsp::Realtime::lockMemory();
+
+            PropertiesFile::Options storage;
+            storage.applicationName = JucePlugin_Name;
+            storage.filenameSuffix = ".settings";
+            storage.folderName = "~/.config";
+            settings.setStorageParameters (storage);
+
+            PluginHostType::jucePlugInClientCurrentWrapperType = AudioProcessor::wrapperType_Standalone;
+            processor.reset (createPluginFilter());
+
+            MemoryBlock state;
+
+            if (state.fromBase64Encoding (getSettings().getValue ("filterState")) && state.getSize() > 0)
+                processor->setStateInformation (state.getData(), (int) state.getSize());
+        }
+
+        ~Session()
+        {
+            deviceManager.removeAudioCallback (&callback);
+            callback.player.setProcessor (nullptr);
+            deviceManager.closeAudioDevice();
+        }
+
+        /** Opens the kept device, or the default one at 48 kHz and 64 samples, then applies
+            the options. Returns an error, or an empty string. */
+        String start()
+        {
+            AudioDeviceManager::AudioDeviceSetup preferred;
+            preferred.sampleRate = 48000.0;
+            preferred.bufferSize = 64;
+
+            const auto kept = getSettings().getXmlValue ("audioSetup");
+            auto error = deviceManager.initialise (processor->getMainBusNumInputChannels(), processor->getMainBusNumOutputChannels(),
+                                                   kept.get(), true, {}, &preferred);
+
+            if (options.type.isNotEmpty())
+                deviceManager.setCurrentAudioDeviceType (options.type, true);
+
+            auto setup = deviceManager.getAudioDeviceSetup();
+
+            if (options.input.isNotEmpty())     setup.inputDeviceName = options.input;
+            if (options.output.isNotEmpty())    setup.outputDeviceName = options.output;
+            if (options.sampleRate > 0.0)       setup.sampleRate = options.sampleRate;
+            if (options.period > 0)             setup.bufferSize = options.period;
+
+            if (options.type.isNotEmpty() || options.input.isNotEmpty() || options.output.isNotEmpty()
+                 || options.sampleRate > 0.0 || options.period > 0)
+                error = deviceManager.setAudioDeviceSetup (setup, true);
+
+            callback.player.setProcessor (processor.get());
+            deviceManager.addAudioCallback (&callback);
+            return error;
+        }
+
+        /** Keeps the device and the processor's state for the next run. */
+        void save()
+        {
+            if (const auto audioSetup = deviceManager.createStateXml())
+                getSettings().setValue ("audioSetup", audioSetup.get());
+
+            MemoryBlock state;
+            processor->getStateInformation (state);
+            getSettings().setValue ("filterState", state.toBase64Encoding());
+            getSettings().saveIfNeeded();
+        }
+
+        void resetCounts()
+        {
+            callback.monitor.reset();
+
+            if (auto* device = deviceManager.getCurrentAudioDevice())
+                callback.xrunsAtReset = device->getXRunCount();
+        }
+
+        //==============================================================================
+        /** The device, its latency, and what it got of the real-time setup. */
+        String describeDevice()
+        {
+            auto* device = deviceManager.getCurrentAudioDevice();
+
+            if (device == nullptr)
+                return "no audio device";
+
+            const auto sampleRate = device->getCurrentSampleRate();
+            const auto period = device->getCurrentBufferSizeSamples();
+            const auto roundTrip = period + device->getInputLatencyInSamples() + device->getOutputLatencyInSamples();
+
+            String text;
+            text << device->getTypeName() << ' ' << device->getName() << ", " << roundToInt (sampleRate) << " Hz, "
+                 << period << " samples (" << String (period * 1000.0 / sampleRate, 2) << " ms, round trip "
+                 << String (roundTrip * 1000.0 / sampleRate, 1) << " ms)";
+
+            const auto priority = callback.threadPriority.load (std::memory_order_relaxed);
+            const auto error = callback.threadError.load (std::memory_order_relaxed);
+
+            text << ", " << (priority > 0 ? "real-time " + String (priority)
+                                          : error > 0 ? Dsp::Realtime::describeError (error) : String ("not real-time"));
+
+            text << ", " << (memoryResult.wasOk() ? "memory locked" : memoryResult.getErrorMessage());
+            return text;
+        }
+
+        /** xruns, late callbacks and the callback time percentiles since the last reset. */
+        String describeCallbacks()
+        {
+            const auto snapshot = callback.monitor.getSnapshot();
+            auto* device = deviceManager.getCurrentAudioDevice();
+            const auto deviceXRuns = device != nullptr ? device->getXRunCount() : -1;
+
+            String text;
+            text << "xruns " << (deviceXRuns >= 0 ? String (deviceXRuns - callback.xrunsAtReset) : String ("n/a"))
+                 << ", late " << (int64) snapshot.late << ", over budget " << (int64) snapshot.overBudget
+                 << " of " << (int64) snapshot.callbacks << " callbacks; " << Dsp::CallbackMonitor::describeTimes (snapshot);
+            return text;
+        }
+
+        /** Whether anything went missing since the last reset. */
+        bool hadDropouts()
+        {
+            auto* device = deviceManager.getCurrentAudioDevice();
+            const auto deviceXRuns = device != nullptr ? device->getXRunCount() : -1;
+            return callback.monitor.getSnapshot().late > 0 || (deviceXRuns >= 0 && deviceXRuns > callback.xrunsAtReset);
+        }
+
+        PropertiesFile& getSettings()           { return *settings.getUserSettings(); }
+
+        const Options options;
+        ApplicationProperties settings;
+        AudioDeviceManager deviceManager;
+        std::unique_ptr<AudioProcessor> processor;
+        MonitoredPlayer callback;
+        Result memoryResult = Result::fail ("memory not locked, --no-realtime");
+    };
+
+    //==============================================================================
+    /** Two lines of device and callback numbers under the editor, with the device
+        settings and a reset of the counts on the right. */
+    class StatusBar : public Component,
+                      private Timer
+    {
+    public:
+        static constexpr int height = 40;
+
+        explicit StatusBar (Session& sessionToShow)
+            : session (sessionToShow)
+        {
+            addAndMakeVisible (settingsButton);
+            addAndMakeVisible (resetButton);
+            settingsButton.onClick = [this] { showSettings(); };
+            resetButton.onClick = [this] { session.resetCounts(); };
+            startTimerHz (4);
+        }
+
+        void paint (Graphics& g) override
+        {
+            auto bounds = getLocalBounds().withTrimmedRight (buttonsWidth).reduced (10, 2);
+            g.fillAll (Colours::whitesmoke.darker (0.05f));
+            g.setColour (Colours::black);
+            g.setFont (Font (Font::getDefaultMonospacedFontName(), 11.0f, Font::plain));
+            g.drawText (deviceText, bounds.removeFromTop (bounds.getHeight() / 2), Justification::centredLeft, true);
+            g.drawText (callbackText, bounds, Justification::centredLeft, true);
+        }
+
+        void resized() override
+        {
+            auto buttons = getLocalBounds().removeFromRight (buttonsWidth).reduced (5, 8);
+            resetButton.setBounds (buttons.removeFromRight (50));
+            settingsButton.setBounds (buttons.withTrimmedRight (5));
+        }
+
+    private:
+        static constexpr int buttonsWidth = 130;
+
+        void timerCallback() override
+        {
+            auto device = session.describeDevice(), callbacks = session.describeCallbacks();
+
+            if (device != deviceText || callbacks != callbackText)
+            {
+                deviceText = std::move (device);
+                callbackText = std::move (callbacks);
+                repaint();
+            }
+        }
+
+        void showSettings()
+        {
+            DialogWindow::LaunchOptions dialog;
+            dialog.content.setOwned (new AudioDeviceSelectorComponent (session.deviceManager, 0, 256, 0, 256, false, false, true, false));
+            dialog.content->setSize (500, 450);
+            dialog.dialogTitle = "Audio Settings";
+            dialog.dialogBackgroundColour = Colours::whitesmoke;
+            dialog.escapeKeyTriggersCloseButton = true;
+            dialog.useNativeTitleBar = true;
+            dialog.resizable = false;
+            dialog.launchAsync();
+        }
+
+        Session& session;
+        String deviceText, callbackText;
+        TextButton settingsButton { "Audio..." }, resetButton { "Reset" };
+    };
+
+    //==============================================================================
+    class MainWindow : public DocumentWindow
+    {
+    public:
+        explicit MainWindow (Session& session)
+            : DocumentWindow (JucePlugin_Name, Colours::whitesmoke, DocumentWindow::minimiseButton | DocumentWindow::closeButton)
+        {
+            setUsingNativeTitleBar (true);
+            setContentOwned (new Content (session), true);
+            centreWithSize (getWidth(), getHeight());
+            setVisible (true);
+        }
+
+        void closeButtonPressed() override
+        {
+            JUCEApplication::getInstance()->systemRequestedQuit();
+        }
+
+    private:
+        // the editor on top of the status bar, sized to the editor
+        class Content : public Component
+        {
+        public:
+            explicit Content (Session& session)
+                : editor (session.processor->createEditorIfNeeded()),
+                  statusBar (session)
+            {
+                addAndMakeVisible (*editor);
+                addAndMakeVisible (statusBar);
+                childBoundsChanged (editor.get());
+            }
+
+            void resized() override
+            {
+                auto bounds = getLocalBounds();
+                statusBar.setBounds (bounds.removeFromBottom (StatusBar::height));
+                editor->setBounds (bounds);
+            }
+
+            void childBoundsChanged (Component* child) override
+            {
+                if (child == editor.get())
+                    setSize (editor->getWidth(), editor->getHeight() + StatusBar::height);
+            }
+
+        private:
+            std::unique_ptr<AudioProcessorEditor> editor;
+            StatusBar statusBar;
+        };
+    };
+}
+
+//==============================================================================
+class InflationStandaloneApp : public JUCEApplication,
+                               private Timer
+{
+public:
+    const String getApplicationName() override       { return JucePlugin_Name; }
+    const String getApplicationVersion() override    { return JucePlugin_VersionString; }
+    bool moreThanOneInstanceAllowed() override       { return true; }
+
+    void initialise (const String&) override
+    {
+        const auto options = Options::fromArguments (ArgumentList (getApplicationName(), getCommandLineParameterArray()));
+        session = std::make_unique<Session> (options);
+
+        if (options.list)
+        {
+            listDevices();
+            quit();
+            return;
+        }
+
+        const auto error = session->start();
+
+        if (! options.headless)
+        {
+            window = std::make_unique<MainWindow> (*session);
+
+            if (error.isNotEmpty())
+                AlertWindow::showMessageBoxAsync (MessageBoxIconType::WarningIcon, "Audio device", error);
+
+            return;
+        }
+
+        if (error.isNotEmpty())
+            std::cout << error << std::endl;
+
+       #if JUCE_LINUX
+        for (auto signal : { SIGINT, SIGTERM })
+            std::signal (signal, [] (int) { stopRequested = true; });
+       #endif
+
+        startedAt = lastReportAt = Time::getMillisecondCounterHiRes() * 0.001;
+        startTimer (100);
+    }
+
+    void shutdown() override
+    {
+        stopTimer();
+        window = nullptr;
+
+        // a headless run plays the kept settings with the options on top, it doesn't keep them
+        if (session != nullptr && ! session->options.headless && ! session->options.list)
+            session->save();
+
+        session = nullptr;
+    }
+
+    void systemRequestedQuit() override     { quit(); }
+    void anotherInstanceStarted (const String&) override {}
+
+private:
+    static constexpr double reportSeconds = 10.0;
+
+    // headless: the counts every ten seconds, and a summary at the end; the device line waits
+    // for the first report, by when the callback has tried for real-time
+    void timerCallback() override
+    {
+        const auto now = Time::getMillisecondCounterHiRes() * 0.001;
+        const auto& options = session->options;
+        const auto finished = stopRequested.load() || (options.seconds > 0.0 && now - startedAt >= options.seconds);
+
+        if (now - lastReportAt >= reportSeconds || finished)
+        {
+            if (! std::exchange (deviceShown, true) || finished)
+                std::cout << session->describeDevice() << std::endl;
+
+            lastReportAt = now;
+            std::cout << String (now - startedAt, 0) << " s: " << session->describeCallbacks() << std::endl;
+        }
+
+        if (finished)
+        {
+            stopTimer();
+
+            if (options.seconds > 0.0 && session->hadDropouts())
+                setApplicationReturnValue (1);
+
+            quit();
+        }
+    }
+
+    void listDevices()
+    {
+        for (auto* type : session->deviceManager.getAvailableDeviceTypes())
+        {
+            type->scanForDevices();
+            std::cout << type->getTypeName() << std::endl;
+
+            for (auto isInput : { true, false })
+                for (const auto& name : type->getDeviceNames (isInput))
+                    std::cout << (isInput ? "  --input=\"" : "  --output=\"") << name << '"' << std::endl;
+        }
+    }
+
+    std::unique_ptr<Session> session;
+    std::unique_ptr<MainWindow> window;
+    double startedAt = 0.0, lastReportAt = 0.0;
+    bool deviceShown = false;
+};
+
+// what JUCE's standalone wrapper starts instead of its own app
+juce::JUCEApplicationBase* juce_CreateApplication()
+{
+    return new InflationStandaloneApp();
+}
+
+#endif
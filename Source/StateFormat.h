@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  The plug-in's state as the host stores it: a short binary record instead of the
+        parameter tree as XML, 13 bytes plus 4 per parameter (133 with the 30 there are)
+        where the XML took several hundred, and read without parsing anything.
+
+            uint32  magic ("INFL")
+            uint16  version
+            uint8   number of values
+            float   each parameter's value in its own units, in parameterIds order
+            int16   editor width, editor height
+            int16   current program
+
+        All little endian. Growing the record only ever appends: new parameters to the
+        values and new fields at the end, so every build reads what it knows of any other's,
+        and that doesn't change the version. The version only goes up for a layout an older
+        build couldn't read that way, which read() then rejects rather than misreading.
+    */
+    struct StateFormat
+    {
+        static constexpr int magic = 0x4c464e49;
+        static constexpr int version = 1;
+
+        struct State
+        {
+            RawParameterValues values {};
+            int numValues = 0;              // read from the data, the rest keep their defaults
+            int width = 600, height = 700;
+            int program = 0;
+        };
+
+        static void write (const State& state, MemoryBlock& destData)
+        {
+            MemoryOutputStream stream (destData, false);
+            stream.writeInt (magic);
+            stream.writeShort ((short) version);
+            stream.writeByte ((char) numParameters);
+
+            for (auto value : state.values)
+                stream.writeFloat (value);
+
+            stream.writeShort ((short) state.width);
+            stream.writeShort ((short) state.height);
+            stream.writeShort ((short) state.program);
+        }
+
+        /** False when the data isn't in this format, e.g. XML from an older version, or comes
+            from a later version with a different layout. */
+        static bool read (const void* data, int sizeInBytes, State& state)
+        {
+            constexpr int headerSize = 4 + 2 + 1;
+
+            if (data == nullptr || sizeInBytes < headerSize)
+                return false;
+
+            MemoryInputStream stream (data, (size_t) sizeInBytes, false);
+
+            if (stream.readInt() != magic)
+                return false;
+
+            if (stream.readShort() > version)
+                return false;
+
+            const auto numStored = (int) (uint8) stream.readByte();
+
+            if (stream.getNumBytesRemaining() < numStored * 4)
+                return false;
+
+            for (auto i = 0; i < numStored; ++i)
+            {
+                const auto value = stream.readFloat();
+
+                if (i < numParameters)
+                    state.values[(size_t) i] = value;
+            }
+
+            state.numValues = jmin (numStored, numParameters);
+
+            if (stream.getNumBytesRemaining() >= 6)
+            {
+                state.width = stream.readShort();
+                state.height = stream.readShort();
+                state.program = stream.readShort();
+            }
+
+            return true;
+        }
+    };
+}
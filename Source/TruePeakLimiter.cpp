@@ -0,0 +1,300 @@
+#include "TruePeakLimiter.h"
+#include <numeric>
+
+namespace Dsp {
+
+namespace {
+
+    constexpr int numTaps = 16;
+    constexpr int numBetween = 3;
+
+    //==============================================================================
+    // Each body runs over [begin, end) with a given Vec, so the same code handles the
+    // vectorised part of a block and the scalar tail.
+
+    // folds |x| at the sample and at the three phases between it and the next into peak;
+    // all three phases share the history loads
+    template <typename Vec, typename FloatType>
+    inline void foldPeaks (int begin, int end, const FloatType* history, const FloatType* taps,
+                           FloatType* peak) noexcept
+    {
+        const auto* centre = history + numTaps / 2 - 1;
+
+        for (auto i = begin; i + Vec::size <= end; i += Vec::size)
+        {
+            auto first = Vec::broadcast (0), second = Vec::broadcast (0), third = Vec::broadcast (0);
+
+            for (auto t = 0; t < numTaps; ++t)
+            {
+                const auto x = Vec::load (history + i + t);
+                first  = Vec::mulAdd (x, Vec::broadcast (taps[t]), first);
+                second = Vec::mulAdd (x, Vec::broadcast (taps[numTaps + t]), second);
+                third  = Vec::mulAdd (x, Vec::broadcast (taps[2 * numTaps + t]), third);
+            }
+
+            const auto between = Vec::max (Vec::abs (first), Vec::max (Vec::abs (second), Vec::abs (third)));
+            const auto sample = Vec::max (Vec::abs (Vec::load (centre + i)), Vec::load (peak + i));
+            Vec::store (peak + i, Vec::max (sample, between));
+        }
+    }
+
+    template <typename Vec, typename FloatType>
+    inline void detectPeaks (const FloatType* history, const FloatType* taps, FloatType* peak, int numSamples) noexcept
+    {
+        const auto vectorEnd = numSamples / Vec::size * Vec::size;
+
+        foldPeaks<Vec> (0, vectorEnd, history, taps, peak);
+        foldPeaks<ScalarVec<FloatType>> (vectorEnd, numSamples, history, taps, peak);
+    }
+
+    template <typename Vec, typename FloatType>
+    inline void scaleAndMeasure (int begin, int end, const FloatType* line, const FloatType* gain,
+                                 FloatType* output, ChannelLevels<FloatType>& levels) noexcept
+    {
+        LaneLevels<Vec, FloatType> lanes;
+
+        for (auto i = begin; i + Vec::size <= end; i += Vec::size)
+        {
+            const auto y = Vec::mul (Vec::load (line + i), Vec::load (gain + i));
+            Vec::store (output + i, y);
+            lanes.add (y);
+        }
+
+        lanes.addTo (levels);
+    }
+
+    template <typename Vec, typename FloatType>
+    inline void applyGain (const FloatType* line, const FloatType* gain, FloatType* output, int numSamples,
+                           ChannelLevels<FloatType>& levels) noexcept
+    {
+        const auto vectorEnd = numSamples / Vec::size * Vec::size;
+
+        scaleAndMeasure<Vec> (0, vectorEnd, line, gain, output, levels);
+        scaleAndMeasure<ScalarVec<FloatType>> (vectorEnd, numSamples, line, gain, output, levels);
+    }
+
+    //==============================================================================
+    template <typename FloatType>
+    using DetectFunction = void (*) (const FloatType*, const FloatType*, FloatType*, int) noexcept;
+
+    template <typename FloatType>
+    using ApplyFunction = void (*) (const FloatType*, const FloatType*, FloatType*, int, ChannelLevels<FloatType>&) noexcept;
+
+    // See Pipeline.cpp: SSE2 and scalar need no attributes, AVX entry points are targeted and flattened.
+    #define INFLATION_LIMITER_ENTRIES(Name, attributes) \
+        template <typename Vec> \
+        struct Name \
+        { \
+            template <typename FloatType> \
+            attributes static void detect (const FloatType* history, const FloatType* taps, FloatType* peak, int numSamples) noexcept \
+            { detectPeaks<Vec> (history, taps, peak, numSamples); } \
+            \
+            template <typename FloatType> \
+            attributes static void apply (const FloatType* line, const FloatType* gain, FloatType* output, int numSamples, \
+                                          ChannelLevels<FloatType>& levels) noexcept \
+            { applyGain<Vec> (line, gain, output, numSamples, levels); } \
+        };
+
+    INFLATION_LIMITER_ENTRIES (PortableEntries, )
+
+   #if JUCE_INTEL
+    INFLATION_LIMITER_ENTRIES (Avx2Entries, INFLATION_KERNEL ("avx2,fma"))
+    INFLATION_LIMITER_ENTRIES (Avx512Entries, INFLATION_KERNEL ("avx512f"))
+   #endif
+
+    #undef INFLATION_LIMITER_ENTRIES
+
+    //==============================================================================
+    template <typename FloatType>
+    struct Table
+    {
+        DetectFunction<FloatType> detect;
+        ApplyFunction<FloatType> apply;
+    };
+
+    template <typename Entries, typename FloatType>
+    Table<FloatType> makeTable() noexcept
+    {
+        Table<FloatType> table;
+        table.detect = Entries::template detect<FloatType>;
+        table.apply = Entries::template apply<FloatType>;
+        return table;
+    }
+
+    template <typename FloatVec, typename DoubleVec, template <typename> class Entries>
+    struct TablesFor
+    {
+        static Table<float> floats() noexcept    { return makeTable<Entries<FloatVec>, float>(); }
+        static Table<double> doubles() noexcept  { return makeTable<Entries<DoubleVec>, double>(); }
+    };
+
+    struct Kernels
+    {
+        Table<float> floats;
+        Table<double> doubles;
+
+        const Table<float>& get (float) const noexcept    { return floats; }
+        const Table<double>& get (double) const noexcept  { return doubles; }
+    };
+
+    template <typename Tables>
+    Kernels makeKernels() noexcept
+    {
+        return { Tables::floats(), Tables::doubles() };
+    }
+
+    Kernels selectKernels (Isa isa) noexcept
+    {
+        switch (isa)
+        {
+           #if JUCE_INTEL
+            case Isa::avx512:   return makeKernels<TablesFor<Avx512Float, Avx512Double, Avx512Entries>>();
+            case Isa::avx2:     return makeKernels<TablesFor<Avx2Float, Avx2Double, Avx2Entries>>();
+            case Isa::sse2:     return makeKernels<TablesFor<Sse2Float, Sse2Double, PortableEntries>>();
+           #endif
+
+            case Isa::scalar:
+            default:            return makeKernels<TablesFor<ScalarVec<float>, ScalarVec<double>, PortableEntries>>();
+        }
+    }
+
+    // picked while the library loads, so the audio thread never takes a static's guard for it
+    const Kernels kernels = selectKernels (detectIsa());
+
+    template <typename FloatType>
+    const Table<FloatType>& getTable() noexcept
+    {
+        return kernels.get (FloatType());
+    }
+}
+
+//==============================================================================
+template <typename FloatType>
+void TruePeakLimiter<FloatType>::process (FloatType* const* channels, int numChannelsToProcess, int numSamples,
+                                          ChannelLevels<FloatType>* levels) noexcept
+{
+    static_assert (tapsPerPhase == numTaps && numPhases - 1 == numBetween, "the kernels are unrolled for this interpolator");
+    jassert (numChannelsToProcess <= numChannels && numSamples <= maxSamples);
+
+    const auto& table = getTable<FloatType>();
+    const auto* taps = interpolator->phases.front().data();
+    auto* peak = peaks.data();
+    std::fill (peak, peak + numSamples, FloatType (0));
+
+    // append each block to its delay line, whose newest part is the interpolator's history
+    for (auto channel = 0; channel < numChannelsToProcess; ++channel)
+    {
+        auto* line = lines[(size_t) channel].data();
+        std::copy (channels[channel], channels[channel] + numSamples, line + latency);
+        table.detect (line + latency - (tapsPerPhase - 1), taps, peak, numSamples);
+    }
+
+    computeGains (numSamples);
+
+    for (auto channel = 0; channel < numChannelsToProcess; ++channel)
+    {
+        auto* line = lines[(size_t) channel].data();
+        table.apply (line, gains.data(), channels[channel], numSamples, levels[channel]);
+        std::copy (line + numSamples, line + numSamples + latency, line);
+    }
+}
+
+// folds the peaks into chunks, and ramps each sample between the last two chunk gains
+template <typename FloatType>
+void TruePeakLimiter<FloatType>::computeGains (int numSamples) noexcept
+{
+    const auto* peak = peaks.data();
+    auto* gain = gains.data();
+
+    // locals, so the stores into gain can't alias them
+    auto position = chunkPosition;
+    auto maximum = chunkPeak;
+
+    for (auto i = 0; i < numSamples;)
+    {
+        const auto length = jmin (chunkSize - position, numSamples - i);
+        const auto from = chunkGains[0];
+        const auto step = (chunkGains[1] - from) / FloatType (chunkSize);
+
+        for (auto k = 0; k < length; ++k)
+        {
+            maximum = jmax (maximum, peak[i + k]);
+            gain[i + k] = from + step * static_cast<FloatType> (position + k + 1);
+        }
+
+        i += length;
+        position += length;
+
+        if (position == chunkSize)
+        {
+            chunkGains = { chunkGains[1], getChunkGain (maximum) };
+            maximum = 0;
+            position = 0;
+        }
+    }
+
+    chunkPosition = position;
+    chunkPeak = maximum;
+}
+
+// gain needed → sliding minimum over holdLength → release → moving average over averageLength
+template <typename FloatType>
+FloatType TruePeakLimiter<FloatType>::getChunkGain (FloatType peak) noexcept
+{
+    auto* values = minimumValues.data();
+    auto* times = minimumTimes.data();
+    const auto needed = peak > ceiling ? ceiling / peak : FloatType (1);
+
+    // drop the value leaving the window, then anything at least as large as the
+    // newest value, which can never be the minimum again
+    if (minimumSize > 0 && times[minimumFront] <= chunk - holdLength)
+    {
+        minimumFront = minimumFront + 1 == holdLength ? 0 : minimumFront + 1;
+        --minimumSize;
+    }
+
+    for (; minimumSize > 0; --minimumSize)
+    {
+        const auto last = (minimumBack == 0 ? holdLength : minimumBack) - 1;
+
+        if (values[last] < needed)
+            break;
+
+        minimumBack = last;
+    }
+
+    values[minimumBack] = needed;
+    times[minimumBack] = chunk++;
+    minimumBack = minimumBack + 1 == holdLength ? 0 : minimumBack + 1;
+    ++minimumSize;
+
+    const auto held = values[minimumFront];
+    envelope = held < envelope ? held : envelope + (held - envelope) * release;
+
+    auto* average = averageLine.data();
+    averageSum += static_cast<double> (envelope - average[averagePosition]);
+    average[averagePosition] = envelope;
+
+    // start the running sum over once per window so rounding can't build up
+    if (++averagePosition == averageLength)
+    {
+        averagePosition = 0;
+        averageSum = std::accumulate (average, average + averageLength, 0.0);
+    }
+
+    return static_cast<FloatType> (averageSum / averageLength);
+}
+
+//==============================================================================
+template <typename FloatType>
+void TruePeakDetector<FloatType>::detect (const FloatType* samples, FloatType* peaks, int numSamples) const noexcept
+{
+    getTable<FloatType>().detect (samples, interpolator->phases.front().data(), peaks, numSamples);
+}
+
+template class TruePeakLimiter<float>;
+template class TruePeakLimiter<double>;
+template class TruePeakDetector<float>;
+template class TruePeakDetector<double>;
+
+}
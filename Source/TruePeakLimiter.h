@@ -0,0 +1,196 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Oversampler.h"
+#include "Pipeline.h"
+#include "ScratchArena.h"
+#include "SharedResources.h"
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  Lookahead limiter on the true peak, the last stage of the chain.
+
+        The sidechain is the signal upsampled 4x by a polyphase FIR so the peaks between
+        samples are seen; only the three in-between phases are computed, the fourth is
+        the sample itself. The gain computer runs once per chunk of 8 samples on the
+        chunk's peak: the gain it needs is held across the lookahead by a sliding
+        minimum (a monotonic deque, O(1) amortised), released by a one pole and averaged
+        over the lookahead again. Each sample then gets a straight line between the last
+        two chunk gains. Holding one chunk longer than the average keeps both ends of that
+        line, and so every sample, at or below what its peak needs. The per-sample work,
+        detection and applying the gain, runs in the same ISA dispatched kernels as the
+        rest of the chain.
+
+        The gain is shared by all channels, so the image doesn't move. The audio is
+        delayed by the lookahead plus the interpolator's own delay, which is the latency
+        the limiter adds.
+    */
+    template <typename FloatType>
+    class TruePeakLimiter
+    {
+    public:
+        static constexpr int numPhases = 4;
+        static constexpr int tapsPerPhase = 16;
+        static constexpr int chunkSize = 8;
+        static constexpr double lookaheadSeconds = 0.0015;
+        static constexpr double releaseSeconds = 0.1;
+
+        //==============================================================================
+        /** The in-between phases of the 4x interpolator, taps reversed so they run along
+            the history. They don't depend on the sample rate, so every instance shares one set. */
+        struct Interpolator
+        {
+            std::array<std::array<FloatType, tapsPerPhase>, numPhases - 1> phases {};
+
+            static Interpolator design()
+            {
+                Interpolator interpolator;
+                const auto centre = numPhases * tapsPerPhase / 2;
+
+                for (auto phase = 1; phase < numPhases; ++phase)
+                {
+                    auto& taps = interpolator.phases[(size_t) phase - 1];
+                    auto sum = 0.0;
+
+                    for (auto k = 0; k < tapsPerPhase; ++k)
+                    {
+                        // Kaiser windowed sinc with its zeros on the input samples; a
+                        // flat top to 20 kHz matters more than a deep stop band here
+                        const auto j = phase + numPhases * k;
+                        const auto x = MathConstants<double>::pi * (j - centre) / numPhases;
+                        const auto tap = std::sin (x) / x * HalfBand::kaiser ((double) (j - centre) / centre, 5.0);
+
+                        taps[(size_t) (tapsPerPhase - 1 - k)] = static_cast<FloatType> (tap);
+                        sum += tap;
+                    }
+
+                    // each phase passes DC at unity
+                    for (auto& tap : taps)
+                        tap = static_cast<FloatType> (tap / sum);
+                }
+
+                return interpolator;
+            }
+
+            size_t getSizeInBytes() const noexcept  { return sizeof (Interpolator); }
+        };
+
+        TruePeakLimiter()
+            : interpolator (SharedCache<int, Interpolator>::get (tapsPerPhase, &Interpolator::design))
+        {
+        }
+
+        //==============================================================================
+        /** Takes the delay lines and the gain computer's buffers. Call from the arena's layout function. */
+        void prepare (ScratchArena& arena, int numChannelsToUse, int maxBlockSize, double sampleRate)
+        {
+            jassert (numChannelsToUse <= maxChannels);
+
+            numChannels = jmin (numChannelsToUse, maxChannels);
+            maxSamples = maxBlockSize;
+
+            const auto lookaheadChunks = jmax (1, roundToInt (sampleRate * lookaheadSeconds / chunkSize));
+            averageLength = lookaheadChunks + 1;
+            holdLength = lookaheadChunks + 2;
+            latency = (lookaheadChunks + 2) * chunkSize + tapsPerPhase / 2;
+            release = static_cast<FloatType> (1.0 - std::exp (-chunkSize / (releaseSeconds * sampleRate)));
+
+            for (auto channel = 0; channel < numChannels; ++channel)
+                lines[(size_t) channel] = arena.take<FloatType> (latency + maxBlockSize);
+
+            const auto active = numChannels > 0;
+
+            peaks = arena.take<FloatType> (active ? maxBlockSize : 0);
+            gains = arena.take<FloatType> (active ? maxBlockSize : 0);
+            minimumValues = arena.take<FloatType> (active ? holdLength : 0);
+            minimumTimes = arena.take<int64> (active ? holdLength : 0);
+            averageLine = arena.take<FloatType> (active ? averageLength : 0);
+
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            for (auto channel = 0; channel < numChannels; ++channel)
+                lines[(size_t) channel].clear();
+
+            std::fill (averageLine.begin(), averageLine.end(), FloatType (1));
+            averageSum = static_cast<double> (averageLine.size());
+            averagePosition = 0;
+            minimumFront = minimumBack = minimumSize = 0;
+            envelope = 1;
+            chunk = 0;
+            chunkPosition = 0;
+            chunkPeak = 0;
+            chunkGains = { FloatType (1), FloatType (1) };
+        }
+
+        void setCeiling (double decibels) noexcept
+        {
+            if (decibels != ceilingDecibels)
+            {
+                ceilingDecibels = decibels;
+                ceiling = static_cast<FloatType> (Decibels::decibelsToGain (decibels));
+            }
+        }
+
+        /** Whole samples between input and output. */
+        int getLatencyInSamples() const noexcept  { return latency; }
+
+        //==============================================================================
+        /** Limits every channel in place and measures what leaves. */
+        void process (FloatType* const* channels, int numChannelsToProcess, int numSamples,
+                      ChannelLevels<FloatType>* levels) noexcept;
+
+    private:
+        void computeGains (int numSamples) noexcept;
+        FloatType getChunkGain (FloatType peak) noexcept;
+
+        //==============================================================================
+        typename SharedCache<int, Interpolator>::Handle interpolator;
+
+        std::array<ArenaArray<FloatType>, maxChannels> lines;     // latency samples of history, then the block
+        ArenaArray<FloatType> peaks, gains;
+        ArenaArray<FloatType> minimumValues, averageLine;
+        ArenaArray<int64> minimumTimes;
+
+        int numChannels = 0, maxSamples = 0;
+        int holdLength = 1, averageLength = 1, latency = 0;
+        int minimumFront = 0, minimumBack = 0, minimumSize = 0, averagePosition = 0;
+        int chunkPosition = 0;
+        int64 chunk = 0;
+        double averageSum = 1.0, ceilingDecibels = 0.0;
+        FloatType ceiling = 1, release = 0, envelope = 1, chunkPeak = 0;
+        std::array<FloatType, 2> chunkGains { FloatType (1), FloatType (1) };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakLimiter)
+    };
+
+    //==============================================================================
+    /** The limiter's 4x detector on its own, for the loudness meters. Shares the
+        interpolator and the kernels with every limiter, and keeps no state: the caller
+        hands over the history with the samples. */
+    template <typename FloatType>
+    class TruePeakDetector
+    {
+    public:
+        using Interpolator = typename TruePeakLimiter<FloatType>::Interpolator;
+
+        /** How many samples before the first one detect() reads. */
+        static constexpr int historySize = TruePeakLimiter<FloatType>::tapsPerPhase - 1;
+
+        TruePeakDetector()
+            : interpolator (SharedCache<int, Interpolator>::get (TruePeakLimiter<FloatType>::tapsPerPhase, &Interpolator::design))
+        {
+        }
+
+        /** Folds the true peak around each of numSamples samples into peaks, running half
+            the interpolator's length behind. samples points historySize samples before
+            the first new one. */
+        void detect (const FloatType* samples, FloatType* peaks, int numSamples) const noexcept;
+
+    private:
+        typename SharedCache<int, Interpolator>::Handle interpolator;
+    };
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+// GCC and clang only emit AVX2/AVX-512 code inside functions that are targeted at it.
+// Kernel entry points are flattened so the Vec helpers below get inlined into the
+// targeted body instead of being called. MSVC emits any intrinsic without flags.
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #define INFLATION_TARGET(isa) __attribute__ ((target (isa)))
+ #define INFLATION_KERNEL(isa) __attribute__ ((target (isa), flatten))
+#else
+ #define INFLATION_TARGET(isa)
+ #define INFLATION_KERNEL(isa)
+#endif
+
+namespace Dsp {
+
+    //==============================================================================
+    /** Instruction sets we have kernels for, ordered from slowest to fastest. */
+    enum class Isa
+    {
+        scalar = 0,
+        sse2,
+        avx2,
+        avx512
+    };
+
+    inline const char* getIsaName (Isa isa) noexcept
+    {
+        switch (isa)
+        {
+            case Isa::sse2:     return "sse2";
+            case Isa::avx2:     return "avx2";
+            case Isa::avx512:   return "avx512";
+            case Isa::scalar:
+            default:            return "scalar";
+        }
+    }
+
+    /** Returns the widest instruction set the running CPU supports.
+
+        The INFLATION_ISA environment variable ("scalar", "sse2", "avx2") caps it, so the
+        other kernels can be checked against each other on one machine.
+
+        Each kernel table calls this once while the library loads; it allocates nothing
+        either way, but it isn't meant for the audio thread.
+    */
+    inline Isa detectIsa() noexcept
+    {
+        auto isa = Isa::scalar;
+
+       #if JUCE_INTEL
+        if (SystemStats::hasAVX512F())
+            isa = Isa::avx512;
+        else if (SystemStats::hasAVX2() && SystemStats::hasFMA3())
+            isa = Isa::avx2;
+        else if (SystemStats::hasSSE2())
+            isa = Isa::sse2;
+       #endif
+
+        if (const auto* cap = std::getenv ("INFLATION_ISA"))
+            for (auto lower = Isa::scalar; lower < isa; lower = static_cast<Isa> (static_cast<int> (lower) + 1))
+                if (std::strcmp (cap, getIsaName (lower)) == 0)
+                    return lower;
+
+        return isa;
+    }
+
+    //==============================================================================
+    /** 0, 1, 2... for building per-lane ramps with a single load. */
+    template <typename FloatType>
+    struct LaneIndex
+    {
+        alignas (64) static constexpr FloatType values[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    };
+
+    //==============================================================================
+    /*  Thin wrappers around one register's worth of samples. Kernels are written once
+        as templates over these and instantiated per instruction set.
+    */
+    template <typename FloatType>
+    struct ScalarVec
+    {
+        using Register = FloatType;
+        static constexpr int size = 1;
+
+        static forcedinline Register load (const FloatType* p) noexcept                 { return *p; }
+        static forcedinline void store (FloatType* p, Register v) noexcept               { *p = v; }
+        static forcedinline Register broadcast (FloatType v) noexcept                    { return v; }
+        static forcedinline Register add (Register a, Register b) noexcept               { return a + b; }
+        static forcedinline Register sub (Register a, Register b) noexcept               { return a - b; }
+        static forcedinline Register mul (Register a, Register b) noexcept               { return a * b; }
+        static forcedinline Register mulAdd (Register a, Register b, Register c) noexcept { return a * b + c; }
+        static forcedinline Register min (Register a, Register b) noexcept               { return a < b ? a : b; }
+        static forcedinline Register max (Register a, Register b) noexcept               { return a > b ? a : b; }
+        static forcedinline Register abs (Register a) noexcept                           { return std::abs (a); }
+        static forcedinline Register div (Register a, Register b) noexcept               { return a / b; }
+
+        // a < b ? ifLess : otherwise, per lane
+        static forcedinline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept { return a < b ? ifLess : otherwise; }
+    };
+
+   #if JUCE_INTEL
+    //==============================================================================
+    struct Sse2Float
+    {
+        using Register = __m128;
+        static constexpr int size = 4;
+
+        static forcedinline Register load (const float* p) noexcept                      { return _mm_loadu_ps (p); }
+        static forcedinline void store (float* p, Register v) noexcept                    { _mm_storeu_ps (p, v); }
+        static forcedinline Register broadcast (float v) noexcept                         { return _mm_set1_ps (v); }
+        static forcedinline Register add (Register a, Register b) noexcept                { return _mm_add_ps (a, b); }
+        static forcedinline Register sub (Register a, Register b) noexcept                { return _mm_sub_ps (a, b); }
+        static forcedinline Register mul (Register a, Register b) noexcept                { return _mm_mul_ps (a, b); }
+        static forcedinline Register mulAdd (Register a, Register b, Register c) noexcept { return _mm_add_ps (_mm_mul_ps (a, b), c); }
+        static forcedinline Register min (Register a, Register b) noexcept                { return _mm_min_ps (a, b); }
+        static forcedinline Register max (Register a, Register b) noexcept                { return _mm_max_ps (a, b); }
+        static forcedinline Register abs (Register a) noexcept                            { return _mm_andnot_ps (_mm_set1_ps (-0.0f), a); }
+        static forcedinline Register div (Register a, Register b) noexcept                { return _mm_div_ps (a, b); }
+
+        static forcedinline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept
+        {
+            const auto mask = _mm_cmplt_ps (a, b);
+            return _mm_or_ps (_mm_and_ps (mask, ifLess), _mm_andnot_ps (mask, otherwise));
+        }
+    };
+
+    struct Sse2Double
+    {
+        using Register = __m128d;
+        static constexpr int size = 2;
+
+        static forcedinline Register load (const double* p) noexcept                     { return _mm_loadu_pd (p); }
+        static forcedinline void store (double* p, Register v) noexcept                   { _mm_storeu_pd (p, v); }
+        static forcedinline Register broadcast (double v) noexcept                        { return _mm_set1_pd (v); }
+        static forcedinline Register add (Register a, Register b) noexcept                { return _mm_add_pd (a, b); }
+        static forcedinline Register sub (Register a, Register b) noexcept                { return _mm_sub_pd (a, b); }
+        static forcedinline Register mul (Register a, Register b) noexcept                { return _mm_mul_pd (a, b); }
+        static forcedinline Register mulAdd (Register a, Register b, Register c) noexcept { return _mm_add_pd (_mm_mul_pd (a, b), c); }
+        static forcedinline Register min (Register a, Register b) noexcept                { return _mm_min_pd (a, b); }
+        static forcedinline Register max (Register a, Register b) noexcept                { return _mm_max_pd (a, b); }
+        static forcedinline Register abs (Register a) noexcept                            { return _mm_andnot_pd (_mm_set1_pd (-0.0), a); }
+        static forcedinline Register div (Register a, Register b) noexcept                { return _mm_div_pd (a, b); }
+
+        static forcedinline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept
+        {
+            const auto mask = _mm_cmplt_pd (a, b);
+            return _mm_or_pd (_mm_and_pd (mask, ifLess), _mm_andnot_pd (mask, otherwise));
+        }
+    };
+
+    //==============================================================================
+    // The AVX2 and AVX-512 helpers are plain inline rather than forcedinline: they are only
+    // ever reached through an INFLATION_KERNEL entry point, which inlines them itself.
+    struct Avx2Float
+    {
+        using Register = __m256;
+        static constexpr int size = 8;
+
+        INFLATION_TARGET ("avx2,fma") static inline Register load (const float* p) noexcept                      { return _mm256_loadu_ps (p); }
+        INFLATION_TARGET ("avx2,fma") static inline void store (float* p, Register v) noexcept                    { _mm256_storeu_ps (p, v); }
+        INFLATION_TARGET ("avx2,fma") static inline Register broadcast (float v) noexcept                         { return _mm256_set1_ps (v); }
+        INFLATION_TARGET ("avx2,fma") static inline Register add (Register a, Register b) noexcept                { return _mm256_add_ps (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register sub (Register a, Register b) noexcept                { return _mm256_sub_ps (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register mul (Register a, Register b) noexcept                { return _mm256_mul_ps (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register mulAdd (Register a, Register b, Register c) noexcept { return _mm256_fmadd_ps (a, b, c); }
+        INFLATION_TARGET ("avx2,fma") static inline Register min (Register a, Register b) noexcept                { return _mm256_min_ps (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register max (Register a, Register b) noexcept                { return _mm256_max_ps (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register abs (Register a) noexcept                            { return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), a); }
+        INFLATION_TARGET ("avx2,fma") static inline Register div (Register a, Register b) noexcept                { return _mm256_div_ps (a, b); }
+
+        INFLATION_TARGET ("avx2,fma") static inline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept
+        {
+            return _mm256_blendv_ps (otherwise, ifLess, _mm256_cmp_ps (a, b, _CMP_LT_OQ));
+        }
+    };
+
+    struct Avx2Double
+    {
+        using Register = __m256d;
+        static constexpr int size = 4;
+
+        INFLATION_TARGET ("avx2,fma") static inline Register load (const double* p) noexcept                     { return _mm256_loadu_pd (p); }
+        INFLATION_TARGET ("avx2,fma") static inline void store (double* p, Register v) noexcept                   { _mm256_storeu_pd (p, v); }
+        INFLATION_TARGET ("avx2,fma") static inline Register broadcast (double v) noexcept                        { return _mm256_set1_pd (v); }
+        INFLATION_TARGET ("avx2,fma") static inline Register add (Register a, Register b) noexcept                { return _mm256_add_pd (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register sub (Register a, Register b) noexcept                { return _mm256_sub_pd (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register mul (Register a, Register b) noexcept                { return _mm256_mul_pd (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register mulAdd (Register a, Register b, Register c) noexcept { return _mm256_fmadd_pd (a, b, c); }
+        INFLATION_TARGET ("avx2,fma") static inline Register min (Register a, Register b) noexcept                { return _mm256_min_pd (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register max (Register a, Register b) noexcept                { return _mm256_max_pd (a, b); }
+        INFLATION_TARGET ("avx2,fma") static inline Register abs (Register a) noexcept                            { return _mm256_andnot_pd (_mm256_set1_pd (-0.0), a); }
+        INFLATION_TARGET ("avx2,fma") static inline Register div (Register a, Register b) noexcept                { return _mm256_div_pd (a, b); }
+
+        INFLATION_TARGET ("avx2,fma") static inline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept
+        {
+            return _mm256_blendv_pd (otherwise, ifLess, _mm256_cmp_pd (a, b, _CMP_LT_OQ));
+        }
+    };
+
+    //==============================================================================
+    struct Avx512Float
+    {
+        using Register = __m512;
+        static constexpr int size = 16;
+
+        INFLATION_TARGET ("avx512f") static inline Register load (const float* p) noexcept                      { return _mm512_loadu_ps (p); }
+        INFLATION_TARGET ("avx512f") static inline void store (float* p, Register v) noexcept                    { _mm512_storeu_ps (p, v); }
+        INFLATION_TARGET ("avx512f") static inline Register broadcast (float v) noexcept                         { return _mm512_set1_ps (v); }
+        INFLATION_TARGET ("avx512f") static inline Register add (Register a, Register b) noexcept                { return _mm512_add_ps (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register sub (Register a, Register b) noexcept                { return _mm512_sub_ps (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register mul (Register a, Register b) noexcept                { return _mm512_mul_ps (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register mulAdd (Register a, Register b, Register c) noexcept { return _mm512_fmadd_ps (a, b, c); }
+        INFLATION_TARGET ("avx512f") static inline Register min (Register a, Register b) noexcept                { return _mm512_min_ps (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register max (Register a, Register b) noexcept                { return _mm512_max_ps (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register abs (Register a) noexcept                            { return _mm512_abs_ps (a); }
+        INFLATION_TARGET ("avx512f") static inline Register div (Register a, Register b) noexcept                { return _mm512_div_ps (a, b); }
+
+        INFLATION_TARGET ("avx512f") static inline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept
+        {
+            return _mm512_mask_blend_ps (_mm512_cmp_ps_mask (a, b, _CMP_LT_OQ), otherwise, ifLess);
+        }
+    };
+
+    struct Avx512Double
+    {
+        using Register = __m512d;
+        static constexpr int size = 8;
+
+        INFLATION_TARGET ("avx512f") static inline Register load (const double* p) noexcept                     { return _mm512_loadu_pd (p); }
+        INFLATION_TARGET ("avx512f") static inline void store (double* p, Register v) noexcept                   { _mm512_storeu_pd (p, v); }
+        INFLATION_TARGET ("avx512f") static inline Register broadcast (double v) noexcept                        { return _mm512_set1_pd (v); }
+        INFLATION_TARGET ("avx512f") static inline Register add (Register a, Register b) noexcept                { return _mm512_add_pd (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register sub (Register a, Register b) noexcept                { return _mm512_sub_pd (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register mul (Register a, Register b) noexcept                { return _mm512_mul_pd (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register mulAdd (Register a, Register b, Register c) noexcept { return _mm512_fmadd_pd (a, b, c); }
+        INFLATION_TARGET ("avx512f") static inline Register min (Register a, Register b) noexcept                { return _mm512_min_pd (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register max (Register a, Register b) noexcept                { return _mm512_max_pd (a, b); }
+        INFLATION_TARGET ("avx512f") static inline Register abs (Register a) noexcept                            { return _mm512_abs_pd (a); }
+        INFLATION_TARGET ("avx512f") static inline Register div (Register a, Register b) noexcept                { return _mm512_div_pd (a, b); }
+
+        INFLATION_TARGET ("avx512f") static inline Register select (Register a, Register b, Register ifLess, Register otherwise) noexcept
+        {
+            return _mm512_mask_blend_pd (_mm512_cmp_pd_mask (a, b, _CMP_LT_OQ), otherwise, ifLess);
+        }
+    };
+   #endif
+}
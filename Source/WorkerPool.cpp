@@ -0,0 +1,85 @@
+#include "WorkerPool.h"
+
+namespace Dsp {
+
+WorkerPool::Worker::Worker (WorkerPool& owner, int index)
+    : Thread ("Inflation worker " + String (index)),
+      pool (owner),
+      workerIndex (index)
+{
+}
+
+void WorkerPool::Worker::run()
+{
+    // the tasks are DSP, which the audio thread runs with denormals flushed too
+    ScopedNoDenormals noDenormals;
+
+    for (;;)
+    {
+        start.wait (-1);
+
+        if (threadShouldExit())
+            return;
+
+        pool.work (workerIndex);
+
+        // the last one out wakes the caller, after which nothing of the run is touched
+        if (--pool.numRunning == 0)
+            pool.finished.signal();
+    }
+}
+
+//==============================================================================
+WorkerPool::~WorkerPool()
+{
+    release();
+}
+
+void WorkerPool::prepare (int numWorkers)
+{
+    const auto numThreads = jmin (numWorkers, SystemStats::getNumCpus()) - 1;
+
+    while ((int) threads.size() < numThreads)
+    {
+        threads.push_back (std::make_unique<Worker> (*this, getNumWorkers()));
+        threads.back()->startThread (Thread::Priority::high);
+    }
+}
+
+void WorkerPool::release()
+{
+    for (auto& thread : threads)
+    {
+        thread->signalThreadShouldExit();
+        thread->start.signal();
+    }
+
+    for (auto& thread : threads)
+        thread->stopThread (1000);
+
+    threads.clear();
+}
+
+void WorkerPool::runTasks (int numTasks, Function function, void* context) noexcept
+{
+    taskFunction = function;
+    taskContext = context;
+    taskCount = numTasks;
+    nextTask = 0;
+    numRunning = (int) threads.size();
+
+    // the events lock, so the workers see the run set up above
+    for (auto& thread : threads)
+        thread->start.signal();
+
+    work (0);
+    finished.wait (-1);
+}
+
+void WorkerPool::work (int worker) noexcept
+{
+    for (auto index = nextTask++; index < taskCount; index = nextTask++)
+        taskFunction (taskContext, index, worker);
+}
+
+}
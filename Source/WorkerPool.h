@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+
+    //==============================================================================
+    /*  A few threads that share out the channels of a block while the host renders offline.
+
+        run() hands out numbered tasks from an atomic counter: the calling thread takes
+        them as worker 0 and every other worker takes them on its own thread, so a task
+        is never queued and run() never allocates. It returns once every worker has
+        finished, so tasks may refer to the caller's locals.
+
+        The threads are started once, by prepare(), and then only sleep between blocks,
+        so going back to real time costs nothing and the next render needs no new ones.
+        Waking and waiting lock, which is fine offline but not on a real-time thread.
+    */
+    class WorkerPool
+    {
+    public:
+        WorkerPool() = default;
+        ~WorkerPool();
+
+        /** Makes sure at least numWorkers can run at once, the caller included; more threads
+            than the CPU has cores are never started. Allocates, so not from the audio thread. */
+        void prepare (int numWorkers);
+
+        /** Stops and deletes the threads. */
+        void release();
+
+        /** The most tasks that run at once, the calling thread included. */
+        int getNumWorkers() const noexcept      { return (int) threads.size() + 1; }
+
+        /** Calls task (index, worker) for every index below numTasks and returns once all are
+            done. worker is below getNumWorkers() and no two tasks running at once share it. */
+        template <typename Task>
+        void run (int numTasks, Task&& task) noexcept
+        {
+            if (threads.empty() || numTasks < 2)
+            {
+                for (auto i = 0; i < numTasks; ++i)
+                    task (i, 0);
+
+                return;
+            }
+
+            using TaskType = std::remove_reference_t<Task>;
+            runTasks (numTasks, [] (void* context, int index, int worker) { (*static_cast<TaskType*> (context)) (index, worker); },
+                      const_cast<std::remove_const_t<TaskType>*> (&task));
+        }
+
+    private:
+        using Function = void (*) (void*, int, int);
+
+        class Worker : public Thread
+        {
+        public:
+            Worker (WorkerPool& owner, int index);
+            void run() override;
+
+            WaitableEvent start;
+
+        private:
+            WorkerPool& pool;
+            const int workerIndex;
+        };
+
+        void runTasks (int numTasks, Function function, void* context) noexcept;
+        void work (int worker) noexcept;
+
+        std::vector<std::unique_ptr<Worker>> threads;
+        WaitableEvent finished;
+
+        // the current run, set before the workers are woken
+        Function taskFunction = nullptr;
+        void* taskContext = nullptr;
+        int taskCount = 0;
+        std::atomic<int> nextTask { 0 }, numRunning { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (WorkerPool)
+    };
+}
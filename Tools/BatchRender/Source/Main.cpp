@@ -0,0 +1,375 @@
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+/*  Renders audio files through InflationPluginAudioProcessor without a host, for
+    mastering jobs that run unattended.
+
+        BatchRender <file or directory> --output=<directory> [options]
+
+    Every file is streamed in large blocks through a memory mapped reader where the
+    format allows it, so memory use doesn't grow with the file's length. Files are
+    spread over a thread pool, one file per worker.
+*/
+namespace {
+
+    struct RenderOptions
+    {
+        File outputDirectory;
+        File preset;
+        StringPairArray overrides;  // parameter ID to value, in the parameter's own units
+        String format;              // output extension, empty to keep the input's
+        int bitDepth = 24;
+        int blockSize = 65536;
+        int workersPerFile = 1;     // threads a processor shares a file's channels out over
+        bool useDouble = false;
+        bool useMixed = false;      // double I/O, float processing
+    };
+
+    //==============================================================================
+    bool applyPreset (InflationPluginAudioProcessor& processor, const File& preset, String& error)
+    {
+        if (preset == File())
+            return true;
+
+        // either the XML the plug-in stores, or a raw state blob saved from a host
+        if (auto xml = parseXML (preset))
+        {
+            processor.state.replaceState (ValueTree::fromXml (*xml));
+            return true;
+        }
+
+        MemoryBlock data;
+
+        if (! preset.loadFileAsData (data) || data.isEmpty())
+        {
+            error = "can't read preset " + preset.getFullPathName();
+            return false;
+        }
+
+        processor.setStateInformation (data.getData(), (int) data.getSize());
+        return true;
+    }
+
+    bool applyOverrides (InflationPluginAudioProcessor& processor, const StringPairArray& overrides, String& error)
+    {
+        for (auto& id : overrides.getAllKeys())
+        {
+            auto* parameter = processor.state.getParameter (id);
+
+            if (parameter == nullptr)
+            {
+                error = "unknown parameter " + id;
+                return false;
+            }
+
+            // choices and toggles can be given by name as well as by index
+            const auto text = overrides[id];
+            auto value = parameter->getValueForText (text);
+
+            if (text.containsOnly ("-+.0123456789"))
+                value = parameter->convertTo0to1 (text.getFloatValue());
+
+            parameter->setValueNotifyingHost (value);
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    class RenderJob : public ThreadPoolJob
+    {
+    public:
+        RenderJob (const File& inputFile, const RenderOptions& renderOptions)
+            : ThreadPoolJob (inputFile.getFileName()),
+              input (inputFile),
+              options (renderOptions)
+        {
+            // parameter state is set up here, on the message thread, before the job runs
+            if (applyPreset (processor, options.preset, error))
+                applyOverrides (processor, options.overrides, error);
+        }
+
+        JobStatus runJob() override
+        {
+            if (error.isEmpty())
+                succeeded = render();
+
+            return jobHasFinished;
+        }
+
+        File getInput() const           { return input; }
+        bool hasSucceeded() const       { return succeeded; }
+        const String& getError() const  { return error; }
+
+    private:
+        bool render()
+        {
+            AudioFormatManager formats;
+            formats.registerBasicFormats();
+
+            auto* inputFormat = formats.findFormatForFileExtension (input.getFileExtension());
+
+            if (inputFormat == nullptr)
+                return fail ("unsupported input format");
+
+            // mapped readers only map the section being read, so the file is never in memory as a whole
+            std::unique_ptr<MemoryMappedAudioFormatReader> mapped (inputFormat->createMemoryMappedReader (input));
+            std::unique_ptr<AudioFormatReader> streamed;
+            AudioFormatReader* reader = mapped.get();
+
+            if (mapped == nullptr)
+            {
+                streamed.reset (inputFormat->createReaderFor (input.createInputStream().release(), true));
+                reader = streamed.get();
+            }
+
+            if (reader == nullptr)
+                return fail ("can't open for reading");
+
+            const auto numChannels = static_cast<int> (reader->numChannels);
+            const auto sampleRate = reader->sampleRate;
+            const auto length = reader->lengthInSamples;
+
+            if (numChannels < 1 || numChannels > InflationPluginAudioProcessor::maxNumChannels)
+                return fail ("unsupported channel count " + String (numChannels));
+
+            const auto layout = AudioChannelSet::canonicalChannelSet (numChannels);
+            AudioProcessor::BusesLayout buses;
+            buses.inputBuses.add (layout);
+            buses.outputBuses.add (layout);
+
+            if (! processor.setBusesLayout (buses))
+                return fail ("unsupported channel layout");
+
+            const auto outputFile = getOutputFile();
+            auto* outputFormat = formats.findFormatForFileExtension (outputFile.getFileExtension());
+
+            if (outputFormat == nullptr)
+                return fail ("unsupported output format " + outputFile.getFileExtension());
+
+            outputFile.deleteFile();
+            auto stream = outputFile.createOutputStream (1 << 20);
+
+            if (stream == nullptr)
+                return fail ("can't write " + outputFile.getFullPathName());
+
+            std::unique_ptr<AudioFormatWriter> writer (outputFormat->createWriterFor (stream.get(), sampleRate,
+                                                                                      (unsigned int) numChannels,
+                                                                                      options.bitDepth, reader->metadataValues, 0));
+
+            if (writer == nullptr)
+                return fail ("can't write " + String (options.bitDepth) + " bit " + outputFile.getFileExtension());
+
+            stream.release(); // the writer owns it now
+
+            processor.setNonRealtime (true);
+            processor.setMaxRenderWorkers (options.workersPerFile);
+            processor.setMixedPrecision (options.useMixed);
+            processor.setProcessingPrecision (options.useDouble ? AudioProcessor::doublePrecision
+                                                                : AudioProcessor::singlePrecision);
+            processor.prepareToPlay (sampleRate, options.blockSize);
+
+            AudioBuffer<float> buffer (numChannels, options.blockSize);
+            AudioBuffer<double> doubleBuffer (options.useDouble ? numChannels : 0, options.useDouble ? options.blockSize : 0);
+            MidiBuffer midi;
+
+            // the oversampling filters delay everything, so the start is trimmed and the end flushed with silence
+            const auto latency = static_cast<int64> (processor.getLatencySamples());
+            int64 readPosition = 0, discarded = 0, written = 0;
+
+            while (written < length)
+            {
+                if (shouldExit())
+                    return fail ("cancelled");
+
+                const auto numToRead = static_cast<int> (jlimit<int64> (0, options.blockSize, length - readPosition));
+                buffer.clear();
+
+                if (numToRead > 0)
+                {
+                    if (mapped != nullptr && ! mapped->mapSectionOfFile ({ readPosition, readPosition + numToRead }))
+                        return fail ("can't map sample " + String (readPosition));
+
+                    if (! reader->read (&buffer, 0, numToRead, readPosition, true, true))
+                        return fail ("read error at sample " + String (readPosition));
+
+                    readPosition += numToRead;
+                }
+
+                if (options.useDouble)
+                {
+                    doubleBuffer.makeCopyOf (buffer, true);
+                    processor.processBlock (doubleBuffer, midi);
+                    buffer.makeCopyOf (doubleBuffer, true);
+                }
+                else
+                {
+                    processor.processBlock (buffer, midi);
+                }
+
+                const auto start = static_cast<int> (jmin<int64> (options.blockSize, latency - discarded));
+                const auto numToWrite = static_cast<int> (jmin<int64> (options.blockSize - start, length - written));
+                discarded += start;
+
+                if (numToWrite > 0 && ! writer->writeFromAudioSampleBuffer (buffer, start, numToWrite))
+                    return fail ("write error");
+
+                written += numToWrite;
+            }
+
+            processor.releaseResources();
+            return true;
+        }
+
+        File getOutputFile() const
+        {
+            const auto extension = options.format.isNotEmpty() ? "." + options.format.trimCharactersAtStart (".")
+                                                               : input.getFileExtension();
+
+            return options.outputDirectory.getChildFile (input.getFileNameWithoutExtension() + extension);
+        }
+
+        bool fail (const String& message)
+        {
+            error = message;
+            return false;
+        }
+
+        File input;
+        RenderOptions options;
+        InflationPluginAudioProcessor processor;
+        String error;
+        bool succeeded = false;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+    };
+
+    //==============================================================================
+    RenderOptions parseOptions (const ArgumentList& args)
+    {
+        RenderOptions options;
+
+        if (args.getValueForOption ("--output").isEmpty())
+            ConsoleApplication::fail ("no --output=<directory> given");
+
+        options.outputDirectory = File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--output"));
+
+        if (! options.outputDirectory.createDirectory())
+            ConsoleApplication::fail ("can't create " + options.outputDirectory.getFullPathName());
+
+        if (args.containsOption ("--preset"))
+            options.preset = args.getExistingFileForOption ("--preset");
+
+        if (args.containsOption ("--format"))
+            options.format = args.getValueForOption ("--format");
+
+        if (args.containsOption ("--bits"))
+            options.bitDepth = args.getValueForOption ("--bits").getIntValue();
+
+        if (args.containsOption ("--block-size"))
+            options.blockSize = jlimit (64, 1 << 20, args.getValueForOption ("--block-size").getIntValue());
+
+        options.useMixed = args.containsOption ("--fast");
+        options.useDouble = options.useMixed || args.containsOption ("--double");
+
+        for (auto& arg : args.arguments)
+        {
+            if (! arg.isLongOption ("set"))
+                continue;
+
+            const auto assignment = arg.getLongOptionValue();
+
+            if (! assignment.containsChar ('='))
+                ConsoleApplication::fail ("--set expects <parameter>=<value>, got " + assignment);
+
+            options.overrides.set (assignment.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                   assignment.fromFirstOccurrenceOf ("=", false, false).trim());
+        }
+
+        // the settings as given, so --set=oversampling=4x renders 4x, unless Best is asked for
+        if (! options.overrides.containsKey ("renderQuality"))
+            options.overrides.set ("renderQuality", "0");
+
+        return options;
+    }
+
+    Array<File> findInputFiles (const ArgumentList& args)
+    {
+        if (args.size() == 0 || args[0].isOption())
+            ConsoleApplication::fail ("no input file or directory given");
+
+        const auto input = args[0].resolveAsExistingFile();
+
+        if (! input.isDirectory())
+            return { input };
+
+        auto files = input.findChildFiles (File::findFiles, false, "*.wav;*.aif;*.aiff;*.flac");
+        files.sort();
+        return files;
+    }
+
+    int render (const ArgumentList& args)
+    {
+        auto options = parseOptions (args);
+        const auto inputs = findInputFiles (args);
+        const auto numThreads = args.containsOption ("--threads") ? jmax (1, args.getValueForOption ("--threads").getIntValue())
+                                                                  : SystemStats::getNumPhysicalCpus();
+
+        // the threads go to the files first, a file's channels only get the ones left over
+        options.workersPerFile = jmax (1, numThreads / jmax (1, inputs.size()));
+
+        OwnedArray<RenderJob> jobs;
+        ThreadPool pool (numThreads);
+
+        for (auto& input : inputs)
+            pool.addJob (jobs.add (new RenderJob (input, options)), false);
+
+        while (pool.getNumJobs() > 0)
+            Thread::sleep (50);
+
+        auto numFailed = 0;
+
+        for (auto* job : jobs)
+        {
+            if (job->hasSucceeded())
+            {
+                std::cout << "rendered " << job->getInput().getFileName() << std::endl;
+            }
+            else
+            {
+                std::cerr << "failed   " << job->getInput().getFileName() << ": " << job->getError() << std::endl;
+                ++numFailed;
+            }
+        }
+
+        return numFailed;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // the processor's parameter state expects a message manager to exist
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ConsoleApplication app;
+
+    app.addHelpCommand ("--help|-h", "Renders audio files through Inflation.", false);
+
+    app.addDefaultCommand ({ "",
+                             "<file or directory> --output=<directory> [--preset=<file>] [--set=<parameter>=<value>]... "
+                             "[--format=wav|aiff|flac] [--bits=<n>] [--block-size=<n>] [--threads=<n>] [--double|--fast]",
+                             "Renders a file, or every audio file in a directory, through Inflation.",
+                             "Parameters are set by ID in their own units, e.g. --set=curve=20 --set=oversampling=4x.\n"
+                             "A preset is either the plug-in's state XML or a state blob saved from a host.\n"
+                             "Output keeps the input's length; oversampling and limiter latency is compensated.\n"
+                             "--double processes in double precision, --fast reads and writes double but processes in float.",
+                             [] (const ArgumentList& args)
+                             {
+                                 if (const auto numFailed = render (args))
+                                     ConsoleApplication::fail (String (numFailed) + " of the files failed");
+                             } });
+
+    return app.findAndRunCommand (argc, argv);
+}
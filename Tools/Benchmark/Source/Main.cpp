@@ -0,0 +1,419 @@
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "Verify.h"
+#include "Soak.h"
+
+//==============================================================================
+/*  Times the processor and its DSP stages without a host and prints the results as
+    JSON, so runs from different builds can be compared.
+
+        InflationBenchmark [--output=<file>] [--quick] [--oversampling]
+        InflationBenchmark --verify [--golden=<file> | --write-golden=<file>] [--verbose]
+        InflationBenchmark --soak [--minutes=<n>] [--seed=<n>] [--verbose]
+
+    Times are per sample per channel. Each case is run in rounds for a fixed time and
+    the fastest round is reported, which keeps scheduler noise out of the numbers.
+    Input is refreshed between calls outside the timed region. The memory section lists
+    what 1, 10 and 100 instances cost, per instance and shared. --verify checks the
+    output instead of timing it, see Verify.h. --soak plays it the way careless hosts
+    do for a long time, see Soak.h.
+*/
+namespace {
+
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        double secondsPerRound = 0.05;
+        int numRounds = 5;
+        Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        Array<int> oversamplingOrders { 0 };
+    };
+
+    struct Mode
+    {
+        const char* name;
+        bool zeroClip, bandSplit, adaa;
+    };
+
+    // ADAA against the oversampling orders is the comparison it exists for
+    const Mode modes[] = { { "plain",     false, false, false },
+                           { "zeroClip",  true,  false, false },
+                           { "bandSplit", false, true,  false },
+                           { "adaa",      true,  false, true  } };
+
+    //==============================================================================
+    template <typename FloatType>
+    void fillWithNoise (AudioBuffer<FloatType>& buffer, Random& random)
+    {
+        // roughly -12 dBFS, loud enough to exercise the clip
+        for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (auto i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (channel, i, static_cast<FloatType> (random.nextFloat() - 0.5f) * FloatType (0.5));
+    }
+
+    /** Calls refresh() untimed and run() timed until a round is long enough, returns the best round in ns per sample. */
+    template <typename Refresh, typename Run>
+    double measure (const Settings& settings, int64 samplesPerCall, Refresh&& refresh, Run&& run)
+    {
+        const auto ticksPerRound = static_cast<int64> (settings.secondsPerRound * (double) Time::getHighResolutionTicksPerSecond());
+        auto best = std::numeric_limits<double>::max();
+
+        // one untimed round to warm caches and branch predictors
+        for (auto round = -1; round < settings.numRounds; ++round)
+        {
+            int64 elapsed = 0, samples = 0;
+
+            while (elapsed < ticksPerRound)
+            {
+                refresh();
+                const auto start = Time::getHighResolutionTicks();
+                run();
+                elapsed += Time::getHighResolutionTicks() - start;
+                samples += samplesPerCall;
+            }
+
+            if (round >= 0)
+                best = jmin (best, Time::highResolutionTicksToSeconds (elapsed) * 1.0e9 / (double) samples);
+        }
+
+        return best;
+    }
+
+    var makeResult (const String& benchmark, const String& mode, const String& precision,
+                    int numChannels, int blockSize, int oversampling, double nsPerSample)
+    {
+        auto* result = new DynamicObject();
+        result->setProperty ("benchmark", benchmark);
+        result->setProperty ("mode", mode);
+        result->setProperty ("precision", precision);
+        result->setProperty ("channels", numChannels);
+        result->setProperty ("blockSize", blockSize);
+        result->setProperty ("oversampling", 1 << oversampling);
+        result->setProperty ("nsPerSample", nsPerSample);
+        result->setProperty ("samplesPerSecond", 1.0e9 / nsPerSample);
+        return var (result);
+    }
+
+    const char* getPrecisionName (float)    { return "float"; }
+    const char* getPrecisionName (double)   { return "double"; }
+
+    //==============================================================================
+    /** mixedPrecision runs the double buffers through the float chain. */
+    template <typename FloatType>
+    void benchmarkProcessor (const Settings& settings, Array<var>& results, bool mixedPrecision = false)
+    {
+        const auto precision = mixedPrecision ? "mixed" : getPrecisionName (FloatType());
+        Random random (1);
+        MidiBuffer midi;
+
+        for (auto numChannels : { 1, 2, 6, 12, 16 })
+        {
+            for (auto& mode : modes)
+            {
+                for (auto order : settings.oversamplingOrders)
+                {
+                    InflationPluginAudioProcessor processor;
+
+                    const auto layout = numChannels <= 2 ? AudioChannelSet::canonicalChannelSet (numChannels)
+                                                         : AudioChannelSet::discreteChannels (numChannels);
+                    AudioProcessor::BusesLayout buses;
+                    buses.inputBuses.add (layout);
+                    buses.outputBuses.add (layout);
+                    processor.setBusesLayout (buses);
+
+                    auto setParameter = [&processor] (const char* id, float value)
+                    {
+                        auto* parameter = processor.state.getParameter (id);
+                        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+                    };
+
+                    setParameter ("zeroClip", mode.zeroClip ? 1.0f : 0.0f);
+                    setParameter ("bandSplit", mode.bandSplit ? 1.0f : 0.0f);
+                    setParameter ("adaa", mode.adaa ? 1.0f : 0.0f);
+                    setParameter ("oversampling", (float) order);
+                    setParameter ("curve", 20.0f);
+
+                    // timed as a host plays it; a render would switch to other settings and sub-blocks
+                    processor.setNonRealtime (false);
+                    processor.setMixedPrecision (mixedPrecision);
+                    processor.setProcessingPrecision (std::is_same<FloatType, double>::value ? AudioProcessor::doublePrecision
+                                                                                           : AudioProcessor::singlePrecision);
+
+                    for (auto blockSize : settings.blockSizes)
+                    {
+                        processor.prepareToPlay (settings.sampleRate, blockSize);
+
+                        AudioBuffer<FloatType> source (numChannels, blockSize), buffer (numChannels, blockSize);
+                        fillWithNoise (source, random);
+
+                        const auto nsPerSample = measure (settings, (int64) blockSize * numChannels,
+                                                          [&] { buffer.makeCopyOf (source, true); },
+                                                          [&] { processor.processBlock (buffer, midi); });
+
+                        results.add (makeResult ("processor", mode.name, precision,
+                                                 numChannels, blockSize, order, nsPerSample));
+
+                        // silent input: the warm up round is long enough for the processor to fall asleep
+                        const auto nsPerSilentSample = measure (settings, (int64) blockSize * numChannels,
+                                                                [&] { buffer.clear(); },
+                                                                [&] { processor.processBlock (buffer, midi); });
+
+                        results.add (makeResult ("processor", String (mode.name) + ".silent", precision,
+                                                 numChannels, blockSize, order, nsPerSilentSample));
+
+                        processor.releaseResources();
+                    }
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    template <typename FloatType>
+    void benchmarkStages (const Settings& settings, Array<var>& results)
+    {
+        Random random (2);
+        const auto precision = getPrecisionName (FloatType());
+
+        for (auto blockSize : settings.blockSizes)
+        {
+            AudioBuffer<FloatType> source (1, blockSize), buffer (1, blockSize), dry (1, blockSize);
+            fillWithNoise (source, random);
+
+            auto* data = buffer.getWritePointer (0);
+            auto refresh = [&] { buffer.makeCopyOf (source, true); };
+
+            auto add = [&] (const char* stage, const char* mode, int oversampling, double nsPerSample)
+            {
+                results.add (makeResult (stage, mode, precision, 1, blockSize, oversampling, nsPerSample));
+            };
+
+            // the same block ramping and not, since those are different kernels
+            for (auto ramping : { false, true })
+            {
+                const auto mode = ramping ? "ramping" : "constant";
+                const Dsp::BlockRamp gain { 0.8, ramping ? 0.9 : 0.8 }, mix { 0.5, ramping ? 0.6 : 0.5 };
+                const Dsp::BlockRamp curve { 20.0, ramping ? 25.0 : 20.0 };
+                const auto settingsFor = [&] (Dsp::BlockRamp mixRamp)
+                {
+                    return Dsp::PipelineSettings<FloatType>::make (gain, mixRamp, gain, curve, blockSize, true);
+                };
+
+                const auto partialMix = settingsFor (mix);
+                const auto fullWet = settingsFor ({ 1.0, 1.0 });
+                Dsp::ChannelLevels<FloatType> input, output;
+
+                add ("pipeline.fused", mode, 0, measure (settings, blockSize, refresh, [&] { Dsp::Pipeline::process (data, blockSize, partialMix, input, output); }));
+                add ("pipeline.fusedFullWet", mode, 0, measure (settings, blockSize, refresh, [&] { Dsp::Pipeline::process (data, blockSize, fullWet, input, output); }));
+                add ("pipeline.input", mode, 0, measure (settings, blockSize, refresh, [&] { Dsp::Pipeline::processInput (data, dry.getWritePointer (0), blockSize, partialMix, input); }));
+                add ("pipeline.nonLinear", mode, 0, measure (settings, blockSize, refresh, [&] { Dsp::Pipeline::processNonLinear (data, blockSize, partialMix.shaper, partialMix.shaperIncrement, true, ramping); }));
+                add ("pipeline.antiderivative", mode, 0, measure (settings, blockSize, refresh, [&]
+                {
+                    FloatType history = 0;
+                    Dsp::Pipeline::processAntiderivative (data, blockSize, partialMix.shaper, partialMix.shaperIncrement, true, ramping, history);
+                }));
+                add ("pipeline.output", mode, 0, measure (settings, blockSize, refresh, [&] { Dsp::Pipeline::processOutput (data, dry.getReadPointer (0), blockSize, partialMix, output); }));
+
+                // one band per lane and the channels in turn, so the band count is what matters;
+                // the crossovers and curves are handed over every block, as the processor does
+                const Dsp::BlockRamp bandCurves[Dsp::maxBands] { curve, curve, curve, curve, curve, curve };
+                const bool bandClips[Dsp::maxBands] { true, true, true, true, true, true };
+                Dsp::BlockRamp crossovers[Dsp::maxCrossovers];
+
+                for (auto i = 0; i < Dsp::maxCrossovers; ++i)
+                    crossovers[i] = { Dsp::defaultCrossovers[i], Dsp::defaultCrossovers[i] * (ramping ? 1.1 : 1.0) };
+
+                for (auto numBands : { 2, 3, 6 })
+                {
+                    for (auto numChannels : { 1, 2, 8, 16 })
+                    {
+                        AudioBuffer<FloatType> channels (numChannels, blockSize);
+                        fillWithNoise (channels, random);
+
+                        Dsp::MultiBandCrossover<FloatType> crossover;
+                        Dsp::ScratchArena arena;
+                        arena.build ([&] (Dsp::ScratchArena& memory) { crossover.prepare (memory, numChannels, blockSize, settings.sampleRate); });
+                        crossover.setNumBands (numBands);
+
+                        results.add (makeResult ("crossover", String (mode) + "." + String (numBands) + "bands", precision,
+                                                 numChannels, blockSize, 0,
+                                                 measure (settings, (int64) blockSize * numChannels, [] {}, [&]
+                                                 {
+                                                     crossover.setCrossovers (crossovers, blockSize);
+                                                     crossover.setBands (bandCurves, bandClips, blockSize);
+                                                     crossover.process (channels.getArrayOfWritePointers(), numChannels, blockSize);
+                                                 })));
+                    }
+                }
+            }
+
+            // the gain is shared, so the limiter is timed across channels too
+            for (auto numChannels : { 1, 2, 8, 16 })
+            {
+                AudioBuffer<FloatType> limiterSource (numChannels, blockSize), channels (numChannels, blockSize);
+                fillWithNoise (limiterSource, random);
+
+                Dsp::TruePeakLimiter<FloatType> limiter;
+                Dsp::ScratchArena arena;
+                arena.build ([&] (Dsp::ScratchArena& memory) { limiter.prepare (memory, numChannels, blockSize, settings.sampleRate); });
+                limiter.setCeiling (-1.0);
+
+                Dsp::ChannelLevels<FloatType> levels[Dsp::maxChannels];
+
+                results.add (makeResult ("truePeakLimiter", "-1 dBTP", precision, numChannels, blockSize, 0,
+                                         measure (settings, (int64) blockSize * numChannels,
+                                                  [&] { channels.makeCopyOf (limiterSource, true); },
+                                                  [&] { limiter.process (channels.getArrayOfWritePointers(), numChannels, blockSize, levels); })));
+            }
+
+            Dsp::ChannelLevels<FloatType> silenceLevels;
+            add ("pipeline.measure", "silenceCheck", 0, measure (settings, blockSize, [] {}, [&] { Dsp::Pipeline::measure (data, blockSize, silenceLevels); }));
+
+            const auto coefficients = Dsp::ShaperCoefficients<FloatType>::fromCurve (20.0);
+            const Dsp::ShaperCoefficients<FloatType> steady { 0, 0, 0, 0 };
+            add ("pipeline.nonLinear", "unclipped", 0, measure (settings, blockSize, refresh, [&] { Dsp::Pipeline::processNonLinear (data, blockSize, coefficients, steady, false, false); }));
+            add ("pipeline.nonLinear", "reference", 0, measure (settings, blockSize, refresh, [&] { shapeReference (data, blockSize, coefficients); }));
+
+            for (auto filter : { Dsp::Oversampler<FloatType>::Filter::linearPhase, Dsp::Oversampler<FloatType>::Filter::zeroLatency })
+            {
+                Dsp::Oversampler<FloatType> oversampler;
+                Dsp::ScratchArena arena;
+                arena.build ([&] (Dsp::ScratchArena& memory)
+                {
+                    oversampler.prepare (memory, 1, blockSize, blockSize << Dsp::Oversampler<FloatType>::maxOrder);
+                });
+
+                for (auto order = 1; order <= Dsp::Oversampler<FloatType>::maxOrder; ++order)
+                {
+                    oversampler.setOrder (order, filter);
+
+                    // up and down together, per base rate sample
+                    add ("oversampler", filter == Dsp::Oversampler<FloatType>::Filter::linearPhase ? "linearPhase" : "zeroLatency",
+                         order, measure (settings, blockSize, refresh, [&]
+                         {
+                             oversampler.processUp (0, data, blockSize);
+                             oversampler.processDown (0, data, blockSize);
+                         }));
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    /** Loads more and more stereo instances and reports what they cost, so the memory
+        that grows with the instance count can be told apart from the shared tables. */
+    Array<var> reportMemory (const Settings& settings)
+    {
+        Array<var> results;
+
+        for (auto numInstances : { 1, 10, 100 })
+        {
+            OwnedArray<InflationPluginAudioProcessor> processors;
+
+            for (auto i = 0; i < numInstances; ++i)
+                processors.add (new InflationPluginAudioProcessor())->prepareToPlay (settings.sampleRate, 512);
+
+            size_t instanceBytes = 0;
+
+            for (auto* processor : processors)
+                instanceBytes += processor->getMemoryReport().instanceBytes;
+
+            const auto report = processors.getFirst()->getMemoryReport();
+
+            auto* result = new DynamicObject();
+            result->setProperty ("instances", numInstances);
+            result->setProperty ("bytesPerInstance", (int64) (instanceBytes / (size_t) numInstances));
+            result->setProperty ("sharedBytes", (int64) report.sharedBytes);
+            result->setProperty ("sharedResources", report.numSharedResources);
+            result->setProperty ("totalBytes", (int64) (instanceBytes + report.sharedBytes));
+            results.add (var (result));
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    void runBenchmarks (const ArgumentList& args)
+    {
+        Settings settings;
+
+        if (args.containsOption ("--quick"))
+        {
+            settings.secondsPerRound = 0.01;
+            settings.numRounds = 3;
+            settings.blockSizes = { 16, 512, 4096 };
+        }
+
+        if (args.containsOption ("--oversampling"))
+            settings.oversamplingOrders = { 0, 1, 2, 3, 4 };
+
+        Array<var> processorResults, stageResults;
+
+        benchmarkProcessor<float> (settings, processorResults);
+        benchmarkProcessor<double> (settings, processorResults);
+        benchmarkProcessor<double> (settings, processorResults, true);
+        benchmarkStages<float> (settings, stageResults);
+        benchmarkStages<double> (settings, stageResults);
+
+        auto* report = new DynamicObject();
+        report->setProperty ("version", ProjectInfo::versionString);
+        report->setProperty ("isa", Dsp::getIsaName (Dsp::detectIsa()));
+        report->setProperty ("cpu", SystemStats::getCpuModel());
+        report->setProperty ("sampleRate", settings.sampleRate);
+        report->setProperty ("unit", "ns per sample per channel, best of " + String (settings.numRounds) + " rounds");
+        report->setProperty ("processor", processorResults);
+        report->setProperty ("stages", stageResults);
+        report->setProperty ("memory", reportMemory (settings));
+
+        const auto json = JSON::toString (var (report));
+
+        if (args.containsOption ("--output"))
+        {
+            const auto file = File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--output"));
+
+            if (! file.replaceWithText (json))
+                ConsoleApplication::fail ("can't write " + file.getFullPathName());
+        }
+        else
+        {
+            std::cout << json << std::endl;
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // the processor's parameter state expects a message manager to exist
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ConsoleApplication app;
+
+    app.addHelpCommand ("--help|-h", "Times Inflation's processing chain and prints JSON.", false);
+
+    app.addDefaultCommand ({ "",
+                             "[--output=<file>] [--quick] [--oversampling]",
+                             "Times the processor in every mode, and each DSP stage on its own.",
+                             "--quick runs fewer block sizes for a fast check.\n"
+                             "--oversampling also times the processor at every oversampling factor.",
+                             [] (const ArgumentList& args) { runBenchmarks (args); } });
+
+    app.addCommand ({ "--verify",
+                      "--verify [--golden=<file> | --write-golden=<file>] [--verbose]",
+                      "Checks the output of every mode and precision instead of timing it.",
+                      "Renders a fixed set of signals and compares them with a long double reference, across\n"
+                      "host block sizes and precisions, and with the golden renders built in, or those in <file>.\n"
+                      "--write-golden stores this build's renders in <file> in the same form.\n"
+                      "INFLATION_ISA=scalar|sse2|avx2 limits the instruction set the kernels use.",
+                      [] (const ArgumentList& args) { runVerification (args); } });
+
+    app.addCommand ({ "--soak",
+                      "--soak [--minutes=<n>] [--seed=<n>] [--verbose]",
+                      "Plays the processor like a badly behaved host for a while and watches the audio thread.",
+                      "Random block sizes, signals, automation and reconfigurations for <n> minutes (5 by default)\n"
+                      "while another thread saves state, switches presets and moves parameters. Fails if a block\n"
+                      "allocates, locks or puts out NaN or Inf. --verbose prints each scene as it starts.",
+                      [] (const ArgumentList& args) { runSoak (args); } });
+
+    return app.findAndRunCommand (argc, argv);
+}
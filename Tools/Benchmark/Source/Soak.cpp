@@ -0,0 +1,704 @@
+#include "Soak.h"
+#include "../../../Source/PluginProcessor.h"
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+//==============================================================================
+// what the audio thread does inside processBlock, counted by the hooks further down
+namespace {
+
+    thread_local bool watchingAllocations = false, watchingLocks = false;
+    std::atomic<int64> numAllocations { 0 }, numFrees { 0 }, numLocks { 0 };
+
+    struct AudioThreadWatch
+    {
+        explicit AudioThreadWatch (bool shouldWatchLocks) noexcept
+        {
+            watchingAllocations = true;
+            watchingLocks = shouldWatchLocks;
+        }
+
+        ~AudioThreadWatch()
+        {
+            watchingAllocations = false;
+            watchingLocks = false;
+        }
+    };
+}
+
+#if JUCE_LINUX
+// glibc's own entry points, so everything that allocates or locks is seen: C++ new, JUCE's
+// HeapBlock and every library, not only this program's code
+extern "C" {
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)
+    {
+        if (watchingAllocations)
+            ++numAllocations;
+
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t count, size_t size)
+    {
+        if (watchingAllocations)
+            ++numAllocations;
+
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* block, size_t size)
+    {
+        if (watchingAllocations)
+            ++numAllocations;
+
+        return __libc_realloc (block, size);
+    }
+
+    void* memalign (size_t alignment, size_t size)
+    {
+        if (watchingAllocations)
+            ++numAllocations;
+
+        return __libc_memalign (alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        return memalign (alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        *result = memalign (alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free (void* block)
+    {
+        if (watchingAllocations && block != nullptr)
+            ++numFrees;
+
+        __libc_free (block);
+    }
+
+    // glibc doesn't export its own name for this one, so the next definition is looked up once
+    // (a function-local static would take a lock of its own the first time)
+    using MutexLock = int (*) (pthread_mutex_t*);
+    static std::atomic<MutexLock> nextMutexLock { nullptr };
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        if (watchingLocks)
+            ++numLocks;
+
+        auto lock = nextMutexLock.load (std::memory_order_relaxed);
+
+        if (lock == nullptr)
+        {
+            lock = reinterpret_cast<MutexLock> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+            nextMutexLock.store (lock, std::memory_order_relaxed);
+        }
+
+        return lock (mutex);
+    }
+}
+#else
+// elsewhere only what goes through C++ new and delete is seen
+namespace {
+    void* allocate (size_t size)
+    {
+        if (watchingAllocations)
+            ++numAllocations;
+
+        if (auto* block = std::malloc (size == 0 ? 1 : size))
+            return block;
+
+        throw std::bad_alloc();
+    }
+
+    void release (void* block) noexcept
+    {
+        if (watchingAllocations && block != nullptr)
+            ++numFrees;
+
+        std::free (block);
+    }
+
+    // the block malloc returned is kept just before the aligned one
+    void* allocate (size_t size, std::align_val_t alignment)
+    {
+        const auto align = static_cast<size_t> (alignment);
+        auto* block = static_cast<char*> (allocate (size + align + sizeof (void*)));
+        auto* aligned = block + sizeof (void*);
+        aligned += (align - reinterpret_cast<uintptr_t> (aligned) % align) % align;
+        reinterpret_cast<void**> (aligned)[-1] = block;
+        return aligned;
+    }
+
+    void release (void* block, std::align_val_t) noexcept
+    {
+        if (block != nullptr)
+            release (static_cast<void**> (block)[-1]);
+    }
+
+    template <typename... Args>
+    void* allocateNoThrow (Args... args) noexcept
+    {
+        try { return allocate (args...); }
+        catch (...) { return nullptr; }
+    }
+}
+
+void* operator new (size_t size)                                                        { return allocate (size); }
+void* operator new[] (size_t size)                                                      { return allocate (size); }
+void* operator new (size_t size, const std::nothrow_t&) noexcept                        { return allocateNoThrow (size); }
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept                      { return allocateNoThrow (size); }
+void* operator new (size_t size, std::align_val_t alignment)                            { return allocate (size, alignment); }
+void* operator new[] (size_t size, std::align_val_t alignment)                          { return allocate (size, alignment); }
+void* operator new (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept    { return allocateNoThrow (size, alignment); }
+void* operator new[] (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept  { return allocateNoThrow (size, alignment); }
+
+void operator delete (void* block) noexcept                                             { release (block); }
+void operator delete[] (void* block) noexcept                                           { release (block); }
+void operator delete (void* block, size_t) noexcept                                     { release (block); }
+void operator delete[] (void* block, size_t) noexcept                                   { release (block); }
+void operator delete (void* block, const std::nothrow_t&) noexcept                      { release (block); }
+void operator delete[] (void* block, const std::nothrow_t&) noexcept                    { release (block); }
+void operator delete (void* block, std::align_val_t alignment) noexcept                 { release (block, alignment); }
+void operator delete[] (void* block, std::align_val_t alignment) noexcept               { release (block, alignment); }
+void operator delete (void* block, size_t, std::align_val_t alignment) noexcept         { release (block, alignment); }
+void operator delete[] (void* block, size_t, std::align_val_t alignment) noexcept       { release (block, alignment); }
+void operator delete (void* block, std::align_val_t alignment, const std::nothrow_t&) noexcept      { release (block, alignment); }
+void operator delete[] (void* block, std::align_val_t alignment, const std::nothrow_t&) noexcept    { release (block, alignment); }
+#endif
+
+namespace {
+
+    //==============================================================================
+    struct Layout
+    {
+        const char* name;
+        AudioChannelSet channels;
+        bool hasInput;
+    };
+
+    const Layout layouts[] = { { "mono",             AudioChannelSet::mono(),               true },
+                               { "stereo",           AudioChannelSet::stereo(),             true },
+                               { "5.1",              AudioChannelSet::create5point1(),      true },
+                               { "7.1",              AudioChannelSet::create7point1(),      true },
+                               { "16 channels",      AudioChannelSet::discreteChannels (16), true },
+                               { "stereo no input",  AudioChannelSet::stereo(),             false } };
+
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int hostBlockSizes[] = { 32, 64, 128, 256, 441, 480, 512, 1024, 2048, 4096 };
+
+    // oversize blocks go up to four times what prepareToPlay announced
+    constexpr int maxBlockSize = 4 * 4096;
+
+    enum class Precision { single, mixed, full };
+
+    /** What the host last told prepareToPlay, changed only while the audio is stopped. */
+    struct Configuration
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int layout = 1;
+        Precision precision = Precision::single;
+        bool rendering = false;
+
+        int getNumChannels() const noexcept     { return layouts[layout].channels.size(); }
+
+        String describe() const
+        {
+            return String (sampleRate, 0) + " Hz, blocks of " + String (blockSize) + ", " + layouts[layout].name + ", "
+                 + (precision == Precision::single ? "float" : (precision == Precision::mixed ? "mixed" : "double"))
+                 + (rendering ? ", rendering" : "");
+        }
+    };
+
+    //==============================================================================
+    enum class Blocks { fixed, varying, single, oversize };
+    enum class Signal { noise, sine, silence, overFullScale, denormal, nonFinite };
+    enum class Automation { none, continuous, everything };
+
+    /** A few seconds of one kind of host behaviour. */
+    struct Scene
+    {
+        Blocks blocks = Blocks::fixed;
+        Signal signal = Signal::noise;
+        Automation automation = Automation::none;
+        int64 numSamples = 0;
+        double level = 0.5, frequency = 440.0;
+
+        static Scene makeRandom (Random& random, double sampleRate)
+        {
+            Scene scene;
+            scene.blocks = static_cast<Blocks> (random.nextInt (4));
+            scene.signal = static_cast<Signal> (random.nextInt (6));
+            scene.automation = static_cast<Automation> (random.nextInt (3));
+            scene.level = std::pow (10.0, random.nextDouble() * 2.0 - 2.0);
+            scene.frequency = 20.0 * std::pow (1000.0, random.nextDouble());
+
+            // silence has to last long enough to put the processor to sleep, single sample blocks are slow
+            const auto seconds = scene.signal == Signal::silence ? 1.0 + random.nextDouble()
+                                                                 : (scene.blocks == Blocks::single ? 0.05 : 0.5 + 2.5 * random.nextDouble());
+            scene.numSamples = static_cast<int64> (seconds * sampleRate);
+            return scene;
+        }
+
+        String describe() const
+        {
+            static const char* blockNames[] { "fixed blocks", "varying blocks", "single samples", "oversize blocks" };
+            static const char* signalNames[] { "noise", "sine", "silence", "over full scale", "denormals", "NaN and Inf" };
+            static const char* automationNames[] { "", ", automating", ", automating everything" };
+
+            return String (blockNames[(int) blocks]) + " of " + signalNames[(int) signal] + automationNames[(int) automation];
+        }
+    };
+
+    //==============================================================================
+    struct Statistics
+    {
+        static constexpr int numBins = 201;     // 1% of the budget each, the last for 200% and more
+
+        int64 blocks = 0, renderedBlocks = 0, overBudget = 0, nonFinite = 0;
+        int64 allocations = 0, frees = 0, locks = 0, latencyLocks = 0;
+        double audioSeconds = 0.0, worstLoad = 0.0;
+        std::array<int64, numBins> histogram {};
+        String worstBlock, firstProblem;
+
+        // reconfigurations, with the audio stopped
+        int prepares = 0, sampleRates = 0, layoutChanges = 0, precisionChanges = 0, resets = 0, renders = 0;
+
+        void addLoad (double load, const String& block)
+        {
+            ++histogram[(size_t) jlimit (0, numBins - 1, (int) (load * 100.0))];
+
+            if (load > 1.0)
+                ++overBudget;
+
+            if (load > worstLoad)
+            {
+                worstLoad = load;
+                worstBlock = block;
+            }
+        }
+
+        void addProblem (const String& problem)
+        {
+            if (firstProblem.isEmpty())
+                firstProblem = problem;
+        }
+
+        double getPercentile (double fraction) const
+        {
+            const auto total = std::accumulate (histogram.begin(), histogram.end(), int64 (0));
+            auto count = int64 (0);
+
+            for (auto bin = 0; bin < numBins; ++bin)
+                if ((count += histogram[(size_t) bin]) >= (int64) std::ceil (fraction * (double) total))
+                    return (bin + 1) / 100.0;
+
+            return 0.0;
+        }
+
+        bool failed() const noexcept    { return allocations + frees + locks + nonFinite > 0; }
+    };
+
+    //==============================================================================
+    /** The host's message thread: everything a host or an editor does while blocks run. */
+    class HostThread : public Thread
+    {
+    public:
+        HostThread (InflationPluginAudioProcessor& p, CriticalSection& lock, int64 seed)
+            : Thread ("Inflation soak host"), processor (p), hostLock (lock), random (seed) {}
+
+        ~HostThread() override
+        {
+            stopThread (1000);
+            setEditorOpen (false);
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                {
+                    // the audio side holds this while it reconfigures, as a host serialises those on its message thread
+                    const ScopedLock sl (hostLock);
+                    doSomething();
+                }
+
+                wait (random.nextInt ({ 1, 20 }));
+            }
+        }
+
+        int stateRoundTrips = 0, presets = 0, comparisons = 0, editorToggles = 0, parameterStorms = 0;
+
+    private:
+        void doSomething()
+        {
+            switch (random.nextInt (5))
+            {
+                case 0:
+                {
+                    MemoryBlock data;
+                    processor.getStateInformation (data);
+                    processor.setStateInformation (data.getData(), (int) data.getSize());
+                    ++stateRoundTrips;
+                    break;
+                }
+
+                case 1:
+                    processor.setCurrentProgram (random.nextInt (processor.getNumPrograms()));
+                    ++presets;
+                    break;
+
+                case 2:
+                    processor.selectComparisonSlot (1 - processor.getComparisonSlot());
+                    ++comparisons;
+                    break;
+
+                case 3:
+                    setEditorOpen (! editorOpen);
+                    ++editorToggles;
+                    break;
+
+                default:
+                    for (auto* id : Dsp::parameterIds)
+                        processor.state.getParameter (id)->setValueNotifyingHost (random.nextFloat());
+
+                    ++parameterStorms;
+                    break;
+            }
+        }
+
+        // an open editor starts the analyzer, which the audio thread then feeds
+        void setEditorOpen (bool shouldBeOpen)
+        {
+            if (shouldBeOpen == editorOpen)
+                return;
+
+            editorOpen = shouldBeOpen;
+
+            if (editorOpen)
+                processor.getAnalyzer().addViewer();
+            else
+                processor.getAnalyzer().removeViewer();
+        }
+
+        InflationPluginAudioProcessor& processor;
+        CriticalSection& hostLock;
+        Random random;
+        bool editorOpen = false;
+    };
+
+    //==============================================================================
+    class Soak
+    {
+    public:
+        Soak (int64 seed, bool shouldPrintScenes)
+            : random (seed), host (processor, hostLock, seed + 1), printScenes (shouldPrintScenes),
+              floatStorage (Dsp::maxChannels, maxBlockSize), doubleStorage (Dsp::maxChannels, maxBlockSize)
+        {
+            floatStorage.clear();
+            doubleStorage.clear();
+            reconfigure();
+        }
+
+        void run (double minutes)
+        {
+            host.startThread();
+
+            const auto start = Time::getMillisecondCounterHiRes();
+            auto nextReport = 60000.0;
+
+            while (Time::getMillisecondCounterHiRes() - start < minutes * 60000.0)
+            {
+                playScene (Scene::makeRandom (random, configuration.sampleRate));
+                changeConfiguration();
+
+                if (Time::getMillisecondCounterHiRes() - start >= nextReport)
+                {
+                    std::cout << String (nextReport / 60000.0, 0) << " min: " << statistics.blocks << " blocks, worst load "
+                              << String (statistics.worstLoad * 100.0, 1) << "%, " << statistics.allocations << " allocations, "
+                              << statistics.locks << " locks" << std::endl;
+                    nextReport += 60000.0;
+                }
+            }
+
+            host.stopThread (1000);
+        }
+
+        void printSummary() const
+        {
+            const auto& s = statistics;
+
+            std::cout << "blocks            " << s.blocks << " (" << String (s.audioSeconds / 3600.0, 2) << " hours of audio, "
+                      << s.renderedBlocks << " of them rendering)" << std::endl
+                      << "audio stopped     " << s.prepares << " prepares: " << s.sampleRates << " sample rates, "
+                      << s.layoutChanges << " layouts, " << s.precisionChanges << " precisions, " << s.renders << " renders; "
+                      << s.resets << " resets" << std::endl
+                      << "message thread    " << host.stateRoundTrips << " state round trips, " << host.presets << " presets, "
+                      << host.comparisons << " A/B switches, " << host.editorToggles << " editors opened or closed, "
+                      << host.parameterStorms << " parameter storms" << std::endl
+                      << "block load        median " << String (s.getPercentile (0.5) * 100.0, 0) << "%, 99% "
+                      << String (s.getPercentile (0.99) * 100.0, 0) << "%, 99.9% " << String (s.getPercentile (0.999) * 100.0, 0)
+                      << "%, worst " << String (s.worstLoad * 100.0, 1) << "% (" << s.worstBlock << ")" << std::endl
+                      << "over budget       " << s.overBudget << " blocks" << std::endl
+                      << "allocations       " << s.allocations << ", frees " << s.frees << std::endl
+                     #if JUCE_LINUX
+                      << "locks             " << s.locks << " (and " << s.latencyLocks
+                      << " in blocks that changed the latency, which JUCE reports to the host under a lock)" << std::endl
+                     #else
+                      << "locks             not watched on this platform" << std::endl
+                     #endif
+                      << "non-finite output " << s.nonFinite << " blocks" << std::endl;
+
+            if (s.firstProblem.isNotEmpty())
+                std::cout << "first problem     " << s.firstProblem << std::endl;
+        }
+
+        bool failed() const noexcept    { return statistics.failed(); }
+
+    private:
+        //==============================================================================
+        void playScene (const Scene& scene)
+        {
+            if (printScenes)
+                std::cout << scene.describe() << ", " << configuration.describe() << std::endl;
+
+            for (int64 played = 0; played < scene.numSamples;)
+            {
+                const auto numSamples = (int) jmin ((int64) getBlockSize (scene.blocks), scene.numSamples - played);
+
+                if (scene.automation != Automation::none)
+                    automate (scene.automation == Automation::everything);
+
+                if (configuration.precision == Precision::single)
+                    playBlock (floatStorage, scene, played, numSamples);
+                else
+                    playBlock (doubleStorage, scene, played, numSamples);
+
+                played += numSamples;
+            }
+        }
+
+        int getBlockSize (Blocks blocks)
+        {
+            const auto announced = configuration.blockSize;
+
+            switch (blocks)
+            {
+                case Blocks::varying:   return random.nextInt ({ 1, announced + 1 });
+                case Blocks::single:    return 1;
+                case Blocks::oversize:  return random.nextInt ({ announced, 4 * announced + 1 });
+                case Blocks::fixed:
+                default:                return announced;
+            }
+        }
+
+        // what a plug-in wrapper does with the host's automation just before each block
+        void automate (bool everything)
+        {
+            for (auto i = 0; i < Dsp::numParameters; ++i)
+            {
+                auto* parameter = processor.state.getParameter (Dsp::parameterIds[i]);
+
+                if (everything || dynamic_cast<AudioParameterFloat*> (parameter) != nullptr)
+                    parameter->setValueNotifyingHost (random.nextFloat());
+            }
+        }
+
+        template <typename FloatType>
+        void playBlock (AudioBuffer<FloatType>& storage, const Scene& scene, int64 position, int numSamples)
+        {
+            // refers to the storage, so the block itself allocates nothing
+            AudioBuffer<FloatType> block (storage.getArrayOfWritePointers(), configuration.getNumChannels(), numSamples);
+            fill (block, scene, position);
+
+            MidiBuffer midi;
+            const auto latency = processor.getLatencySamples();
+            const auto allocations = numAllocations.load(), frees = numFrees.load(), locks = numLocks.load();
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            {
+                const AudioThreadWatch watch (! configuration.rendering);
+                processor.processBlock (block, midi);
+            }
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            const auto describe = [&] { return String (numSamples) + " samples of " + scene.describe() + ", " + configuration.describe(); };
+
+            ++statistics.blocks;
+            statistics.audioSeconds += numSamples / configuration.sampleRate;
+
+            // a render has no budget to keep
+            if (configuration.rendering)
+                ++statistics.renderedBlocks;
+            else
+                statistics.addLoad (seconds * configuration.sampleRate / numSamples, describe());
+
+            const auto newAllocations = numAllocations.load() - allocations, newFrees = numFrees.load() - frees;
+            const auto newLocks = numLocks.load() - locks;
+
+            statistics.allocations += newAllocations;
+            statistics.frees += newFrees;
+
+            if (newAllocations + newFrees > 0)
+                statistics.addProblem ("allocated in a block of " + describe());
+
+            if (processor.getLatencySamples() != latency)
+            {
+                statistics.latencyLocks += newLocks;
+            }
+            else if (newLocks > 0)
+            {
+                statistics.locks += newLocks;
+                statistics.addProblem ("locked in a block of " + describe());
+            }
+
+            for (auto channel = 0; channel < block.getNumChannels(); ++channel)
+            {
+                const auto* samples = block.getReadPointer (channel);
+
+                if (! std::all_of (samples, samples + numSamples, [] (FloatType x) { return std::isfinite (x); }))
+                {
+                    ++statistics.nonFinite;
+                    statistics.addProblem ("non-finite output from a block of " + describe());
+                    break;
+                }
+            }
+        }
+
+        template <typename FloatType>
+        void fill (AudioBuffer<FloatType>& block, const Scene& scene, int64 position)
+        {
+            const auto numSamples = block.getNumSamples();
+            const auto twoPi = MathConstants<double>::twoPi;
+
+            for (auto channel = 0; channel < block.getNumChannels(); ++channel)
+            {
+                auto* samples = block.getWritePointer (channel);
+
+                for (auto i = 0; i < numSamples; ++i)
+                {
+                    const auto noise = random.nextDouble() * 2.0 - 1.0;
+
+                    switch (scene.signal)
+                    {
+                        case Signal::sine:
+                            samples[i] = (FloatType) (scene.level * std::sin (twoPi * scene.frequency * (double) (position + i) / configuration.sampleRate + channel));
+                            break;
+                        case Signal::silence:       samples[i] = 0; break;
+                        case Signal::overFullScale: samples[i] = (FloatType) (8.0 * noise); break;
+                        case Signal::denormal:      samples[i] = std::numeric_limits<FloatType>::denorm_min() * (FloatType) (noise * 100.0); break;
+                        case Signal::noise:
+                        case Signal::nonFinite:
+                        default:                    samples[i] = (FloatType) (scene.level * noise); break;
+                    }
+                }
+            }
+
+            // one sample of NaN and one of Inf at the start of the scene, the rest stays clean
+            if (scene.signal == Signal::nonFinite && position == 0 && numSamples > 0)
+            {
+                block.setSample (0, random.nextInt (numSamples), std::numeric_limits<FloatType>::quiet_NaN());
+                block.setSample (block.getNumChannels() - 1, random.nextInt (numSamples), std::numeric_limits<FloatType>::infinity());
+            }
+        }
+
+        //==============================================================================
+        void changeConfiguration()
+        {
+            switch (random.nextInt (9))
+            {
+                case 0:     configuration.sampleRate = sampleRates[random.nextInt ((int) std::size (sampleRates))]; ++statistics.sampleRates; break;
+                case 1:     configuration.layout = random.nextInt ((int) std::size (layouts)); ++statistics.layoutChanges; break;
+                case 2:     configuration.precision = static_cast<Precision> (random.nextInt (3)); ++statistics.precisionChanges; break;
+                case 3:     configuration.rendering = ! configuration.rendering; ++statistics.renders; break;
+                case 4:     configuration.blockSize = hostBlockSizes[random.nextInt ((int) std::size (hostBlockSizes))]; break;
+                case 5:     break;      // prepareToPlay again with nothing changed
+
+                case 6:
+                    // some hosts go offline and back without preparing again
+                    configuration.rendering = ! configuration.rendering;
+                    processor.setNonRealtime (configuration.rendering);
+                    ++statistics.renders;
+                    return;
+
+                default:
+                    // hosts call reset() from the audio thread too, so it's watched like a block
+                    {
+                        const AudioThreadWatch watch (! configuration.rendering);
+                        processor.reset();
+                    }
+
+                    ++statistics.resets;
+                    return;
+            }
+
+            reconfigure();
+        }
+
+        void reconfigure()
+        {
+            const ScopedLock sl (hostLock);
+            const auto& layout = layouts[configuration.layout];
+
+            processor.releaseResources();
+
+            AudioProcessor::BusesLayout buses;
+            buses.inputBuses.add (layout.hasInput ? layout.channels : AudioChannelSet::disabled());
+            buses.outputBuses.add (layout.channels);
+
+            if (! processor.setBusesLayout (buses))
+                ConsoleApplication::fail ("the processor refused the " + String (layout.name) + " layout");
+
+            processor.setNonRealtime (configuration.rendering);
+            processor.setMixedPrecision (configuration.precision == Precision::mixed);
+            processor.setProcessingPrecision (configuration.precision == Precision::single ? AudioProcessor::singlePrecision
+                                                                                           : AudioProcessor::doublePrecision);
+            processor.prepareToPlay (configuration.sampleRate, configuration.blockSize);
+            ++statistics.prepares;
+        }
+
+        //==============================================================================
+        InflationPluginAudioProcessor processor;
+        CriticalSection hostLock;
+        Random random;
+        HostThread host;
+        const bool printScenes;
+
+        Configuration configuration;
+        Statistics statistics;
+        AudioBuffer<float> floatStorage;
+        AudioBuffer<double> doubleStorage;
+    };
+}
+
+//==============================================================================
+void runSoak (const ArgumentList& args)
+{
+    const auto minutes = args.containsOption ("--minutes") ? args.getValueForOption ("--minutes").getDoubleValue() : 5.0;
+    const auto seed = args.containsOption ("--seed") ? args.getValueForOption ("--seed").getLargeIntValue() : Time::currentTimeMillis();
+
+    // the seed repeats the audio thread's scenes, the message thread's timing can't be repeated
+    std::cout << "soak for " << String (minutes, 1) << " minutes, seed " << seed << std::endl;
+
+    Soak soak (seed, args.containsOption ("--verbose"));
+    soak.run (minutes);
+    soak.printSummary();
+
+    if (soak.failed())
+        ConsoleApplication::fail ("soak failed");
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*  Drives the processor the way badly behaved hosts do, for InflationBenchmark --soak.
+
+    For as long as it's given, the audio thread plays random scenes back to back, each
+    a few seconds of:
+
+        blocks      one size throughout, a new size every block, single samples, or
+                    blocks larger than prepareToPlay announced
+        signal      noise, sines, silence long enough to sleep, bursts far over full
+                    scale, denormals, and now and then a block of NaN or Inf
+        automation  none, the continuous parameters, or every parameter moved to a
+                    random value before each block
+
+    and between scenes it does what hosts do with the audio stopped: prepareToPlay
+    again with the same or another sample rate and block size, another channel layout
+    (mono to 16 channels, or no input at all), another precision, reset(), or a bounce.
+
+    Meanwhile a second thread acts as the message thread: it saves and restores the
+    state, switches presets and A/B slots, opens and closes the analyzer, and sets
+    every parameter at once, all while blocks are running.
+
+    Each processBlock is timed against its real-time budget, and watched for heap
+    allocations and, on Linux, for mutexes being locked (JUCE's CriticalSection and
+    std::mutex both lock one). The output has to stay finite. Prints a summary, and
+    fails the command, so it exits non-zero, if anything allocated, locked or came out
+    non-finite. Going over the budget is reported but doesn't fail, as it depends on
+    the machine and whatever else it runs.
+
+    Two kinds of lock are counted apart and don't fail: a block that changed the latency
+    tells the host through setLatencySamples(), which takes JUCE's listener lock, and a
+    bounce isn't watched for locks at all, as its worker threads are woken through events.
+*/
+void runSoak (const ArgumentList& args);
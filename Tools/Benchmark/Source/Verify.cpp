@@ -0,0 +1,502 @@
+#include "Verify.h"
+#include "../../../Source/PluginProcessor.h"
+
+namespace {
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+    constexpr int corpusLength = 24000;         // half a second per signal
+
+    //==============================================================================
+    struct Signal
+    {
+        String name;
+        AudioBuffer<double> samples;
+    };
+
+    // the channels differ, so a channel mix up can't go unnoticed; nothing is silent for
+    // long enough to put the processor to sleep
+    std::vector<Signal> makeCorpus()
+    {
+        std::vector<Signal> corpus;
+        const auto twoPi = MathConstants<double>::twoPi;
+
+        auto add = [&corpus] (const char* name, auto&& sample)
+        {
+            AudioBuffer<double> buffer (numChannels, corpusLength);
+
+            for (auto channel = 0; channel < numChannels; ++channel)
+                for (auto i = 0; i < corpusLength; ++i)
+                    buffer.setSample (channel, i, sample (channel, i));
+
+            corpus.push_back ({ name, std::move (buffer) });
+        };
+
+        add ("sine1k", [&] (int channel, int i) { return 0.5 * std::sin (twoPi * 1000.0 * i / sampleRate + channel * 0.5); });
+        add ("sine100FullScale", [&] (int channel, int i) { return std::sin (twoPi * 100.0 * i / sampleRate + channel * 0.5); });
+
+        // exponential, 20 Hz to 20 kHz
+        add ("sweep", [&] (int channel, int i)
+        {
+            const auto k = std::log (1000.0), duration = corpusLength / sampleRate, t = i / sampleRate;
+            return (channel == 0 ? 0.7 : -0.7) * std::sin (twoPi * 20.0 * duration / k * (std::exp (k * t / duration) - 1.0));
+        });
+
+        Random random (3);
+        add ("noise", [&] (int, int) { return (random.nextDouble() * 2.0 - 1.0) * 0.25; });
+
+        // a decaying 3 kHz burst every 50 ms
+        add ("transients", [&] (int channel, int i)
+        {
+            const auto position = (i + channel * 100) % 2400;
+            return 0.9 * std::exp (-position / 240.0) * std::sin (twoPi * 3000.0 * position / sampleRate);
+        });
+
+        add ("dc", [] (int channel, int) { return channel == 0 ? 0.5 : -0.25; });
+        add ("squareFullScale", [] (int channel, int i) { return ((i + channel * 12) / 24) % 2 == 0 ? 1.0 : -1.0; });
+        add ("sineOverFullScale", [&] (int channel, int i) { return 2.0 * std::sin (twoPi * 440.0 * i / sampleRate + channel); });
+
+        return corpus;
+    }
+
+    //==============================================================================
+    struct Case
+    {
+        const char* name;
+        Dsp::ParameterSnapshot parameters;
+
+        // no filter anywhere, so each output sample depends on its input sample only
+        bool isMemoryless() const noexcept
+        {
+            return parameters.oversampling == 0 && ! parameters.bandSplit && parameters.truePeakLimit == 0 && ! parameters.adaa
+                    && parameters.renderQuality == 0 && ! parameters.autoOutput;
+        }
+    };
+
+    std::vector<Case> makeCases()
+    {
+        auto with = [] (auto&& change)
+        {
+            Dsp::ParameterSnapshot parameters;
+            change (parameters);
+            return parameters;
+        };
+
+        return { { "plain",          with ([] (auto& p) { p.zeroClip = false; }) },
+                 { "zeroClip",       with ([] (auto&) {}) },
+                 { "curveMinus50",   with ([] (auto& p) { p.curve = -50.0f; }) },
+                 { "curvePlus50",    with ([] (auto& p) { p.curve = 50.0f; }) },
+                 { "gainsAndMix",    with ([] (auto& p) { p.preGain = 3.0f; p.postGain = -4.5f; p.mix = 0.5f; p.curve = 20.0f; }) },
+                 { "bandSplit",      with ([] (auto& p) { p.bandSplit = true; p.curve = 20.0f; }) },
+                 { "oversampling2x", with ([] (auto& p) { p.oversampling = 1; }) },
+                 { "oversampling16x", with ([] (auto& p) { p.oversampling = 4; p.zeroClip = false; }) },
+                 { "zeroLatency4x",  with ([] (auto& p) { p.oversampling = 2; p.oversamplingFilter = 1; }) },
+                 { "bandSplit4xMix", with ([] (auto& p) { p.bandSplit = true; p.oversampling = 2; p.mix = 0.7f; }) },
+                 { "twoBands",       with ([] (auto& p) { p.bandSplit = true; p.numBands = 2; p.crossovers[0] = 600.0f; p.bandCurves[1] = -30.0f; }) },
+                 { "sixBands",       with ([] (auto& p) { p.bandSplit = true; p.numBands = 6; p.crossovers = { 100.0f, 500.0f, 2000.0f, 6000.0f, 14000.0f };
+                                                          p.bandCurves = { 30.0f, -20.0f, 0.0f, 10.0f, 40.0f, -50.0f }; p.bandClips[4] = false; }) },
+                 { "adaa",           with ([] (auto& p) { p.adaa = true; p.curve = 30.0f; p.mix = 0.8f; }) },
+                 { "adaaNoClip",     with ([] (auto& p) { p.adaa = true; p.zeroClip = false; p.curve = -30.0f; }) },
+                 { "adaaBandSplit2x", with ([] (auto& p) { p.adaa = true; p.bandSplit = true; p.oversampling = 1; p.bandClips[0] = false; }) },
+                 { "limiter",        with ([] (auto& p) { p.preGain = 6.0f; p.truePeakLimit = 3; }) },
+                 { "renderBest",     with ([] (auto& p) { p.renderQuality = 1; p.curve = 20.0f; p.mix = 0.6f; }) } };
+    }
+
+    enum class Precision { single, mixed, full };
+
+    const char* getName (Precision precision)
+    {
+        return precision == Precision::single ? "float" : (precision == Precision::mixed ? "mixed" : "double");
+    }
+
+    // what one rounding step costs at the precision the chain computes in
+    double getEpsilon (Precision precision)
+    {
+        return precision == Precision::full ? std::numeric_limits<double>::epsilon()
+                                            : (double) std::numeric_limits<float>::epsilon();
+    }
+
+    //==============================================================================
+    // host blocks cycle through blockSizes until the signal is used up
+    template <typename FloatType>
+    void processInBlocks (InflationPluginAudioProcessor& processor, AudioBuffer<FloatType>& buffer, const std::vector<int>& blockSizes)
+    {
+        MidiBuffer midi;
+        size_t next = 0;
+
+        for (auto start = 0; start < buffer.getNumSamples();)
+        {
+            const auto length = jmin (blockSizes[next++ % blockSizes.size()], buffer.getNumSamples() - start);
+            AudioBuffer<FloatType> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, length);
+            processor.processBlock (block, midi);
+            start += length;
+        }
+    }
+
+    AudioBuffer<double> render (const AudioBuffer<double>& input, const Case& testCase, Precision precision,
+                                const std::vector<int>& blockSizes)
+    {
+        InflationPluginAudioProcessor processor;
+        const auto values = testCase.parameters.toRawValues();
+
+        for (auto i = 0; i < Dsp::numParameters; ++i)
+        {
+            auto* parameter = processor.state.getParameter (Dsp::parameterIds[i]);
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (values[(size_t) i]));
+        }
+
+        processor.setNonRealtime (true);
+        processor.setMixedPrecision (precision == Precision::mixed);
+        processor.setProcessingPrecision (precision == Precision::single ? AudioProcessor::singlePrecision
+                                                                         : AudioProcessor::doublePrecision);
+        processor.prepareToPlay (sampleRate, *std::max_element (blockSizes.begin(), blockSizes.end()));
+
+        AudioBuffer<double> output;
+        output.makeCopyOf (input);
+
+        if (precision == Precision::single)
+        {
+            AudioBuffer<float> samples;
+            samples.makeCopyOf (output);
+            processInBlocks (processor, samples, blockSizes);
+            output.makeCopyOf (samples);
+        }
+        else
+        {
+            processInBlocks (processor, output, blockSizes);
+        }
+
+        return output;
+    }
+
+    // the shaping as it was first written, clip, then A⋅x + B⋅x² + C⋅x³ - D⋅(x² - 2⋅x³ + x⁴)
+    // with pow, here in long double around the gains and the mix
+    AudioBuffer<double> renderReference (const AudioBuffer<double>& input, const Dsp::ParameterSnapshot& parameters)
+    {
+        using Real = long double;
+
+        const Real curve = parameters.curve;
+        const auto a = 1.0L + (curve + 50.0L) / 100.0L;
+        const auto b = -curve / 50.0L;
+        const auto c = (curve - 50.0L) / 100.0L;
+        const auto d = 1.0L / 16.0L - curve / 400.0L + curve * curve / 40000.0L;
+
+        const auto preGain = std::pow (10.0L, (Real) parameters.preGain / 20.0L);
+        const auto postGain = std::pow (10.0L, (Real) parameters.postGain / 20.0L);
+        const Real mix = parameters.mix;
+
+        AudioBuffer<double> output (input.getNumChannels(), input.getNumSamples());
+
+        for (auto channel = 0; channel < input.getNumChannels(); ++channel)
+        {
+            for (auto i = 0; i < input.getNumSamples(); ++i)
+            {
+                const auto dry = preGain * (Real) input.getSample (channel, i);
+                const auto x = parameters.zeroClip ? jlimit (-1.0L, 1.0L, dry) : dry;
+                const auto wet = a * x + b * std::pow (x, 2) + c * std::pow (x, 3)
+                                  - d * (std::pow (x, 2) - 2 * std::pow (x, 3) + std::pow (x, 4));
+
+                output.setSample (channel, i, (double) (postGain * (mix * wet + (1.0L - mix) * dry)));
+            }
+        }
+
+        return output;
+    }
+
+    //==============================================================================
+    struct Difference
+    {
+        double maxUlps = 0.0;               // in rounding steps at the reference's peak, since the polynomial
+                                            // cancels towards zero where its terms are large
+        double errorDecibels = -400.0;      // the error's energy over the reference's
+    };
+
+    Difference compare (const AudioBuffer<double>& actual, const AudioBuffer<double>& reference, double epsilon)
+    {
+        Difference difference;
+        double peak = 1.0 / 1024.0, maxError = 0.0, errorEnergy = 0.0, referenceEnergy = 0.0;
+
+        for (auto channel = 0; channel < reference.getNumChannels(); ++channel)
+        {
+            for (auto i = 0; i < reference.getNumSamples(); ++i)
+            {
+                const auto expected = reference.getSample (channel, i);
+                const auto error = std::abs (actual.getSample (channel, i) - expected);
+
+                // NaN compares false, so this keeps it
+                maxError = error <= maxError ? maxError : error;
+                peak = jmax (peak, std::abs (expected));
+                errorEnergy += error * error;
+                referenceEnergy += expected * expected;
+            }
+        }
+
+        difference.maxUlps = std::isfinite (maxError) ? maxError / (epsilon * peak) : std::numeric_limits<double>::infinity();
+
+        if (errorEnergy > 0.0)
+            difference.errorDecibels = std::isfinite (errorEnergy) ? 10.0 * std::log10 (errorEnergy / jmax (referenceEnergy, 1.0e-30)) : 0.0;
+
+        return difference;
+    }
+
+    //==============================================================================
+    /*  Golden renders are kept as a summary of the double precision output rather than every
+        sample, so all of them fit in Golden.bin (1.3 KB per case and signal, where the samples
+        would take 384 KB): for each channel and every 25 ms, the mean, the RMS and
+        two samples. The file is one record per case and signal, its name, the number of
+        channels and of values, then the values as little endian doubles.
+    */
+    constexpr int goldenBlockLength = 1200;
+    constexpr int goldenValuesPerBlock = 4;
+
+    AudioBuffer<double> summarise (const AudioBuffer<double>& samples)
+    {
+        const auto numBlocks = samples.getNumSamples() / goldenBlockLength;
+        AudioBuffer<double> summary (samples.getNumChannels(), numBlocks * goldenValuesPerBlock);
+
+        for (auto channel = 0; channel < samples.getNumChannels(); ++channel)
+        {
+            for (auto block = 0; block < numBlocks; ++block)
+            {
+                const auto* data = samples.getReadPointer (channel, block * goldenBlockLength);
+                auto* values = summary.getWritePointer (channel, block * goldenValuesPerBlock);
+                double sum = 0.0, squares = 0.0;
+
+                for (auto i = 0; i < goldenBlockLength; ++i)
+                {
+                    sum += data[i];
+                    squares += data[i] * data[i];
+                }
+
+                values[0] = sum / goldenBlockLength;
+                values[1] = std::sqrt (squares / goldenBlockLength);
+                values[2] = data[397];
+                values[3] = data[911];
+            }
+        }
+
+        return summary;
+    }
+
+    using Goldens = std::map<String, AudioBuffer<double>>;
+
+    String getGoldenName (const Case& testCase, const Signal& signal)
+    {
+        return String (testCase.name) + "." + signal.name;
+    }
+
+    bool writeGoldens (const File& file, const Goldens& goldens)
+    {
+        file.deleteFile();
+        FileOutputStream stream (file);
+
+        if (! stream.openedOk())
+            return false;
+
+        for (auto& [name, summary] : goldens)
+        {
+            stream.writeString (name);
+            stream.writeInt (summary.getNumChannels());
+            stream.writeInt (summary.getNumSamples());
+
+            for (auto channel = 0; channel < summary.getNumChannels(); ++channel)
+                for (auto i = 0; i < summary.getNumSamples(); ++i)
+                    stream.writeDouble (summary.getSample (channel, i));
+        }
+
+        return stream.getStatus().wasOk();
+    }
+
+    // stops at the first record that doesn't fit, whose case then has no golden
+    Goldens readGoldens (const void* data, size_t size)
+    {
+        Goldens goldens;
+        MemoryInputStream stream (data, size, false);
+
+        while (! stream.isExhausted())
+        {
+            const auto name = stream.readString();
+            const auto channels = stream.readInt(), length = stream.readInt();
+
+            if (channels <= 0 || length <= 0 || stream.getNumBytesRemaining() < (int64) channels * length * 8)
+                break;
+
+            AudioBuffer<double> summary (channels, length);
+
+            for (auto channel = 0; channel < channels; ++channel)
+                for (auto i = 0; i < length; ++i)
+                    summary.setSample (channel, i, stream.readDouble());
+
+            goldens[name] = std::move (summary);
+        }
+
+        return goldens;
+    }
+
+    //==============================================================================
+    class Checks
+    {
+    public:
+        explicit Checks (bool shouldPrintAll) : printAll (shouldPrintAll) {}
+
+        void add (const String& check, const String& subject, bool passed, const String& detail)
+        {
+            ++numChecks;
+
+            if (! passed)
+                ++numFailed;
+
+            if (printAll || ! passed)
+                std::cout << (passed ? "ok    " : "FAIL  ") << check.paddedRight (' ', 10) << subject.paddedRight (' ', 44) << detail << std::endl;
+        }
+
+        void addUlps (const String& check, const String& subject, const Difference& difference, double tolerance)
+        {
+            add (check, subject, difference.maxUlps <= tolerance,
+                 String (difference.maxUlps, 1) + " ulp (at most " + String (tolerance, 0) + ")");
+        }
+
+        void addDecibels (const String& check, const String& subject, const Difference& difference, double tolerance)
+        {
+            add (check, subject, difference.errorDecibels <= tolerance,
+                 String (difference.errorDecibels, 1) + " dB error (at most " + String (tolerance, 0) + ")");
+        }
+
+        int numChecks = 0, numFailed = 0;
+
+    private:
+        const bool printAll;
+    };
+
+    // tolerances: the worst seen on scalar, SSE2, AVX2 and AVX-512 kernels, with room on top
+    constexpr double referenceUlps = 16.0;      // vs. the long double polynomial (worst 4.2)
+    constexpr double kernelUlps = 8.0;          // vector kernels vs. the plain loop, FMA rounds differently (3.0)
+    constexpr double blockUlps = 8.0;           // other host blocks, only the scalar tails move (2.8)
+    constexpr double floatDecibels = -96.0;     // float and mixed precision vs. double (-106)
+    constexpr double goldenDecibels = -200.0;   // double vs. the scalar kernels' golden on other instruction sets (-300)
+    constexpr double baselineDecibels = -130.0; // double vs. the release before the optimisations, whose gains and
+                                                // coefficients were float (-153)
+
+    //==============================================================================
+    void checkKernels (const std::vector<Signal>& corpus, Checks& checks)
+    {
+        for (auto& signal : corpus)
+        {
+            for (auto curve : { -50.0, 0.0, 20.0, 50.0 })
+            {
+                AudioBuffer<double> vector (signal.samples), plain (signal.samples);
+                const auto subject = signal.name + " curve " + String (curve, 0);
+
+                const auto doubles = Dsp::ShaperCoefficients<double>::fromCurve (curve);
+                Dsp::Pipeline::processNonLinear (vector.getWritePointer (0), corpusLength, doubles, { 0, 0, 0, 0 }, false, false);
+                shapeReference (plain.getWritePointer (0), corpusLength, doubles);
+                checks.addUlps ("kernels", subject + " double", compare (vector, plain, getEpsilon (Precision::full)), kernelUlps);
+
+                AudioBuffer<float> vectorFloat, plainFloat;
+                vectorFloat.makeCopyOf (signal.samples);
+                plainFloat.makeCopyOf (signal.samples);
+
+                const auto floats = Dsp::ShaperCoefficients<float>::fromCurve (curve);
+                Dsp::Pipeline::processNonLinear (vectorFloat.getWritePointer (0), corpusLength, floats, { 0, 0, 0, 0 }, false, false);
+                shapeReference (plainFloat.getWritePointer (0), corpusLength, floats);
+                vector.makeCopyOf (vectorFloat);
+                plain.makeCopyOf (plainFloat);
+                checks.addUlps ("kernels", subject + " float", compare (vector, plain, getEpsilon (Precision::single)), kernelUlps);
+            }
+        }
+    }
+
+    // goldens is null while new ones are being written
+    void checkRenders (const std::vector<Signal>& corpus, const Goldens* goldens, Goldens& summaries, Checks& checks)
+    {
+        // one block for everything, then blocks that straddle every sub-block boundary
+        const std::vector<int> wholeSignal { corpusLength };
+        const std::vector<std::vector<int>> otherBlockSizes { { 64 }, { 1, 7, 300, 2048, 5, 511 } };
+
+        for (auto& testCase : makeCases())
+        {
+            for (auto& signal : corpus)
+            {
+                const auto subject = String (testCase.name) + " " + signal.name;
+                const auto reference = testCase.isMemoryless() ? renderReference (signal.samples, testCase.parameters) : AudioBuffer<double>();
+                AudioBuffer<double> full;
+
+                for (auto precision : { Precision::full, Precision::single, Precision::mixed })
+                {
+                    const auto rendered = render (signal.samples, testCase, precision, wholeSignal);
+                    const auto precisionSubject = subject + " " + getName (precision);
+
+                    if (testCase.isMemoryless())
+                        checks.addUlps ("reference", precisionSubject, compare (rendered, reference, getEpsilon (precision)), referenceUlps);
+
+                    for (auto& blockSizes : otherBlockSizes)
+                    {
+                        checks.addUlps ("blocks", precisionSubject + (blockSizes.size() == 1 ? " 64" : " varied"),
+                                        compare (render (signal.samples, testCase, precision, blockSizes), rendered, getEpsilon (precision)),
+                                        blockUlps);
+                    }
+
+                    if (precision == Precision::full)
+                        full = rendered;
+                    else
+                        checks.addDecibels ("precision", precisionSubject, compare (rendered, full, getEpsilon (precision)), floatDecibels);
+                }
+
+                const auto name = getGoldenName (testCase, signal);
+                summaries[name] = summarise (full);
+
+                if (goldens == nullptr)
+                    continue;
+
+                // the memoryless cases are all the release before the optimisations could do
+                const auto golden = goldens->find (name);
+
+                if (golden == goldens->end())
+                    checks.add ("golden", subject, false, "no golden render");
+                else
+                    checks.addDecibels ("golden", subject + " double", compare (summaries[name], golden->second, getEpsilon (Precision::full)),
+                                        testCase.isMemoryless() ? baselineDecibels : goldenDecibels);
+            }
+        }
+    }
+}
+
+//==============================================================================
+void runVerification (const ArgumentList& args)
+{
+    MemoryBlock goldenData (BinaryData::Golden_bin, (size_t) BinaryData::Golden_binSize);
+
+    if (args.containsOption ("--golden"))
+    {
+        const auto file = File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--golden"));
+
+        if (! file.loadFileAsData (goldenData))
+            ConsoleApplication::fail ("can't read " + file.getFullPathName());
+    }
+
+    Checks checks (args.containsOption ("--verbose"));
+    const auto corpus = makeCorpus();
+    const auto writeGoldenRenders = args.containsOption ("--write-golden");
+    const auto goldens = readGoldens (goldenData.getData(), goldenData.getSize());
+    Goldens summaries;
+
+    std::cout << "instruction set " << Dsp::getIsaName (Dsp::detectIsa()) << std::endl;
+
+    checkKernels (corpus, checks);
+    checkRenders (corpus, writeGoldenRenders ? nullptr : &goldens, summaries, checks);
+
+    std::cout << checks.numChecks << " checks, " << checks.numFailed << " failed" << std::endl;
+
+    if (writeGoldenRenders)
+    {
+        const auto file = File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--write-golden"));
+
+        if (! writeGoldens (file, summaries))
+            ConsoleApplication::fail ("can't write " + file.getFullPathName());
+
+        std::cout << "golden renders written to " << file.getFullPathName() << std::endl;
+    }
+
+    if (checks.numFailed > 0)
+        ConsoleApplication::fail ("verification failed");
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/WaveShaper.h"
+
+//==============================================================================
+/*  Checks that the optimised processing still sounds the same, for InflationBenchmark --verify.
+
+    A fixed corpus of signals (sines, a sweep, noise, transients, DC, full scale and
+    over full scale) goes through every mode at every precision, and is checked:
+
+        reference   against the polynomial evaluated plainly in long double, where the
+                    chain has no filters (no oversampling, band split or limiter)
+        kernels     the Pipeline's vector non-linear kernels against shapeReference()
+        blocks      the same render in host blocks of other sizes, which may only differ
+                    where a sample lands in a kernel's scalar tail
+        precision   float and mixed precision against double
+        golden      against the golden renders in Golden/Golden.bin, built into the tool, or
+                    those stored by an earlier run with --write-golden: the memoryless cases
+                    as the release before the optimisations rendered them, the others as the
+                    scalar kernels did when they were added
+
+    Prints one line per failed check (every check with --verbose) and a summary, and
+    fails the command, so it exits non-zero, if any check failed.
+*/
+void runVerification (const ArgumentList& args);
+
+/** The polynomial as a plain C++ loop, which the Pipeline's non-linear kernels are checked
+    and timed against. */
+template <typename FloatType>
+void shapeReference (FloatType* data, int numSamples, const Dsp::ShaperCoefficients<FloatType>& coefficients) noexcept
+{
+    for (auto i = 0; i < numSamples; ++i)
+        data[i] = coefficients.apply (data[i]);
+}